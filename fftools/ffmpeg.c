@@ -327,6 +327,8 @@ static void ffmpeg_cleanup(int ret)
         dec_free(&decoders[i]);
     av_freep(&decoders);
 
+    av_thread_pool_free(&codec_thread_pool);
+
     if (vstats_file) {
         if (fclose(vstats_file))
             av_log(NULL, AV_LOG_ERROR,
@@ -47,6 +47,7 @@
 #include "libavutil/rational.h"
 #include "libavutil/thread.h"
 #include "libavutil/threadmessage.h"
+#include "libavutil/threadpool.h"
 
 #include "libswresample/swresample.h"
 
@@ -718,6 +719,7 @@ extern float max_error_rate;
 
 extern char *filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern AVThreadPool *codec_thread_pool;
 extern int vstats_version;
 extern int auto_conversion_filters;
 
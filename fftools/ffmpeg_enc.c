@@ -327,6 +327,8 @@ int enc_open(void *opaque, const AVFrame *frame)
 
     enc_ctx->flags |= AV_CODEC_FLAG_FRAME_DURATION;
 
+    enc_ctx->thread_pool = codec_thread_pool;
+
     ret = hw_device_setup_for_encode(e, enc_ctx, frame ? frame->hw_frames_ctx : NULL);
     if (ret < 0) {
         av_log(e, AV_LOG_ERROR,
@@ -826,6 +826,109 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+/**
+ * Run the quantizer and coding tool searches of one channel element.
+ * Each thread works on its own context (see alloc_thread_context()), so the
+ * scratch buffers and the PNS noise state never leak from one element to
+ * another.
+ */
+static int search_channel_element(AVCodecContext *avctx, void *arg,
+                                  int jobnr, int threadnr)
+{
+    AACEncContext *s = avctx->priv_data;
+    AACEncContext *t = s->thread[threadnr];
+    ChannelElement *cpe = &s->cpe[jobnr];
+    const FFPsyWindowInfo *wi = arg;
+    const int tag   = s->chan_map[jobnr + 1];
+    const int chans = tag == TYPE_CPE ? 2 : 1;
+    SingleChannelElement *sce;
+    int i, ch, w, start_ch = 0, pred_mode = 0;
+
+    for (i = 0; i < jobnr; i++)
+        start_ch += s->chan_map[i + 1] == TYPE_CPE ? 2 : 1;
+    wi += start_ch;
+
+    t->psy.bitres.alloc = cpe->bitres_alloc;
+    t->random_state     = cpe->random_state;
+    t->cur_type         = tag;
+    for (ch = 0; ch < chans; ch++) {
+        t->cur_channel = start_ch + ch;
+        if (t->options.pns && t->coder->mark_pns)
+            t->coder->mark_pns(t, avctx, &cpe->ch[ch]);
+        t->coder->search_for_quantizers(avctx, t, &cpe->ch[ch], t->lambda);
+    }
+    if (chans > 1
+        && wi[0].window_type[0] == wi[1].window_type[0]
+        && wi[0].window_shape   == wi[1].window_shape) {
+
+        cpe->common_window = 1;
+        for (w = 0; w < wi[0].num_windows; w++) {
+            if (wi[0].grouping[w] != wi[1].grouping[w]) {
+                cpe->common_window = 0;
+                break;
+            }
+        }
+    }
+    for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
+        sce = &cpe->ch[ch];
+        t->cur_channel = start_ch + ch;
+        if (t->options.tns && t->coder->search_for_tns)
+            t->coder->search_for_tns(t, sce);
+        if (t->options.tns && t->coder->apply_tns_filt)
+            t->coder->apply_tns_filt(t, sce);
+        if (t->options.pns && t->coder->search_for_pns)
+            t->coder->search_for_pns(t, avctx, sce);
+    }
+    t->cur_channel = start_ch;
+    if (t->options.intensity_stereo) { /* Intensity Stereo */
+        if (t->coder->search_for_is)
+            t->coder->search_for_is(t, avctx, cpe);
+        apply_intensity_stereo(cpe);
+    }
+    if (t->options.pred) { /* Prediction */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            t->cur_channel = start_ch + ch;
+            if (t->coder->search_for_pred)
+                t->coder->search_for_pred(t, sce);
+            if (sce->ics.predictor_present) pred_mode = 1;
+        }
+        if (t->coder->adjust_common_pred)
+            t->coder->adjust_common_pred(t, cpe);
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            t->cur_channel = start_ch + ch;
+            if (t->coder->apply_main_pred)
+                t->coder->apply_main_pred(t, sce);
+        }
+        t->cur_channel = start_ch;
+    }
+    if (t->options.mid_side) { /* Mid/Side stereo */
+        if (t->options.mid_side == -1 && t->coder->search_for_ms)
+            t->coder->search_for_ms(t, cpe);
+        else if (cpe->common_window)
+            memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
+        apply_mid_side_stereo(cpe);
+    }
+    adjust_frame_information(cpe, chans);
+    if (t->options.ltp) { /* LTP */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            t->cur_channel = start_ch + ch;
+            if (t->coder->search_for_ltp)
+                t->coder->search_for_ltp(t, sce, cpe->common_window);
+            if (sce->ics.ltp.present) pred_mode = 1;
+        }
+        t->cur_channel = start_ch;
+        if (t->coder->adjust_common_ltp)
+            t->coder->adjust_common_ltp(t, cpe);
+    }
+    cpe->random_state = t->random_state;
+
+    /* Whether the coefficients were altered by a predictor */
+    return pred_mode;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -837,7 +940,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int i, its, ch, w, chans, tag, start_ch, ret, frame_bits;
     int target_bits, rate_bits, too_many_bits, too_few_bits;
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
-    int chan_el_counter[4];
+    int chan_el_counter[4], el_pred_mode[AAC_MAX_CHANNELS];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
 
     /* add current frame to queue */
@@ -961,7 +1064,8 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             put_bitstream_info(s, LIBAVCODEC_IDENT);
         start_ch = 0;
         target_bits = 0;
-        memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        /* Psy analysis keeps a running PE estimate across channel elements,
+         * so it is done serially, in bitstream order. */
         for (i = 0; i < s->chan_map[0]; i++) {
             FFPsyWindowInfo* wi = windows + start_ch;
             const float *coeffs[2];
@@ -971,8 +1075,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -994,82 +1096,36 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
-            s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
-            if (chans > 1
-                && wi[0].window_type[0] == wi[1].window_type[0]
-                && wi[0].window_shape   == wi[1].window_shape) {
-
-                cpe->common_window = 1;
-                for (w = 0; w < wi[0].num_windows; w++) {
-                    if (wi[0].grouping[w] != wi[1].grouping[w]) {
-                        cpe->common_window = 0;
-                        break;
-                    }
-                }
-            }
-            for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
-                sce = &cpe->ch[ch];
-                s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
-                    s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
-                    s->coder->apply_tns_filt(s, sce);
-                if (sce->tns.present)
+            cpe->bitres_alloc = s->psy.bitres.alloc;
+            start_ch += chans;
+        }
+
+        /* The coefficient searches only touch their own channel element */
+        for (i = 1; i < avctx->thread_count && s->thread[i]; i++) {
+            s->thread[i]->lambda     = s->lambda;
+            s->thread[i]->psy.cutoff = s->psy.cutoff;
+        }
+        avctx->execute2(avctx, search_channel_element, windows, el_pred_mode,
+                        s->chan_map[0]);
+        for (i = 1; i < avctx->thread_count && s->thread[i]; i++)
+            if (s->thread[i]->psy.cutoff)
+                s->psy.cutoff = s->thread[i]->psy.cutoff;
+
+        start_ch = 0;
+        memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        for (i = 0; i < s->chan_map[0]; i++) {
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
+            for (ch = 0; ch < chans; ch++)
+                if (cpe->ch[ch].tns.present)
                     tns_mode = 1;
-                if (s->options.pns && s->coder->search_for_pns)
-                    s->coder->search_for_pns(s, avctx, sce);
-            }
-            s->cur_channel = start_ch;
-            if (s->options.intensity_stereo) { /* Intensity Stereo */
-                if (s->coder->search_for_is)
-                    s->coder->search_for_is(s, avctx, cpe);
-                if (cpe->is_mode) is_mode = 1;
-                apply_intensity_stereo(cpe);
-            }
-            if (s->options.pred) { /* Prediction */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->search_for_pred)
-                        s->coder->search_for_pred(s, sce);
-                    if (cpe->ch[ch].ics.predictor_present) pred_mode = 1;
-                }
-                if (s->coder->adjust_common_pred)
-                    s->coder->adjust_common_pred(s, cpe);
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->apply_main_pred)
-                        s->coder->apply_main_pred(s, sce);
-                }
-                s->cur_channel = start_ch;
-            }
-            if (s->options.mid_side) { /* Mid/Side stereo */
-                if (s->options.mid_side == -1 && s->coder->search_for_ms)
-                    s->coder->search_for_ms(s, cpe);
-                else if (cpe->common_window)
-                    memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
-                apply_mid_side_stereo(cpe);
-            }
-            adjust_frame_information(cpe, chans);
-            if (s->options.ltp) { /* LTP */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->coder->search_for_ltp)
-                        s->coder->search_for_ltp(s, sce, cpe->common_window);
-                    if (sce->ics.ltp.present) pred_mode = 1;
-                }
-                s->cur_channel = start_ch;
-                if (s->coder->adjust_common_ltp)
-                    s->coder->adjust_common_ltp(s, cpe);
-            }
+            if (s->options.intensity_stereo && cpe->is_mode)
+                is_mode = 1;
+            if (el_pred_mode[i])
+                pred_mode = 1;
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             if (chans == 2) {
                 put_bits(&s->pb, 1, cpe->common_window);
                 if (cpe->common_window) {
@@ -1193,6 +1249,12 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     av_tx_uninit(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    for (int i = 1; s->thread && i < avctx->thread_count; i++) {
+        if (s->thread[i])
+            ff_lpc_end(&s->thread[i]->lpc);
+        av_freep(&s->thread[i]);
+    }
+    av_freep(&s->thread);
     if (s->psypp)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
@@ -1234,6 +1296,44 @@ static av_cold int alloc_buffers(AVCodecContext *avctx, AACEncContext *s)
     return 0;
 }
 
+/**
+ * Allocate the context of an additional channel element search thread.
+ * Only the fields read by the searches are set, the rest stays zeroed so
+ * that nothing else is shared with the main context by accident: the
+ * options and stream parameters, the DSP functions and the input samples
+ * (read only), the psy band data (each element only reads its own
+ * channels), and a private LPC context and band cost cache. lambda,
+ * psy.cutoff, psy.bitres.alloc, random_state and cur_* are set for every
+ * frame and element.
+ */
+static av_cold int alloc_thread_context(AVCodecContext *avctx, AACEncContext *s,
+                                        AACEncContext **tp)
+{
+    AACEncContext *t = *tp = av_mallocz(sizeof(*t));
+    int ret;
+
+    if (!t)
+        return AVERROR(ENOMEM);
+
+    t->options          = s->options;
+    t->profile          = s->profile;
+    t->samplerate_index = s->samplerate_index;
+    t->coder            = s->coder;
+    t->fdsp             = s->fdsp;
+    t->aacdsp           = s->aacdsp;
+    memcpy(t->planar_samples, s->planar_samples, sizeof(t->planar_samples));
+    t->psy.ch           = s->psy.ch;
+    t->psy.cutoff       = s->psy.cutoff;
+    t->lambda           = s->lambda;
+
+    if ((ret = ff_lpc_init(&t->lpc, 2*avctx->frame_size,
+                           TNS_MAX_ORDER, FF_LPC_TYPE_LEVINSON)) < 0)
+        return ret;
+    ff_quantize_band_cost_cache_init(t);
+
+    return 0;
+}
+
 static av_cold int aac_encode_init(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
@@ -1380,10 +1480,20 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
         return ret;
     s->psypp = ff_psy_preprocess_init(avctx);
     ff_lpc_init(&s->lpc, 2*avctx->frame_size, TNS_MAX_ORDER, FF_LPC_TYPE_LEVINSON);
-    s->random_state = 0x1f2e3d4c;
+    for (i = 0; i < s->chan_map[0]; i++)
+        s->cpe[i].random_state = 0x1f2e3d4c;
 
     ff_aacenc_dsp_init(&s->aacdsp);
 
+    if (!(s->thread = av_calloc(avctx->thread_count, sizeof(*s->thread))))
+        return AVERROR(ENOMEM);
+    s->thread[0] = s;
+    if (avctx->active_thread_type == FF_THREAD_SLICE) {
+        for (i = 1; i < avctx->thread_count; i++)
+            if ((ret = alloc_thread_context(avctx, s, &s->thread[i])) < 0)
+                return ret;
+    }
+
     ff_af_queue_init(avctx, &s->afq);
 
     return 0;
@@ -1424,7 +1534,8 @@ const FFCodec ff_aac_encoder = {
     .p.type         = AVMEDIA_TYPE_AUDIO,
     .p.id           = AV_CODEC_ID_AAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                      AV_CODEC_CAP_SMALL_LAST_FRAME,
+                      AV_CODEC_CAP_SMALL_LAST_FRAME |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(AACEncContext),
     .init           = aac_encode_init,
     FF_CODEC_ENCODE_CB(aac_encode_frame),
@@ -154,6 +154,8 @@ typedef struct ChannelElement {
     uint8_t is_mode;          ///< Set if any bands have been encoded using intensity stereo
     uint8_t ms_mask[128];     ///< Set if mid/side stereo is used for each scalefactor window band
     uint8_t is_mask[128];     ///< Set if intensity stereo is used
+    int bitres_alloc;         ///< psy bit reservoir allocation for each channel of the element
+    int random_state;         ///< PNS noise generator state
     // shared
     SingleChannelElement ch[2];
 } ChannelElement;
@@ -250,6 +252,8 @@ typedef struct AACEncContext {
 
     AACEncDSPContext aacdsp;
 
+    struct AACEncContext **thread;               ///< per-thread contexts for the channel element search, thread[0] is the main context
+
     struct {
         float *samples;
     } buffer;
@@ -630,15 +630,14 @@ static av_cold void exponent_init(void)
 
 
 /*
- * Extract exponents from the MDCT coefficients.
+ * Extract exponents from the MDCT coefficients of one channel.
  */
-static void extract_exponents(AC3EncodeContext *s)
+static void extract_exponents(AC3EncodeContext *s, int ch)
 {
-    int ch        = !s->cpl_on;
-    int chan_size = AC3_MAX_COEFS * s->num_blocks * (s->channels - ch + 1);
     AC3Block *block = &s->blocks[0];
 
-    s->ac3dsp.extract_exponents(block->exp[ch], block->fixed_coef[ch], chan_size);
+    s->ac3dsp.extract_exponents(block->exp[ch], block->fixed_coef[ch],
+                                AC3_MAX_COEFS * s->num_blocks);
 }
 
 
@@ -659,14 +658,18 @@ static const uint8_t exp_strategy_reuse_tab[4][6] = {
 };
 
 /*
- * Calculate exponent strategies for all channels.
+ * Calculate exponent strategies for one channel.
  * Array arrangement is reversed to simplify the per-channel calculation.
  */
-static void compute_exp_strategy(AC3EncodeContext *s)
+static void compute_exp_strategy(AC3EncodeContext *s, int ch)
 {
-    int ch, blk, blk1;
+    int blk, blk1;
 
-    for (ch = !s->cpl_on; ch <= s->fbw_channels; ch++) {
+    if (ch == s->lfe_channel) {
+        s->exp_strategy[ch][0] = EXP_D15;
+        for (blk = 1; blk < s->num_blocks; blk++)
+            s->exp_strategy[ch][blk] = EXP_REUSE;
+    } else {
         uint8_t *exp_strategy = s->exp_strategy[ch];
         uint8_t *exp          = s->blocks[0].exp[ch];
         int exp_diff;
@@ -707,16 +710,6 @@ static void compute_exp_strategy(AC3EncodeContext *s)
             blk = blk1;
         }
     }
-    if (s->lfe_on) {
-        ch = s->lfe_channel;
-        s->exp_strategy[ch][0] = EXP_D15;
-        for (blk = 1; blk < s->num_blocks; blk++)
-            s->exp_strategy[ch][blk] = EXP_REUSE;
-    }
-
-    /* for E-AC-3, determine frame exponent strategy */
-    if (CONFIG_EAC3_ENCODER && s->eac3)
-        ff_eac3_get_frame_exp_strategy(s);
 }
 
 
@@ -796,55 +789,48 @@ static void encode_exponents_blk_ch(uint8_t *exp, int nb_exps, int exp_strategy,
 
 
 /*
- * Encode exponents from original extracted form to what the decoder will see.
+ * Encode the exponents of one channel from original extracted form to what
+ * the decoder will see.
  * This copies and groups exponents based on exponent strategy and reduces
  * deltas between adjacent exponent groups so that they can be differentially
  * encoded.
  */
-static void encode_exponents(AC3EncodeContext *s)
+static void encode_exponents(AC3EncodeContext *s, int ch)
 {
-    int blk, blk1, ch, cpl;
-    uint8_t *exp, *exp_strategy;
+    uint8_t *exp               = s->blocks[0].exp[ch] + s->start_freq[ch];
+    const uint8_t *exp_strategy = s->exp_strategy[ch];
+    int cpl = (ch == CPL_CH);
+    int blk = 0, blk1;
     int nb_coefs, num_reuse_blocks;
 
-    for (ch = !s->cpl_on; ch <= s->channels; ch++) {
-        exp          = s->blocks[0].exp[ch] + s->start_freq[ch];
-        exp_strategy = s->exp_strategy[ch];
-
-        cpl = (ch == CPL_CH);
-        blk = 0;
-        while (blk < s->num_blocks) {
-            AC3Block *block = &s->blocks[blk];
-            if (cpl && !block->cpl_in_use) {
-                exp += AC3_MAX_COEFS;
-                blk++;
-                continue;
-            }
-            nb_coefs = block->end_freq[ch] - s->start_freq[ch];
-            blk1 = blk + 1;
+    while (blk < s->num_blocks) {
+        AC3Block *block = &s->blocks[blk];
+        if (cpl && !block->cpl_in_use) {
+            exp += AC3_MAX_COEFS;
+            blk++;
+            continue;
+        }
+        nb_coefs = block->end_freq[ch] - s->start_freq[ch];
+        blk1 = blk + 1;
 
-            /* count the number of EXP_REUSE blocks after the current block
-               and set exponent reference block numbers */
-            s->exp_ref_block[ch][blk] = blk;
-            while (blk1 < s->num_blocks && exp_strategy[blk1] == EXP_REUSE) {
-                s->exp_ref_block[ch][blk1] = blk;
-                blk1++;
-            }
-            num_reuse_blocks = blk1 - blk - 1;
+        /* count the number of EXP_REUSE blocks after the current block
+           and set exponent reference block numbers */
+        s->exp_ref_block[ch][blk] = blk;
+        while (blk1 < s->num_blocks && exp_strategy[blk1] == EXP_REUSE) {
+            s->exp_ref_block[ch][blk1] = blk;
+            blk1++;
+        }
+        num_reuse_blocks = blk1 - blk - 1;
 
-            /* for the EXP_REUSE case we select the min of the exponents */
-            s->ac3dsp.ac3_exponent_min(exp-s->start_freq[ch], num_reuse_blocks,
-                                       AC3_MAX_COEFS);
+        /* for the EXP_REUSE case we select the min of the exponents */
+        s->ac3dsp.ac3_exponent_min(exp-s->start_freq[ch], num_reuse_blocks,
+                                   AC3_MAX_COEFS);
 
-            encode_exponents_blk_ch(exp, nb_coefs, exp_strategy[blk], cpl);
+        encode_exponents_blk_ch(exp, nb_coefs, exp_strategy[blk], cpl);
 
-            exp += AC3_MAX_COEFS * (num_reuse_blocks + 1);
-            blk = blk1;
-        }
+        exp += AC3_MAX_COEFS * (num_reuse_blocks + 1);
+        blk = blk1;
     }
-
-    /* reference block numbers have been changed, so reset ref_bap_set */
-    s->ref_bap_set = 0;
 }
 
 
@@ -934,6 +920,30 @@ static void ac3_group_exponents(AC3EncodeContext *s)
 }
 
 
+/*
+ * Extract exponents from the MDCT coefficients of one channel, calculate its
+ * exponent strategies and encode its final exponents.
+ * Channels are independent of each other here, so they are processed in
+ * parallel.
+ */
+static int process_exponents_ch(AVCodecContext *avctx, void *arg,
+                                int jobnr, int threadnr)
+{
+    AC3EncodeContext *s = avctx->priv_data;
+    int ch = jobnr + !s->cpl_on;
+
+    extract_exponents(s, ch);
+
+    compute_exp_strategy(s, ch);
+
+    encode_exponents(s, ch);
+
+    emms_c();
+
+    return 0;
+}
+
+
 /**
  * Calculate final exponents from the supplied MDCT coefficients and exponent shift.
  * Extract exponents from MDCT coefficients, calculate exponent strategies,
@@ -943,13 +953,15 @@ static void ac3_group_exponents(AC3EncodeContext *s)
  */
 static void ac3_process_exponents(AC3EncodeContext *s)
 {
-    extract_exponents(s);
-
-    compute_exp_strategy(s);
+    s->avctx->execute2(s->avctx, process_exponents_ch, NULL, NULL,
+                       s->channels + s->cpl_on);
 
-    encode_exponents(s);
+    /* for E-AC-3, determine frame exponent strategy */
+    if (CONFIG_EAC3_ENCODER && s->eac3)
+        ff_eac3_get_frame_exp_strategy(s);
 
-    emms_c();
+    /* reference block numbers have been changed, so reset ref_bap_set */
+    s->ref_bap_set = 0;
 }
 
 
@@ -1242,16 +1254,18 @@ static void count_frame_bits(AC3EncodeContext *s)
 
 
 /*
- * Calculate masking curve based on the final exponents.
+ * Calculate masking curve of one channel based on the final exponents.
  * Also calculate the power spectral densities to use in future calculations.
  */
-static void bit_alloc_masking(AC3EncodeContext *s)
+static int bit_alloc_masking_ch(AVCodecContext *avctx, void *arg,
+                                int jobnr, int threadnr)
 {
-    int blk, ch;
+    AC3EncodeContext *s = avctx->priv_data;
+    int ch = jobnr + !s->cpl_on;
 
-    for (blk = 0; blk < s->num_blocks; blk++) {
+    for (int blk = 0; blk < s->num_blocks; blk++) {
         AC3Block *block = &s->blocks[blk];
-        for (ch = !block->cpl_in_use; ch <= s->channels; ch++) {
+        if (ch != CPL_CH || block->cpl_in_use) {
             /* We only need psd and mask for calculating bap.
                Since we currently do not calculate bap when exponent
                strategy is EXP_REUSE we do not need to calculate psd or mask. */
@@ -1268,6 +1282,8 @@ static void bit_alloc_masking(AC3EncodeContext *s)
             }
         }
     }
+
+    return 0;
 }
 
 
@@ -1456,7 +1472,8 @@ static int ac3_compute_bit_allocation(AC3EncodeContext *s)
 
     s->exponent_bits = count_exponent_bits(s);
 
-    bit_alloc_masking(s);
+    s->avctx->execute2(s->avctx, bit_alloc_masking_ch, NULL, NULL,
+                       s->channels + s->cpl_on);
 
     return cbr_bit_allocation(s);
 }
@@ -2174,7 +2191,8 @@ av_cold int ff_ac3_encode_close(AVCodecContext *avctx)
     av_freep(&s->cpl_coord_buffer);
     av_freep(&s->fdsp);
 
-    av_tx_uninit(&s->tx);
+    for (int ch = 0; ch < FF_ARRAY_ELEMS(s->tx); ch++)
+        av_tx_uninit(&s->tx[ch]);
 
     return 0;
 }
@@ -167,7 +167,7 @@ typedef struct AC3EncodeContext {
 #endif
     MECmpContext mecc;
     AC3DSPContext ac3dsp;                   ///< AC-3 optimized functions
-    AVTXContext *tx;                        ///< FFT context for MDCT calculation
+    AVTXContext *tx[AC3_MAX_CHANNELS - 1];  ///< per-channel FFT contexts for MDCT calculation
     av_tx_fn tx_fn;
 
     AC3Block blocks[AC3_MAX_BLOCKS];        ///< per-block info
@@ -263,8 +263,8 @@ typedef struct AC3EncodeContext {
         DECLARE_ALIGNED(32, int32_t, mdct_window_fixed)[AC3_BLOCK_SIZE];
     };
     union {
-        DECLARE_ALIGNED(32, float,   windowed_samples_float)[AC3_WINDOW_SIZE];
-        DECLARE_ALIGNED(32, int32_t, windowed_samples_fixed)[AC3_WINDOW_SIZE];
+        DECLARE_ALIGNED(32, float,   windowed_samples_float)[AC3_MAX_CHANNELS - 1][AC3_WINDOW_SIZE];
+        DECLARE_ALIGNED(32, int32_t, windowed_samples_fixed)[AC3_MAX_CHANNELS - 1][AC3_WINDOW_SIZE];
     };
 } AC3EncodeContext;
 
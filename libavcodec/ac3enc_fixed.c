@@ -88,8 +88,15 @@ static av_cold int ac3_fixed_mdct_init(AVCodecContext *avctx, AC3EncodeContext *
     if (!s->fdsp)
         return AVERROR(ENOMEM);
 
-    return av_tx_init(&s->tx, &s->tx_fn, AV_TX_INT32_MDCT, 0,
-                      AC3_BLOCK_SIZE, &scale, 0);
+    /* one context per channel, so that channels can be transformed in parallel */
+    for (int ch = 0; ch < FFMIN(avctx->ch_layout.nb_channels, AC3_MAX_CHANNELS - 1); ch++) {
+        int ret = av_tx_init(&s->tx[ch], &s->tx_fn, AV_TX_INT32_MDCT, 0,
+                             AC3_BLOCK_SIZE, &scale, 0);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
 }
 
 
@@ -114,7 +121,8 @@ const FFCodec ff_ac3_fixed_encoder = {
     CODEC_LONG_NAME("ATSC A/52A (AC-3)"),
     .p.type          = AVMEDIA_TYPE_AUDIO,
     .p.id            = AV_CODEC_ID_AC3,
-    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
+    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size  = sizeof(AC3EncodeContext),
     .init            = ac3_fixed_encode_init,
     FF_CODEC_ENCODE_CB(ff_ac3_encode_frame),
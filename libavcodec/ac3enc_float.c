@@ -83,14 +83,21 @@ static void sum_square_butterfly(AC3EncodeContext *s, float sum[4],
  * @param s  AC-3 encoder private context
  * @return   0 on success, negative error code on failure
  */
-static av_cold int ac3_float_mdct_init(AC3EncodeContext *s)
+static av_cold int ac3_float_mdct_init(AVCodecContext *avctx, AC3EncodeContext *s)
 {
     const float scale = -2.0 / AC3_WINDOW_SIZE;
 
     ff_kbd_window_init(s->mdct_window_float, 5.0, AC3_BLOCK_SIZE);
 
-    return av_tx_init(&s->tx, &s->tx_fn, AV_TX_FLOAT_MDCT, 0,
-                      AC3_BLOCK_SIZE, &scale, 0);
+    /* one context per channel, so that channels can be transformed in parallel */
+    for (int ch = 0; ch < FFMIN(avctx->ch_layout.nb_channels, AC3_MAX_CHANNELS - 1); ch++) {
+        int ret = av_tx_init(&s->tx[ch], &s->tx_fn, AV_TX_FLOAT_MDCT, 0,
+                             AC3_BLOCK_SIZE, &scale, 0);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
 }
 
 
@@ -104,7 +111,7 @@ av_cold int ff_ac3_float_encode_init(AVCodecContext *avctx)
     if (!s->fdsp)
         return AVERROR(ENOMEM);
 
-    ret = ac3_float_mdct_init(s);
+    ret = ac3_float_mdct_init(avctx, s);
     if (ret < 0)
         return ret;
 
@@ -116,7 +123,8 @@ const FFCodec ff_ac3_encoder = {
     CODEC_LONG_NAME("ATSC A/52A (AC-3)"),
     .p.type          = AVMEDIA_TYPE_AUDIO,
     .p.id            = AV_CODEC_ID_AC3,
-    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
+    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size  = sizeof(AC3EncodeContext),
     .init            = ff_ac3_float_encode_init,
     FF_CODEC_ENCODE_CB(ff_ac3_encode_frame),
@@ -454,6 +454,7 @@ av_cold void ff_codec_close(AVCodecContext *avctx)
         av_frame_free(&avci->recon_frame);
 
         av_refstruct_unref(&avci->pool);
+        ff_frame_pool_cache_uninit(&avci->pool_cache);
         av_refstruct_pool_uninit(&avci->progress_frame_pool);
         if (av_codec_is_decoder(avctx->codec))
             ff_decode_internal_uninit(avctx);
@@ -755,6 +755,11 @@ typedef struct AVCodecContext {
      * at the same time; threads might draw different parts of the same AVFrame,
      * or multiple AVFrames, and there is no guarantee that slices will be drawn
      * in order.
+     * Decoders with in-loop filters (e.g. H.264, HEVC) pass a band only once
+     * all filters touching it have run, so the band contents are final when
+     * the callback is invoked. Every row of a picture is passed exactly once,
+     * but with slice threads (including HEVC wavefront parallel processing)
+     * the bands of a picture may arrive out of order.
      * The function is also used by hardware acceleration APIs.
      * It is called at least once during frame decoding to pass
      * the data needed for hardware render.
@@ -2146,6 +2151,54 @@ typedef struct AVCodecContext {
      */
     AVFrameSideData  **decoded_side_data;
     int             nb_decoded_side_data;
+
+    /**
+     * Keep the frame buffer pools of the default get_buffer2() implementation
+     * when the frame dimensions or format change. Buffers are grouped in size
+     * classes, so that a stream switching back and forth between resolutions
+     * reuses the buffers allocated before instead of reallocating them.
+     *
+     * - encoding: unused
+     * - decoding: Set by user before avcodec_open2().
+     */
+    int frame_pool_reuse;
+
+    /**
+     * Maximum total size in bytes of the frame buffers allocated by the
+     * default get_buffer2() implementation, including the buffers of all
+     * frame threads and those kept by frame_pool_reuse. Allocations beyond
+     * it fail with AVERROR(ENOMEM). 0 means no limit.
+     *
+     * - encoding: unused
+     * - decoding: Set by user before avcodec_open2().
+     */
+    int64_t frame_pool_max_bytes;
+
+    /**
+     * Number of frame plane buffers the default get_buffer2() implementation
+     * took from its pools without allocating them (hits) and had to allocate
+     * (misses), updated whenever a frame is returned.
+     *
+     * - encoding: unused
+     * - decoding: Set by libavcodec.
+     */
+    int64_t frame_pool_hits;
+    int64_t frame_pool_misses;
+
+    /**
+     * Thread pool to run the slice threading jobs on instead of creating
+     * threads for this context. The same pool can be set on any number of
+     * codec contexts, so that their jobs share the threads of the pool.
+     * thread_count still limits how many jobs of this context run at the
+     * same time. Frame threading is not affected and keeps its own threads,
+     * as do decoders running a main function alongside their slice jobs.
+     *
+     * Owned by the caller, must stay valid until the context is freed.
+     *
+     * - encoding: Set by user before avcodec_open2().
+     * - decoding: Set by user before avcodec_open2().
+     */
+    struct AVThreadPool *thread_pool;
 } AVCodecContext;
 
 /**
@@ -2843,6 +2896,13 @@ typedef struct AVCodecParserContext {
 #define PARSER_FLAG_ONCE                      0x0002
 /// Set if the parser has a valid file offset
 #define PARSER_FLAG_FETCHED_OFFSET            0x0004
+/**
+ * Only find frame boundaries and set key_frame and pict_type, for callers
+ * which copy the packets without decoding them.  Other fields, such as
+ * output_picture_number, repeat_pict, field_order or the dts_* ones, may
+ * be left unset.  Parsers which do not implement such a mode ignore it.
+ */
+#define PARSER_FLAG_BOUNDARIES_ONLY           0x0008
 #define PARSER_FLAG_USE_CODEC_TS              0x1000
 
     int64_t offset;      ///< byte offset from starting packet start
@@ -586,6 +586,27 @@ static int h264_metadata_init(AVBSFContext *bsf)
         }
     }
 
+    // Only the parameter sets need to be rewritten unless slices or SEI
+    // messages are looked at; the SEI syntax depends on the active
+    // parameter sets, so that case still decomposes everything.
+    if (!ctx->sei_user_data && !ctx->delete_filler &&
+        ctx->display_orientation == BSF_ELEMENT_PASS) {
+        static const CodedBitstreamUnitType sps_types[] = {
+            H264_NAL_SPS,
+        };
+        static const CodedBitstreamUnitType aud_types[] = {
+            H264_NAL_SPS, H264_NAL_PPS, H264_NAL_SLICE, H264_NAL_IDR_SLICE,
+        };
+
+        if (ctx->aud == BSF_ELEMENT_INSERT) {
+            ctx->common.decompose_unit_types    = aud_types;
+            ctx->common.nb_decompose_unit_types = FF_ARRAY_ELEMS(aud_types);
+        } else {
+            ctx->common.decompose_unit_types    = sps_types;
+            ctx->common.nb_decompose_unit_types = FF_ARRAY_ELEMS(sps_types);
+        }
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h264_metadata_type);
 }
 
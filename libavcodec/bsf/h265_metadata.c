@@ -489,6 +489,18 @@ static const CBSBSFType h265_metadata_type = {
 
 static int h265_metadata_init(AVBSFContext *bsf)
 {
+    H265MetadataContext *ctx = bsf->priv_data;
+    static const CodedBitstreamUnitType decompose_unit_types[] = {
+        HEVC_NAL_VPS, HEVC_NAL_SPS, HEVC_NAL_PPS,
+    };
+
+    // AUD insertion looks at the headers of all NAL units, otherwise
+    // only the parameter sets are used.
+    if (ctx->aud != BSF_ELEMENT_INSERT) {
+        ctx->common.decompose_unit_types    = decompose_unit_types;
+        ctx->common.nb_decompose_unit_types = FF_ARRAY_ELEMS(decompose_unit_types);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h265_metadata_type);
 }
 
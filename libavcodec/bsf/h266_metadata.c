@@ -116,6 +116,18 @@ static const CBSBSFType h266_metadata_type = {
 
 static int h266_metadata_init(AVBSFContext *bsf)
 {
+    H266MetadataContext *ctx = bsf->priv_data;
+    static const CodedBitstreamUnitType decompose_unit_types[] = {
+        VVC_AUD_NUT,
+    };
+
+    // AUD insertion looks at the headers of all NAL units, otherwise
+    // nothing but the AUD itself is used.
+    if (ctx->aud != BSF_ELEMENT_INSERT) {
+        ctx->common.decompose_unit_types    = decompose_unit_types;
+        ctx->common.nb_decompose_unit_types = FF_ARRAY_ELEMS(decompose_unit_types);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h266_metadata_type);
 }
 
@@ -55,6 +55,14 @@
 #   include "loongarch/cabac.h"
 #endif
 
+#if UNCHECKED_BITSTREAM_READER
+#define CABAC_ADVANCE(ptr, end) ((ptr) += CABAC_BITS / 8)
+#else
+/* The input buffer is padded, so reading past its end is harmless;
+ * only stop advancing there, without a branch. */
+#define CABAC_ADVANCE(ptr, end) ((ptr) += ((ptr) < (end)) * (CABAC_BITS / 8))
+#endif
+
 static const uint8_t * const ff_h264_norm_shift = ff_h264_cabac_tables + H264_NORM_SHIFT_OFFSET;
 static const uint8_t * const ff_h264_lps_range = ff_h264_cabac_tables + H264_LPS_RANGE_OFFSET;
 static const uint8_t * const ff_h264_mlps_state = ff_h264_cabac_tables + H264_MLPS_STATE_OFFSET;
@@ -68,10 +76,7 @@ static void refill(CABACContext *c){
         c->low+= c->bytestream[0]<<1;
 #endif
     c->low -= CABAC_MASK;
-#if !UNCHECKED_BITSTREAM_READER
-    if (c->bytestream < c->bytestream_end)
-#endif
-        c->bytestream += CABAC_BITS / 8;
+    CABAC_ADVANCE(c->bytestream, c->bytestream_end);
 }
 #endif
 
@@ -105,10 +110,7 @@ static void refill2(CABACContext *c){
 #endif
 
     c->low += x<<i;
-#if !UNCHECKED_BITSTREAM_READER
-    if (c->bytestream < c->bytestream_end)
-#endif
-        c->bytestream += CABAC_BITS/8;
+    CABAC_ADVANCE(c->bytestream, c->bytestream_end);
 }
 #endif
 
@@ -180,6 +182,46 @@ static av_always_inline int get_cabac_bypass_sign(CABACContext *c, int val){
 }
 #endif
 
+/**
+ * Decode n consecutive bypass bins, the first one ending up in the most
+ * significant bit of the result. The decoder state is kept in local
+ * variables for the whole run instead of going through the context for
+ * every bin.
+ * @param n number of bins, at most 31
+ */
+#ifndef get_cabac_bypass_bits
+static av_always_inline unsigned get_cabac_bypass_bits(CABACContext *c, int n)
+{
+    const uint8_t *ptr = c->bytestream;
+    const int range    = c->range << (CABAC_BITS + 1);
+    int low            = c->low;
+    unsigned val       = 0;
+
+    while (n-- > 0) {
+        int mask;
+
+        low += low;
+        if (!(low & CABAC_MASK)) {
+#if CABAC_BITS == 16
+            low += (ptr[0] << 9) + (ptr[1] << 1) - CABAC_MASK;
+#else
+            low += (ptr[0] << 1) - CABAC_MASK;
+#endif
+            CABAC_ADVANCE(ptr, c->bytestream_end);
+        }
+
+        low  -= range;
+        mask  = low >> 31;
+        low  += range & mask;
+        val   = (val << 1) + 1 + mask;
+    }
+
+    c->low        = low;
+    c->bytestream = ptr;
+    return val;
+}
+#endif
+
 /**
  * @return the number of bytes read or 0 if no end
  */
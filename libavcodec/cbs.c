@@ -191,22 +191,29 @@ av_cold void ff_cbs_fragment_free(CodedBitstreamFragment *frag)
     frag->nb_units_allocated = 0;
 }
 
+int ff_cbs_decompose_unit_type(const CodedBitstreamContext *ctx,
+                               CodedBitstreamUnitType type)
+{
+    if (!ctx->decompose_unit_types)
+        return 1;
+
+    for (int i = 0; i < ctx->nb_decompose_unit_types; i++) {
+        if (ctx->decompose_unit_types[i] == type)
+            return 1;
+    }
+    return 0;
+}
+
 static int cbs_read_fragment_content(CodedBitstreamContext *ctx,
                                      CodedBitstreamFragment *frag)
 {
-    int err, i, j;
+    int err, i;
 
     for (i = 0; i < frag->nb_units; i++) {
         CodedBitstreamUnit *unit = &frag->units[i];
 
-        if (ctx->decompose_unit_types) {
-            for (j = 0; j < ctx->nb_decompose_unit_types; j++) {
-                if (ctx->decompose_unit_types[j] == unit->type)
-                    break;
-            }
-            if (j >= ctx->nb_decompose_unit_types)
-                continue;
-        }
+        if (unit->passthrough || !ff_cbs_decompose_unit_type(ctx, unit->type))
+            continue;
 
         av_refstruct_unref(&unit->content_ref);
         unit->content = NULL;
@@ -418,7 +425,8 @@ int ff_cbs_write_fragment_data(CodedBitstreamContext *ctx,
             continue;
 
         av_buffer_unref(&unit->data_ref);
-        unit->data = NULL;
+        unit->data        = NULL;
+        unit->passthrough = 0;
 
         err = cbs_write_unit_data(ctx, unit);
         if (err < 0) {
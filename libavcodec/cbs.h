@@ -110,6 +110,17 @@ typedef struct CodedBitstreamUnit {
      * NULL if content is not reference counted.
      */
     void *content_ref;
+
+    /**
+     * Set if data is a reference to the unit exactly as it appeared in the
+     * input bitstream rather than its directly-parsable form (for H.264,
+     * H.265 and H.266 this means that emulation prevention bytes are still
+     * present).  Such units are never decomposed and are copied unchanged
+     * into the output when the fragment is written.
+     *
+     * This is used for units whose type is not in decompose_unit_types.
+     */
+    int passthrough;
 } CodedBitstreamUnit;
 
 /**
@@ -243,6 +254,10 @@ typedef struct CodedBitstreamContext {
      * Array of unit types which should be decomposed when reading.
      *
      * Types not in this list will be available in bitstream form only.
+     * For codecs which support it, they are then also passed through
+     * without any processing (see CodedBitstreamUnit.passthrough), so
+     * the cost of rewriting a fragment only depends on the units which
+     * were decomposed.
      * If NULL, all supported types will be decomposed.
      */
     const CodedBitstreamUnitType *decompose_unit_types;
@@ -57,6 +57,13 @@ typedef struct CBSBSFContext {
     CodedBitstreamContext *input;
     CodedBitstreamContext *output;
     CodedBitstreamFragment fragment;
+
+    // Unit types which update_fragment() needs to inspect or modify.
+    // All other units are passed through to the output unchanged without
+    // being parsed.  May be set before calling ff_cbs_bsf_generic_init();
+    // if NULL, every unit is decomposed.
+    const CodedBitstreamUnitType *decompose_unit_types;
+    int nb_decompose_unit_types;
 } CBSBSFContext;
 
 /**
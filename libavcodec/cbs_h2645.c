@@ -511,6 +511,32 @@ static int cbs_h2645_fragment_add_nals(CodedBitstreamContext *ctx,
             continue;
         }
 
+        if (!ff_cbs_decompose_unit_type(ctx, nal->type)) {
+            // Keep a reference to the escaped bitstream, so that the
+            // unit can be copied to the output as it is.  Trailing zeroes,
+            // including cabac_zero_words, are removed like in the
+            // unescaped case: an emulation prevention byte following two
+            // zeroes is dropped together with them.
+            size = nal->raw_size;
+            while (size > 0) {
+                if (nal->raw_data[size - 1] == 0)
+                    --size;
+                else if (size >= 3 && nal->raw_data[size - 1] == 3 &&
+                         nal->raw_data[size - 2] == 0 && nal->raw_data[size - 3] == 0)
+                    --size;
+                else
+                    break;
+            }
+
+            err = ff_cbs_append_unit_data(frag, nal->type,
+                                          (uint8_t*)nal->raw_data, size,
+                                          frag->data_ref);
+            if (err < 0)
+                return err;
+            frag->units[frag->nb_units - 1].passthrough = 1;
+            continue;
+        }
+
         ref = (nal->data == nal->raw_data) ? frag->data_ref
                                            : packet->rbsp.rbsp_buffer_ref;
 
@@ -1868,6 +1894,13 @@ static int cbs_h2645_assemble_fragment(CodedBitstreamContext *ctx,
         data[dp++] = 0;
         data[dp++] = 1;
 
+        if (unit->passthrough) {
+            // Already escaped.
+            memcpy(data + dp, unit->data, unit->data_size);
+            dp += unit->data_size;
+            continue;
+        }
+
         zero_run = 0;
         for (sp = 0; sp < unit->data_size; sp++) {
             if (zero_run < 2) {
@@ -153,6 +153,12 @@ typedef struct CodedBitstreamType {
 } CodedBitstreamType;
 
 
+// Returns whether units of the given type should be decomposed when
+// reading, according to CodedBitstreamContext.decompose_unit_types.
+int ff_cbs_decompose_unit_type(const CodedBitstreamContext *ctx,
+                               CodedBitstreamUnitType type);
+
+
 // Helper functions for trace output.
 
 void ff_cbs_trace_header(CodedBitstreamContext *ctx,
@@ -840,6 +840,10 @@ int ff_decode_receive_frame(AVCodecContext *avctx, AVFrame *frame)
 
     avctx->frame_num++;
 
+    if (avci->pool_cache)
+        ff_frame_pool_cache_stats(avci->pool_cache, &avctx->frame_pool_hits,
+                                  &avctx->frame_pool_misses);
+
 #if FF_API_DROPCHANGED
     if (avctx->flags & AV_CODEC_FLAG_DROPCHANGED) {
 
@@ -2045,6 +2049,12 @@ int ff_decode_preinit(AVCodecContext *avctx)
     if (!avci->in_pkt || !avci->last_pkt_props)
         return AVERROR(ENOMEM);
 
+    if (avctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+        ret = ff_frame_pool_cache_alloc(avctx);
+        if (ret < 0)
+            return ret;
+    }
+
     if (ffcodec(avctx->codec)->caps_internal & FF_CODEC_CAP_USES_PROGRESSFRAMES) {
         avci->progress_frame_pool =
             av_refstruct_pool_alloc_ext(sizeof(ProgressInternal),
@@ -74,6 +74,27 @@ int ff_decode_frame_props_from_pkt(const AVCodecContext *avctx,
  */
 int ff_decode_frame_props(AVCodecContext *avctx, AVFrame *frame);
 
+struct FramePoolCache;
+
+/**
+ * Allocate the state shared by all frame pools of the default get_buffer2()
+ * implementation and store it in avctx->internal->pool_cache.
+ */
+int ff_frame_pool_cache_alloc(AVCodecContext *avctx);
+
+/**
+ * Release the pools kept by the cache and unreference it. Only to be called
+ * by the owner, frame threads just unreference it.
+ */
+void ff_frame_pool_cache_uninit(struct FramePoolCache **cache);
+
+/**
+ * Get the number of plane buffers that were reused from / newly allocated
+ * for the frame pools.
+ */
+void ff_frame_pool_cache_stats(const struct FramePoolCache *cache,
+                               int64_t *hits, int64_t *misses);
+
 /**
  * Make sure avctx.hw_frames_ctx is set. If it's not set, the function will
  * try to allocate it from hw_device_ctx. If that is not possible, an error
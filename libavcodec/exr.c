@@ -243,10 +243,8 @@ static int rle(uint8_t *dst, const uint8_t *src,
                 (ssize -= 2) < 0)
                 return AVERROR_INVALIDDATA;
 
-            while (count--)
-                *d++ = *s;
-
-            s++;
+            memset(d, *s++, count);
+            d += count;
         }
     }
 
@@ -818,7 +816,7 @@ static int b44_uncompress(const EXRContext *s, const uint8_t *src, int compresse
     const int8_t *sr = src;
     int stay_to_uncompress = compressed_size;
     int nb_b44_block_w, nb_b44_block_h;
-    int index_tl_x, index_tl_y, index_out, index_tmp;
+    int index_tl_x, index_tl_y, index_out, block_w, block_h;
     uint16_t tmp_buffer[16]; /* B44 use 4x4 half float pixel */
     int c, iY, iX, y, x;
     int target_channel_offset = 0;
@@ -854,14 +852,16 @@ static int b44_uncompress(const EXRContext *s, const uint8_t *src, int compresse
                     /* copy data to uncompress buffer (B44 block can exceed target resolution)*/
                     index_tl_x = iX * 4;
                     index_tl_y = iY * 4;
+                    block_w    = FFMIN(4, td->xsize - index_tl_x);
+                    block_h    = FFMIN(4, td->ysize - index_tl_y);
+                    index_out  = target_channel_offset * td->xsize +
+                                 index_tl_y * td->channel_line_size + 2 * index_tl_x;
 
-                    for (y = index_tl_y; y < FFMIN(index_tl_y + 4, td->ysize); y++) {
-                        for (x = index_tl_x; x < FFMIN(index_tl_x + 4, td->xsize); x++) {
-                            index_out = target_channel_offset * td->xsize + y * td->channel_line_size + 2 * x;
-                            index_tmp = (y-index_tl_y) * 4 + (x-index_tl_x);
-                            td->uncompressed_data[index_out] = tmp_buffer[index_tmp] & 0xff;
-                            td->uncompressed_data[index_out + 1] = tmp_buffer[index_tmp] >> 8;
-                        }
+                    for (y = 0; y < block_h; y++) {
+                        uint8_t *out = td->uncompressed_data + index_out + y * td->channel_line_size;
+
+                        for (x = 0; x < block_w; x++)
+                            AV_WL16(out + 2 * x, tmp_buffer[y * 4 + x]);
                     }
                 }
             }
@@ -960,6 +960,23 @@ static void dct_inverse(float *block)
     }
 }
 
+/**
+ * dct_inverse() of a block with only a DC coefficient, which is the same
+ * value everywhere. Zero and non-finite results are left to dct_inverse(),
+ * as the signs of their outputs differ.
+ * @return 1 if block[0] was set to the value of all the outputs
+ */
+static int dct_inverse_dc(float *block)
+{
+    const float a = .5f * cosf(M_PI / 4.f);
+    const float v = a * (a * (block[0] + 0.f) + 0.f) + 0.f;
+
+    if (v == 0.f || !isfinite(v))
+        return 0;
+    block[0] = v;
+    return 1;
+}
+
 static void convert(float y, float u, float v,
                     float *b, float *g, float *r)
 {
@@ -1107,6 +1124,8 @@ static int dwa_uncompress(const EXRContext *s, const uint8_t *src, int compresse
 
     for (int y = 0; y < td->ysize; y += 8) {
         for (int x = 0; x < td->xsize; x += 8) {
+            int dc_only = 0;
+
             memset(td->block, 0, sizeof(td->block));
 
             for (int j = 0; j < 3; j++) {
@@ -1118,8 +1137,10 @@ static int dwa_uncompress(const EXRContext *s, const uint8_t *src, int compresse
                 dc_val.i = half2float(dc[idx], &s->h2f_tables);
 
                 block[0] = dc_val.f;
-                ac_uncompress(s, &agb, block);
-                dct_inverse(block);
+                if (!ac_uncompress(s, &agb, block) && dct_inverse_dc(block))
+                    dc_only |= 1 << j;
+                else
+                    dct_inverse(block);
             }
 
             {
@@ -1134,6 +1155,34 @@ static int dwa_uncompress(const EXRContext *s, const uint8_t *src, int compresse
                 float *ub = td->block[1];
                 float *vb = td->block[2];
 
+                /* flat blocks are converted once */
+                if (dc_only == 7) {
+                    float b, g, r;
+
+                    convert(yb[0], ub[0], vb[0], &b, &g, &r);
+                    b = to_linear(b, 1.f);
+                    g = to_linear(g, 1.f);
+                    r = to_linear(r, 1.f);
+
+                    for (int yy = 0; yy < 8; yy++) {
+                        for (int xx = 0; xx < 8; xx++) {
+                            bo[xx] = b;
+                            go[xx] = g;
+                            ro[xx] = r;
+                        }
+
+                        bo += td->xsize * s->nb_channels;
+                        go += td->xsize * s->nb_channels;
+                        ro += td->xsize * s->nb_channels;
+                    }
+                    continue;
+                }
+
+                for (int j = 0; j < 3; j++)
+                    if (dc_only & (1 << j))
+                        for (int i = 1; i < 64; i++)
+                            td->block[j][i] = td->block[j][0];
+
                 for (int yy = 0; yy < 8; yy++) {
                     for (int xx = 0; xx < 8; xx++) {
                         const int idx = xx + yy * 8;
@@ -1407,10 +1456,15 @@ static int decode_block(AVCodecContext *avctx, void *tdata,
                             *ptr_x++ = t;
                         }
                     } else {
+#if HAVE_BIGENDIAN
                         for (x = 0; x < xsize; x++) {
                             t.i = bytestream_get_le32(&src);
                             *ptr_x++ = t;
                         }
+#else
+                        memcpy(ptr_x, src, xsize * 4);
+                        ptr_x += xsize;
+#endif
                     }
                 } else if (s->pixel_type == EXR_HALF) {
                     // 16-bit
@@ -141,6 +141,7 @@ typedef struct FFV1Context {
     int key_frame_ok;
     int context_model;
     int qtable;
+    int auto_slices;
 
     int bits_per_raw_sample;
     int packed_at_lsb;
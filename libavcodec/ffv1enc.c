@@ -518,12 +518,26 @@ static int sort_stt(FFV1Context *s, uint8_t stt[256])
 }
 
 
+#define MIN_AUTO_SLICE_PIXELS (256 * 256)
+
 int ff_ffv1_encode_determine_slices(AVCodecContext *avctx)
 {
     FFV1Context *s = avctx->priv_data;
     int plane_count = 1 + 2*s->chroma_planes + s->transparency;
     int max_h_slices = AV_CEIL_RSHIFT(avctx->width , s->chroma_h_shift);
     int max_v_slices = AV_CEIL_RSHIFT(avctx->height, s->chroma_v_shift);
+    int min_slices   = 0;
+
+    /* With auto_slices and no explicit slice count, use at least one slice
+     * per thread, but do not go below MIN_AUTO_SLICE_PIXELS per slice, as
+     * every slice restarts the context modeling. This is opt-in, otherwise
+     * the bitstream would depend on the number of threads. */
+    if (s->auto_slices && !avctx->slices &&
+        (avctx->active_thread_type & FF_THREAD_SLICE)) {
+        int64_t max_slices = (int64_t)avctx->width * avctx->height / MIN_AUTO_SLICE_PIXELS;
+        min_slices = FFMIN3(avctx->thread_count, max_slices, MAX_SLICES);
+    }
+
     s->num_v_slices = (avctx->width > 352 || avctx->height > 288 || !avctx->slices) ? 2 : 1;
     s->num_v_slices = FFMIN(s->num_v_slices, max_v_slices);
     for (; s->num_v_slices < 32; s->num_v_slices++) {
@@ -538,7 +552,10 @@ int ff_ffv1_encode_determine_slices(AVCodecContext *avctx)
                 if (  ff_need_new_slices(avctx->width , s->num_h_slices, s->chroma_h_shift)
                     ||ff_need_new_slices(avctx->height, s->num_v_slices, s->chroma_v_shift))
                     continue;
-            if (avctx->slices == s->num_h_slices * s->num_v_slices && avctx->slices <= MAX_SLICES || !avctx->slices)
+            if (avctx->slices == s->num_h_slices * s->num_v_slices && avctx->slices <= MAX_SLICES)
+                return 0;
+            if (!avctx->slices && s->num_h_slices * s->num_v_slices >= min_slices &&
+                s->num_h_slices * s->num_v_slices <= MAX_SLICES)
                 return 0;
         }
     }
@@ -1358,6 +1375,8 @@ static const AVOption options[] = {
             { .i64 = QTABLE_8BIT }, INT_MIN, INT_MAX, VE, .unit = "qtable" },
         { "greater8bit", NULL, 0, AV_OPT_TYPE_CONST,
             { .i64 = QTABLE_GT8BIT }, INT_MIN, INT_MAX, VE, .unit = "qtable" },
+    { "auto_slices", "Use at least one slice per slice thread if the number of slices is not set", OFFSET(auto_slices), AV_OPT_TYPE_BOOL,
+            { .i64 = 0 }, 0, 1, VE },
 
     { NULL }
 };
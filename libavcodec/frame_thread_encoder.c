@@ -34,38 +34,40 @@
 #include "internal.h"
 #include "pthread_internal.h"
 
-#define MAX_THREADS 64
-/* There can be as many as MAX_THREADS + 1 outstanding tasks.
- * An additional + 1 is needed so that one can distinguish
- * the case of zero and MAX_THREADS + 1 outstanding tasks modulo
- * the number of buffers. */
-#define BUFFER_SIZE (MAX_THREADS + 2)
-
 typedef struct{
     AVFrame  *indata;
     AVPacket *outdata;
     int       return_code;
-    int       finished;
+    atomic_int finished;
     int       got_packet;
 } Task;
 
 typedef struct{
     AVCodecContext *parent_avctx;
 
-    pthread_mutex_t task_fifo_mutex; /* Used to guard (next_)task_index */
+    /* The task ring is indexed by free running counters; max_tasks is
+     * a power of two, so that the counters may wrap around. Tasks are
+     * submitted by the main thread by advancing task_index and claimed
+     * by the workers by advancing next_task_index with a CAS.
+     * The mutexes and condition variables are only used to put idle
+     * threads to sleep and to wake them up again. */
+    pthread_mutex_t task_fifo_mutex;
     pthread_cond_t task_fifo_cond;
 
     unsigned pthread_init_cnt;
     unsigned max_tasks;
-    Task tasks[BUFFER_SIZE];
-    pthread_mutex_t finished_task_mutex; /* Guards tasks[i].finished */
+    Task *tasks;
+    pthread_mutex_t finished_task_mutex;
     pthread_cond_t finished_task_cond;
 
-    unsigned next_task_index;
-    unsigned task_index;
+    atomic_uint next_task_index;
+    atomic_uint task_index;
     unsigned finished_task_index;
 
-    pthread_t worker[MAX_THREADS];
+    atomic_int nb_idle_workers;
+    atomic_int main_waiting;
+
+    pthread_t *worker;
     atomic_int exit;
 } ThreadContext;
 
@@ -75,6 +77,19 @@ DEFINE_OFFSET_ARRAY(ThreadContext, thread_ctx, pthread_init_cnt,
                     (OFF(task_fifo_cond),  OFF(finished_task_cond)));
 #undef OFF
 
+static int claim_task(ThreadContext *c, unsigned *task_index)
+{
+    unsigned idx = atomic_load(&c->next_task_index);
+
+    while (idx != atomic_load(&c->task_index)) {
+        if (atomic_compare_exchange_weak(&c->next_task_index, &idx, idx + 1)) {
+            *task_index = idx & (c->max_tasks - 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
 static void * attribute_align_arg worker(void *v){
     AVCodecContext *avctx = v;
     ThreadContext *c = avctx->internal->frame_thread_encoder;
@@ -86,33 +101,36 @@ static void * attribute_align_arg worker(void *v){
         Task *task;
         unsigned task_index;
 
-        pthread_mutex_lock(&c->task_fifo_mutex);
-        while (c->next_task_index == c->task_index || atomic_load(&c->exit)) {
-            if (atomic_load(&c->exit)) {
-                pthread_mutex_unlock(&c->task_fifo_mutex);
-                goto end;
-            }
-            pthread_cond_wait(&c->task_fifo_cond, &c->task_fifo_mutex);
+        if (!claim_task(c, &task_index)) {
+            /* Registering as idle before rechecking the ring ensures that
+             * either this thread sees the new task or the main thread sees
+             * an idle worker and signals the condition. */
+            pthread_mutex_lock(&c->task_fifo_mutex);
+            atomic_fetch_add(&c->nb_idle_workers, 1);
+            while (atomic_load(&c->next_task_index) == atomic_load(&c->task_index) &&
+                   !atomic_load(&c->exit))
+                pthread_cond_wait(&c->task_fifo_cond, &c->task_fifo_mutex);
+            atomic_fetch_sub(&c->nb_idle_workers, 1);
+            pthread_mutex_unlock(&c->task_fifo_mutex);
+            continue;
         }
-        task_index         = c->next_task_index;
-        c->next_task_index = (c->next_task_index + 1) % c->max_tasks;
-        pthread_mutex_unlock(&c->task_fifo_mutex);
         /* The main thread ensures that any two outstanding tasks have
          * different indices, ergo each worker thread owns its element
          * of c->tasks with the exception of finished, which is shared
-         * with the main thread and guarded by finished_task_mutex. */
+         * with the main thread. */
         task  = &c->tasks[task_index];
         frame = task->indata;
         pkt   = task->outdata;
 
         ret = ff_encode_encode_cb(avctx, pkt, frame, &task->got_packet);
-        pthread_mutex_lock(&c->finished_task_mutex);
         task->return_code = ret;
-        task->finished    = 1;
-        pthread_cond_signal(&c->finished_task_cond);
-        pthread_mutex_unlock(&c->finished_task_mutex);
+        atomic_store(&task->finished, 1);
+        if (atomic_load(&c->main_waiting)) {
+            pthread_mutex_lock(&c->finished_task_mutex);
+            pthread_cond_signal(&c->finished_task_cond);
+            pthread_mutex_unlock(&c->finished_task_mutex);
+        }
     }
-end:
     avcodec_free_context(&avctx);
     return NULL;
 }
@@ -164,17 +182,12 @@ av_cold int ff_frame_thread_encoder_init(AVCodecContext *avctx)
         }
     }
 
-    if(!avctx->thread_count) {
+    if(!avctx->thread_count)
         avctx->thread_count = av_cpu_count();
-        avctx->thread_count = FFMIN(avctx->thread_count, MAX_THREADS);
-    }
 
     if(avctx->thread_count <= 1)
         return 0;
 
-    if(avctx->thread_count > MAX_THREADS)
-        return AVERROR(EINVAL);
-
     av_assert0(!avctx->internal->frame_thread_encoder);
     c = avctx->internal->frame_thread_encoder = av_mallocz(sizeof(ThreadContext));
     if(!c)
@@ -186,9 +199,21 @@ av_cold int ff_frame_thread_encoder_init(AVCodecContext *avctx)
     if (ret < 0)
         goto fail;
     atomic_init(&c->exit, 0);
-
-    c->max_tasks = avctx->thread_count + 2;
+    atomic_init(&c->next_task_index, 0);
+    atomic_init(&c->task_index, 0);
+    atomic_init(&c->nb_idle_workers, 0);
+    atomic_init(&c->main_waiting, 0);
+
+    /* There can be as many as thread_count + 1 outstanding tasks. */
+    c->max_tasks = 1U << av_ceil_log2(avctx->thread_count + 1);
+    c->tasks  = av_calloc(c->max_tasks, sizeof(*c->tasks));
+    c->worker = av_calloc(avctx->thread_count, sizeof(*c->worker));
+    if (!c->tasks || !c->worker) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
     for (unsigned j = 0; j < c->max_tasks; j++) {
+        atomic_init(&c->tasks[j].finished, 0);
         if (!(c->tasks[j].indata  = av_frame_alloc()) ||
             !(c->tasks[j].outdata = av_packet_alloc())) {
             ret = AVERROR(ENOMEM);
@@ -289,10 +314,12 @@ av_cold void ff_frame_thread_encoder_free(AVCodecContext *avctx)
             pthread_join(c->worker[i], NULL);
     }
 
-    for (unsigned i = 0; i < c->max_tasks; i++) {
+    for (unsigned i = 0; c->tasks && i < c->max_tasks; i++) {
         av_frame_free(&c->tasks[i].indata);
         av_packet_free(&c->tasks[i].outdata);
     }
+    av_freep(&c->tasks);
+    av_freep(&c->worker);
 
     ff_pthread_free(c, thread_ctx_offsets);
     av_freep(&avctx->internal->frame_thread_encoder);
@@ -302,39 +329,43 @@ int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
                                  AVFrame *frame, int *got_packet_ptr)
 {
     ThreadContext *c = avctx->internal->frame_thread_encoder;
+    /* task_index is only ever changed by the main thread. */
+    unsigned task_index = atomic_load_explicit(&c->task_index, memory_order_relaxed);
     Task *outtask;
 
     av_assert1(!*got_packet_ptr);
 
     if(frame){
-        av_frame_move_ref(c->tasks[c->task_index].indata, frame);
+        av_frame_move_ref(c->tasks[task_index & (c->max_tasks - 1)].indata, frame);
 
-        pthread_mutex_lock(&c->task_fifo_mutex);
-        c->task_index = (c->task_index + 1) % c->max_tasks;
-        pthread_cond_signal(&c->task_fifo_cond);
-        pthread_mutex_unlock(&c->task_fifo_mutex);
+        atomic_store(&c->task_index, ++task_index);
+        if (atomic_load(&c->nb_idle_workers)) {
+            pthread_mutex_lock(&c->task_fifo_mutex);
+            pthread_cond_signal(&c->task_fifo_cond);
+            pthread_mutex_unlock(&c->task_fifo_mutex);
+        }
     }
 
-    outtask = &c->tasks[c->finished_task_index];
-    pthread_mutex_lock(&c->finished_task_mutex);
-    /* The access to task_index in the following code is ok,
-     * because it is only ever changed by the main thread. */
-    if (c->task_index == c->finished_task_index ||
-        (frame && !outtask->finished &&
-         (c->task_index - c->finished_task_index + c->max_tasks) % c->max_tasks <= avctx->thread_count)) {
-            pthread_mutex_unlock(&c->finished_task_mutex);
-            return 0;
-        }
-    while (!outtask->finished) {
-        pthread_cond_wait(&c->finished_task_cond, &c->finished_task_mutex);
+    outtask = &c->tasks[c->finished_task_index & (c->max_tasks - 1)];
+    if (task_index == c->finished_task_index ||
+        (frame && !atomic_load(&outtask->finished) &&
+         task_index - c->finished_task_index <= avctx->thread_count))
+        return 0;
+
+    if (!atomic_load(&outtask->finished)) {
+        pthread_mutex_lock(&c->finished_task_mutex);
+        atomic_store(&c->main_waiting, 1);
+        while (!atomic_load(&outtask->finished))
+            pthread_cond_wait(&c->finished_task_cond, &c->finished_task_mutex);
+        atomic_store(&c->main_waiting, 0);
+        pthread_mutex_unlock(&c->finished_task_mutex);
     }
-    pthread_mutex_unlock(&c->finished_task_mutex);
     /* We now own outtask completely: No worker thread touches it any more,
      * because there is no outstanding task with this index. */
-    outtask->finished = 0;
+    atomic_store_explicit(&outtask->finished, 0, memory_order_relaxed);
     av_packet_move_ref(pkt, outtask->outdata);
     *got_packet_ptr = outtask->got_packet;
-    c->finished_task_index = (c->finished_task_index + 1) % c->max_tasks;
+    c->finished_task_index++;
 
     return outtask->return_code;
 }
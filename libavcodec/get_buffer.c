@@ -18,6 +18,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include "libavutil/avassert.h"
@@ -28,18 +29,75 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/thread.h"
 #include "libavutil/version.h"
 
 #include "avcodec.h"
+#include "decode.h"
 #include "internal.h"
 #include "libavutil/refstruct.h"
 
+#define MAX_SIZE_CLASSES 16
+
+typedef struct SizeClass {
+    AVBufferPool *pool;
+    size_t size;
+    /**
+     * Number of planes of live FramePools using this pool, only pools
+     * without users may be evicted.
+     */
+    int users;
+} SizeClass;
+
+/**
+ * State shared by all frame pools of a decoder, including those of its
+ * frame threads. It keeps the video plane pools across pool
+ * reinitializations when requested, enforces the memory budget and
+ * collects the pool statistics.
+ */
+typedef struct FramePoolCache {
+    /**
+     * Protects classes and nb_classes.
+     *
+     * pool_buffer_alloc() runs with the mutex of its AVBufferPool held and
+     * may take this one to trim the cache, so the lock order is AVBufferPool
+     * mutex first, cache mutex second. No AVBufferPool function that locks
+     * a pool, such as av_buffer_pool_uninit(), may be called with the cache
+     * mutex held: evicted pools are detached under it and uninitialized after
+     * unlocking.
+     */
+    AVMutex mutex;
+    SizeClass classes[MAX_SIZE_CLASSES];
+    int nb_classes;
+
+    int keep;
+    int64_t max_bytes;
+
+    atomic_int_least64_t bytes;
+    atomic_uint_least64_t nb_gets;
+    atomic_uint_least64_t nb_allocs;
+} FramePoolCache;
+
+/**
+ * Opaque of the AVBufferPools allocated through a FramePoolCache, it lives
+ * until the pool and all of its buffers are gone.
+ */
+typedef struct PoolOpaque {
+    FramePoolCache *cache;
+    size_t size;
+} PoolOpaque;
+
 typedef struct FramePool {
     /**
      * Pools for each data plane. For audio all the planes have the same size,
      * so only pools[0] is used.
      */
     AVBufferPool *pools[4];
+    /**
+     * Set for the pools owned by the cache instead of this FramePool.
+     */
+    int cached[4];
+    FramePoolCache *cache;
 
     /*
      * Pool parameters
@@ -53,13 +111,257 @@ typedef struct FramePool {
     int samples;
 } FramePool;
 
+static void pool_buffer_free(void *opaque, uint8_t *data)
+{
+    PoolOpaque *po = opaque;
+
+    av_free(data);
+    atomic_fetch_sub_explicit(&po->cache->bytes, po->size, memory_order_relaxed);
+}
+
+static void cache_trim(FramePoolCache *cache);
+
+static AVBufferRef *pool_buffer_alloc(void *opaque, size_t size)
+{
+    PoolOpaque *po = opaque;
+    FramePoolCache *cache = po->cache;
+    AVBufferRef *buf;
+    uint8_t *data;
+    int64_t bytes;
+
+    bytes = atomic_fetch_add_explicit(&cache->bytes, size, memory_order_relaxed) + size;
+    if (cache->max_bytes && bytes > cache->max_bytes) {
+        /* free the idle buffers of the pools nobody uses anymore and retry */
+        atomic_fetch_sub_explicit(&cache->bytes, size, memory_order_relaxed);
+        cache_trim(cache);
+        bytes = atomic_fetch_add_explicit(&cache->bytes, size, memory_order_relaxed) + size;
+        if (bytes > cache->max_bytes)
+            goto fail;
+    }
+
+    data = CONFIG_MEMORY_POISONING ? av_malloc(size) : av_mallocz(size);
+    if (!data)
+        goto fail;
+
+    buf = av_buffer_create(data, size, pool_buffer_free, po, 0);
+    if (!buf) {
+        av_free(data);
+        goto fail;
+    }
+    atomic_fetch_add_explicit(&cache->nb_allocs, 1, memory_order_relaxed);
+
+    return buf;
+fail:
+    atomic_fetch_sub_explicit(&cache->bytes, size, memory_order_relaxed);
+    return NULL;
+}
+
+static void pool_opaque_free(void *opaque)
+{
+    PoolOpaque *po = opaque;
+
+    av_refstruct_unref(&po->cache);
+    av_free(po);
+}
+
+static AVBufferPool *cache_pool_init(FramePoolCache *cache, size_t size)
+{
+    PoolOpaque *po = av_mallocz(sizeof(*po));
+    AVBufferPool *pool;
+
+    if (!po)
+        return NULL;
+
+    po->cache = av_refstruct_ref(cache);
+    po->size  = size;
+
+    pool = av_buffer_pool_init2(size, po, pool_buffer_alloc, pool_opaque_free);
+    if (!pool)
+        pool_opaque_free(po);
+
+    return pool;
+}
+
+/**
+ * Round a buffer size up to its size class, which wastes at most 1/8 of it.
+ */
+static size_t size_class(size_t size)
+{
+    int shift = FFMAX(av_log2(size) - 3, 6);
+
+    return FFALIGN(size, (size_t)1 << shift);
+}
+
+/**
+ * Remove a size class from the cache, must be called with the cache mutex
+ * held. The returned pool must be uninitialized after unlocking it.
+ */
+static AVBufferPool *cache_evict(FramePoolCache *cache, int idx)
+{
+    AVBufferPool *buf_pool = cache->classes[idx].pool;
+
+    cache->classes[idx] = cache->classes[--cache->nb_classes];
+    return buf_pool;
+}
+
+static void cache_trim(FramePoolCache *cache)
+{
+    AVBufferPool *evicted[MAX_SIZE_CLASSES];
+    int nb_evicted = 0;
+
+    ff_mutex_lock(&cache->mutex);
+    for (int i = cache->nb_classes - 1; i >= 0; i--)
+        if (!cache->classes[i].users)
+            evicted[nb_evicted++] = cache_evict(cache, i);
+    ff_mutex_unlock(&cache->mutex);
+
+    for (int i = 0; i < nb_evicted; i++)
+        av_buffer_pool_uninit(&evicted[i]);
+}
+
+/**
+ * Get a pool for plane buffers of the given size, from the cache if
+ * pools are kept across reinitializations.
+ */
+static int cache_get_pool(FramePoolCache *cache, FramePool *pool, int plane,
+                          size_t size)
+{
+    AVBufferPool *evicted = NULL;
+    SizeClass *cls = NULL;
+
+    if (!cache->keep) {
+        pool->pools[plane] = cache_pool_init(cache, size);
+        return pool->pools[plane] ? 0 : AVERROR(ENOMEM);
+    }
+
+    size = size_class(size);
+
+    ff_mutex_lock(&cache->mutex);
+    for (int i = 0; i < cache->nb_classes; i++) {
+        if (cache->classes[i].size == size) {
+            cls = &cache->classes[i];
+            break;
+        }
+    }
+    if (!cls) {
+        AVBufferPool *buf_pool = cache_pool_init(cache, size);
+
+        if (!buf_pool) {
+            ff_mutex_unlock(&cache->mutex);
+            return AVERROR(ENOMEM);
+        }
+
+        if (cache->nb_classes == MAX_SIZE_CLASSES) {
+            for (int i = 0; i < cache->nb_classes; i++) {
+                if (!cache->classes[i].users) {
+                    evicted = cache_evict(cache, i);
+                    break;
+                }
+            }
+        }
+        if (cache->nb_classes == MAX_SIZE_CLASSES) {
+            /* all classes are in use, fall back to a private pool */
+            ff_mutex_unlock(&cache->mutex);
+            pool->pools[plane] = buf_pool;
+            return 0;
+        }
+
+        cls = &cache->classes[cache->nb_classes++];
+        cls->pool  = buf_pool;
+        cls->size  = size;
+        cls->users = 0;
+    }
+    cls->users++;
+    pool->pools[plane]  = cls->pool;
+    pool->cached[plane] = 1;
+    ff_mutex_unlock(&cache->mutex);
+
+    av_buffer_pool_uninit(&evicted);
+
+    return 0;
+}
+
+static void cache_release_pool(FramePoolCache *cache, AVBufferPool *buf_pool)
+{
+    ff_mutex_lock(&cache->mutex);
+    for (int i = 0; i < cache->nb_classes; i++) {
+        if (cache->classes[i].pool == buf_pool) {
+            cache->classes[i].users--;
+            break;
+        }
+    }
+    ff_mutex_unlock(&cache->mutex);
+}
+
+static void frame_pool_cache_free(AVRefStructOpaque unused, void *obj)
+{
+    FramePoolCache *cache = obj;
+
+    ff_mutex_destroy(&cache->mutex);
+}
+
+int ff_frame_pool_cache_alloc(AVCodecContext *avctx)
+{
+    FramePoolCache *cache;
+
+    cache = av_refstruct_alloc_ext(sizeof(*cache), 0, NULL, frame_pool_cache_free);
+    if (!cache)
+        return AVERROR(ENOMEM);
+
+    ff_mutex_init(&cache->mutex, NULL);
+    cache->keep      = avctx->frame_pool_reuse;
+    cache->max_bytes = avctx->frame_pool_max_bytes;
+    atomic_init(&cache->bytes,     0);
+    atomic_init(&cache->nb_gets,   0);
+    atomic_init(&cache->nb_allocs, 0);
+
+    avctx->internal->pool_cache = cache;
+
+    return 0;
+}
+
+void ff_frame_pool_cache_uninit(FramePoolCache **pcache)
+{
+    FramePoolCache *cache = *pcache;
+    AVBufferPool *evicted[MAX_SIZE_CLASSES];
+    int nb_evicted = 0;
+
+    if (!cache)
+        return;
+
+    ff_mutex_lock(&cache->mutex);
+    while (cache->nb_classes)
+        evicted[nb_evicted++] = cache_evict(cache, cache->nb_classes - 1);
+    ff_mutex_unlock(&cache->mutex);
+
+    for (int i = 0; i < nb_evicted; i++)
+        av_buffer_pool_uninit(&evicted[i]);
+
+    av_refstruct_unref(pcache);
+}
+
+void ff_frame_pool_cache_stats(const FramePoolCache *cache,
+                               int64_t *hits, int64_t *misses)
+{
+    uint64_t allocs = atomic_load_explicit(&cache->nb_allocs, memory_order_relaxed);
+    uint64_t gets   = atomic_load_explicit(&cache->nb_gets,   memory_order_relaxed);
+
+    *hits   = gets > allocs ? gets - allocs : 0;
+    *misses = allocs;
+}
+
 static void frame_pool_free(AVRefStructOpaque unused, void *obj)
 {
     FramePool *pool = obj;
     int i;
 
-    for (i = 0; i < FF_ARRAY_ELEMS(pool->pools); i++)
-        av_buffer_pool_uninit(&pool->pools[i]);
+    for (i = 0; i < FF_ARRAY_ELEMS(pool->pools); i++) {
+        if (pool->cached[i])
+            cache_release_pool(pool->cache, pool->pools[i]);
+        else
+            av_buffer_pool_uninit(&pool->pools[i]);
+    }
+    av_refstruct_unref(&pool->cache);
 }
 
 static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
@@ -112,6 +414,9 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
         if (ret < 0)
             goto fail;
 
+        if (avctx->internal->pool_cache)
+            pool->cache = av_refstruct_ref(avctx->internal->pool_cache);
+
         for (i = 0; i < 4; i++) {
             pool->linesize[i] = linesize[i];
             if (size[i]) {
@@ -119,6 +424,13 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
                     ret = AVERROR(EINVAL);
                     goto fail;
                 }
+                if (pool->cache) {
+                    ret = cache_get_pool(pool->cache, pool, i,
+                                         size[i] + 16 + STRIDE_ALIGN - 1);
+                    if (ret < 0)
+                        goto fail;
+                    continue;
+                }
                 pool->pools[i] = av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1,
                                                      CONFIG_MEMORY_POISONING ?
                                                         NULL :
@@ -230,9 +542,19 @@ static int video_get_buffer(AVCodecContext *s, AVFrame *pic)
     for (i = 0; i < 4 && pool->pools[i]; i++) {
         pic->linesize[i] = pool->linesize[i];
 
+        if (pool->cache)
+            atomic_fetch_add_explicit(&pool->cache->nb_gets, 1, memory_order_relaxed);
+
         pic->buf[i] = av_buffer_pool_get(pool->pools[i]);
-        if (!pic->buf[i])
+        if (!pic->buf[i]) {
+            if (pool->cache) {
+                atomic_fetch_sub_explicit(&pool->cache->nb_gets, 1, memory_order_relaxed);
+                if (pool->cache->max_bytes)
+                    av_log(s, AV_LOG_ERROR, "Frame buffer memory budget of %"PRId64" "
+                           "bytes exhausted\n", pool->cache->max_bytes);
+            }
             goto fail;
+        }
 
         pic->data[i] = pic->buf[i]->data;
     }
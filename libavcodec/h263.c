@@ -186,15 +186,17 @@ int16_t *ff_h263_pred_motion(MpegEncContext * s, int block, int dir,
     wrap = s->b8_stride;
     mot_val = s->cur_pic.motion_val[dir] + s->block_index[block];
 
-    A = mot_val[ - 1];
     /* special case for first (slice) line */
     if (s->first_slice_line && block<3) {
         // we can't just change some MVs to simulate that as we need them for the B-frames (and ME)
         // and if we ever support non rectangular objects than we need to do a few ifs here anyway :(
+        // neighbours in the previous packet are not touched before the
+        // resync checks, they may be owned by another slice thread
         if(block==0){ //most common case
             if(s->mb_x  == s->resync_mb_x){ //rare
                 *px= *py = 0;
             }else if(s->mb_x + 1 == s->resync_mb_x && s->h263_pred){ //rare
+                A = mot_val[ - 1];
                 C = mot_val[off[block] - wrap];
                 if(s->mb_x==0){
                     *px = C[0];
@@ -204,10 +206,12 @@ int16_t *ff_h263_pred_motion(MpegEncContext * s, int block, int dir,
                     *py = mid_pred(A[1], 0, C[1]);
                 }
             }else{
+                A = mot_val[ - 1];
                 *px = A[0];
                 *py = A[1];
             }
         }else if(block==1){
+            A = mot_val[ - 1];
             if(s->mb_x + 1 == s->resync_mb_x && s->h263_pred){ //rare
                 C = mot_val[off[block] - wrap];
                 *px = mid_pred(A[0], 0, C[0]);
@@ -219,13 +223,24 @@ int16_t *ff_h263_pred_motion(MpegEncContext * s, int block, int dir,
         }else{ /* block==2*/
             B = mot_val[ - wrap];
             C = mot_val[off[block] - wrap];
-            if(s->mb_x == s->resync_mb_x) //rare
-                A[0]=A[1]=0;
-
-            *px = mid_pred(A[0], B[0], C[0]);
-            *py = mid_pred(A[1], B[1], C[1]);
+            if(s->mb_x == s->resync_mb_x){ //rare
+                /* The left MB of the first packet of a slice thread may still
+                 * be decoded by another thread, the caller clears it later. */
+                if (!s->slice_start_mb ||
+                    s->mb_x + s->mb_y * s->mb_width != s->slice_start_mb) {
+                    A = mot_val[ - 1];
+                    A[0]=A[1]=0;
+                }
+                *px = mid_pred(0, B[0], C[0]);
+                *py = mid_pred(0, B[1], C[1]);
+            }else{
+                A = mot_val[ - 1];
+                *px = mid_pred(A[0], B[0], C[0]);
+                *py = mid_pred(A[1], B[1], C[1]);
+            }
         }
     } else {
+        A = mot_val[ - 1];
         B = mot_val[ - wrap];
         C = mot_val[off[block] - wrap];
         *px = mid_pred(A[0], B[0], C[0]);
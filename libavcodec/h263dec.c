@@ -39,6 +39,7 @@
 #include "hwaccel_internal.h"
 #include "hwconfig.h"
 #include "mpeg_er.h"
+#include "mpegutils.h"
 #include "mpeg4video.h"
 #include "mpeg4videodec.h"
 #include "mpeg4videodefs.h"
@@ -193,6 +194,17 @@ static int get_consumed_bytes(MpegEncContext *s, int buf_size)
     }
 }
 
+/**
+ * Draw the band of the current MB row. Slice threads can split a row and
+ * finish rows out of order, so their bands are drawn after the join in
+ * mpeg4_decode_slices() instead.
+ */
+static void draw_horiz_band_row(MpegEncContext *s, int mb_size)
+{
+    if (s->slice_start_mb == 0 && s->slice_end_mb == s->mb_num)
+        ff_mpeg_draw_horiz_band(s, s->mb_y * mb_size, mb_size);
+}
+
 static int decode_slice(MpegEncContext *s)
 {
     const int part_mask = s->partitioned_frame
@@ -258,6 +270,15 @@ static int decode_slice(MpegEncContext *s)
             ff_update_block_index(s, s->avctx->bits_per_raw_sample,
                                   s->avctx->lowres, s->chroma_x_shift);
 
+            if (s->mb_x + s->mb_y * s->mb_width >= s->slice_end_mb) {
+                /* ran into the MBs of the next slice thread */
+                av_log(s->avctx, AV_LOG_ERROR, "Slice overrun at MB: %d\n",
+                       s->mb_x + s->mb_y * s->mb_width);
+                ff_er_add_slice(&s->er, s->resync_mb_x, s->resync_mb_y,
+                                s->mb_x - 1, s->mb_y, ER_MB_ERROR & part_mask);
+                return AVERROR_INVALIDDATA;
+            }
+
             if (s->resync_mb_x == s->mb_x && s->resync_mb_y + 1 == s->mb_y)
                 s->first_slice_line = 0;
 
@@ -288,7 +309,7 @@ static int decode_slice(MpegEncContext *s)
 
                     if (++s->mb_x >= s->mb_width) {
                         s->mb_x = 0;
-                        ff_mpeg_draw_horiz_band(s, s->mb_y * mb_size, mb_size);
+                        draw_horiz_band_row(s, mb_size);
                         ff_mpv_report_decode_progress(s);
                         s->mb_y++;
                     }
@@ -315,7 +336,7 @@ static int decode_slice(MpegEncContext *s)
                 ff_h263_loop_filter(s);
         }
 
-        ff_mpeg_draw_horiz_band(s, s->mb_y * mb_size, mb_size);
+        draw_horiz_band_row(s, mb_size);
         ff_mpv_report_decode_progress(s);
 
         s->mb_x = 0;
@@ -423,6 +444,189 @@ static int decode_slice(MpegEncContext *s)
     return AVERROR_INVALIDDATA;
 }
 
+#if CONFIG_MPEG4_DECODER
+/**
+ * Distribute the video packets of an MPEG-4 VOP over the slice contexts.
+ * Every context gets a run of consecutive packets; the first packet of each
+ * run is located by scanning for resync markers, the following ones are
+ * found by the slice thread itself exactly like in the serial case.
+ * @return the number of slice contexts to run, 1 to decode serially
+ */
+static int mpeg4_setup_slice_threads(MpegEncContext *s)
+{
+    const Mpeg4DecContext *ctx = s->avctx->priv_data;
+    const int nb_slices   = s->slice_context_count;
+    const int prefix_len  = ff_mpeg4_get_video_packet_prefix_length(s);
+    const int mb_num_bits = av_log2(s->mb_num - 1) + 1;
+    const uint8_t *const buf = s->gb.buffer;
+    const uint8_t *end = s->gb.buffer_end - 8;
+    const uint8_t *ptr = buf + ((get_bits_count(&s->gb) + 7) >> 3);
+    int n = 1, last_mb = 0, packets = 1;
+
+    if (nb_slices < 2 || !ctx->resync_marker || ctx->shape != RECT_SHAPE ||
+        s->partitioned_frame || s->studio_profile || s->avctx->hwaccel ||
+        (s->pict_type == AV_PICTURE_TYPE_S && ctx->vol_sprite_usage == GMC_SPRITE))
+        return 1;
+
+    for (; ptr < end && n < nb_slices; ptr++) {
+        MpegEncContext *const t = s->thread_context[n];
+        GetBitContext gb;
+        int len, mb_num;
+
+        if (ptr[0] || ptr[1])
+            continue;
+        /* a start code, e.g. the second VOP of packed B-frames */
+        if (ptr[2] == 1)
+            break;
+
+        init_get_bits8(&gb, ptr, end + 8 - ptr);
+        for (len = 0; len < 32; len++)
+            if (get_bits1(&gb))
+                break;
+        if (len != prefix_len)
+            continue;
+        mb_num = get_bits(&gb, mb_num_bits);
+        if (mb_num <= last_mb || mb_num >= s->mb_num)
+            continue;
+        last_mb = mb_num;
+        packets++;
+
+        if (mb_num < (int64_t)s->mb_num * n / nb_slices)
+            continue;
+        /* field MV predictors of B-VOPs are only reset at the start of a
+         * row, not at resync markers */
+        if (s->pict_type == AV_PICTURE_TYPE_B && !s->progressive_sequence &&
+            mb_num % s->mb_width)
+            continue;
+
+        if (ff_update_duplicate_context(t, s) < 0)
+            break;
+        skip_bits_long(&t->gb, (ptr - buf) * 8 - get_bits_count(&t->gb));
+        if (ff_mpeg4_decode_video_packet_header(t) < 0)
+            continue;
+
+        /* the AC values are shared, see ff_mpeg4_pred_ac() */
+        for (int i = 0; i < 3; i++)
+            t->ac_val[i] = s->ac_val[i];
+        t->last_mv[0][0][0] =
+        t->last_mv[0][0][1] =
+        t->last_mv[1][0][0] =
+        t->last_mv[1][0][1] = 0;
+        t->er.error_count        = 0;
+        t->padding_bug_score    -= packets - 1;
+        t->slice_start_mb        = mb_num;
+        t->slice_end_mb          = s->mb_num;
+        s->thread_context[n - 1]->slice_end_mb = mb_num;
+        n++;
+    }
+
+    return n;
+}
+
+static int mpeg4_decode_slice_thread(AVCodecContext *avctx, void *arg)
+{
+    MpegEncContext *s = *(void **)arg;
+    int ret = 0;
+
+    if (decode_slice(s) < 0)
+        ret = AVERROR_INVALIDDATA;
+
+    while (s->mb_x + s->mb_y * s->mb_width < s->slice_end_mb) {
+        int prev = s->mb_x + s->mb_y * s->mb_width, mb_num;
+
+        if (ff_h263_resync(s) < 0)
+            break;
+        mb_num = s->mb_x + s->mb_y * s->mb_width;
+        if (prev < mb_num)
+            s->er.error_occurred = 1;
+        if (mb_num < s->slice_start_mb || mb_num >= s->slice_end_mb)
+            break;
+
+        /* ff_mpeg4_clean_buffers() without touching the AC values of the
+         * previous packet, which may belong to another thread */
+        s->last_mv[0][0][0] =
+        s->last_mv[0][0][1] =
+        s->last_mv[1][0][0] =
+        s->last_mv[1][0][1] = 0;
+
+        if (decode_slice(s) < 0)
+            ret = AVERROR_INVALIDDATA;
+    }
+
+    return ret;
+}
+
+static int mpeg4_decode_slices(MpegEncContext *s, int nb_slices)
+{
+    AVCodecContext *const avctx = s->avctx;
+    const int mb_size = 16 >> avctx->lowres;
+    int padding_bug_score[MAX_THREADS], rets[MAX_THREADS];
+    int error_count = 0, error_max = 0, score = 0, ret = 0;
+    int band_end = s->mb_num;
+
+    for (int i = 0; i < nb_slices; i++)
+        padding_bug_score[i] = s->thread_context[i]->padding_bug_score;
+
+    avctx->execute(avctx, mpeg4_decode_slice_thread, s->thread_context,
+                   rets, nb_slices, sizeof(void *));
+
+    for (int i = 0; i < nb_slices; i++) {
+        const MpegEncContext *const t = s->thread_context[i];
+
+        if (rets[i] < 0) {
+            ret      = rets[i];
+            band_end = FFMIN(band_end, t->slice_start_mb);
+        }
+        if (i) {
+            const MpegEncContext *const prev = s->thread_context[i - 1];
+            const int x  = t->slice_start_mb % s->mb_width;
+            const int y  = t->slice_start_mb / s->mb_width;
+            const int xy = x + y * s->mb_stride;
+            const int count = atomic_load(&t->er.error_count);
+
+            /* the previous thread did not end where this one starts */
+            if (prev->mb_x + prev->mb_y * s->mb_width != t->slice_start_mb)
+                s->er.error_occurred = 1;
+            s->er.error_occurred |= t->er.error_occurred;
+            if (count > 0)
+                error_max = 1;
+            else
+                error_count += count;
+
+            /* the first packet of this thread skipped clearing the MV of
+             * its left neighbour in ff_h263_pred_motion(), do it now */
+            if (s->pict_type != AV_PICTURE_TYPE_B &&
+                IS_8X8(s->cur_pic.mb_type[xy]) && !IS_INTRA(s->cur_pic.mb_type[xy])) {
+                int16_t *mv = s->cur_pic.motion_val[0][2 * x - 1 + (2 * y + 1) * s->b8_stride];
+                mv[0] = mv[1] = 0;
+            }
+        }
+        score += t->padding_bug_score - padding_bug_score[i];
+    }
+    s->padding_bug_score = padding_bug_score[0] + score;
+
+    if (error_max)
+        atomic_store(&s->er.error_count, INT_MAX);
+    else
+        atomic_fetch_add(&s->er.error_count, error_count);
+
+    /* continue from where the last packet ended */
+    s->gb              = s->thread_context[nb_slices - 1]->gb;
+    s->mb_x            = s->thread_context[nb_slices - 1]->mb_x;
+    s->mb_y            = s->thread_context[nb_slices - 1]->mb_y;
+    s->workaround_bugs = s->thread_context[nb_slices - 1]->workaround_bugs;
+    s->slice_end_mb    = s->mb_num;
+
+    /* the rows completed by the threads, in order; a row the last thread
+     * ended in is drawn by the serial code that finishes it, rows from the
+     * first failed thread on are not drawn at all */
+    for (int mb_y = 0; mb_y < FFMIN(s->mb_y, band_end / s->mb_width); mb_y++)
+        ff_mpeg_draw_horiz_band(s, mb_y * mb_size, mb_size);
+
+    return ret;
+}
+#endif
+
 int ff_h263_decode_frame(AVCodecContext *avctx, AVFrame *pict,
                          int *got_frame, AVPacket *avpkt)
 {
@@ -431,6 +635,7 @@ int ff_h263_decode_frame(AVCodecContext *avctx, AVFrame *pict,
     MpegEncContext *s  = avctx->priv_data;
     int ret;
     int slice_ret = 0;
+    av_unused int nb_slices = 1;
     int bak_width, bak_height;
 
     /* no supplementary picture */
@@ -617,8 +822,19 @@ retry:
     /* decode each macroblock */
     s->mb_x = 0;
     s->mb_y = 0;
+    s->slice_start_mb = 0;
+    s->slice_end_mb   = s->mb_num;
 
+#if CONFIG_MPEG4_DECODER
+    if (HAVE_THREADS && (avctx->active_thread_type & FF_THREAD_SLICE) &&
+        avctx->codec_id == AV_CODEC_ID_MPEG4)
+        nb_slices = mpeg4_setup_slice_threads(s);
+    if (nb_slices > 1)
+        slice_ret = mpeg4_decode_slices(s, nb_slices);
+    else
+#endif
     slice_ret = decode_slice(s);
+    /* anything the slice threads left over is handled serially */
     while (s->mb_y < s->mb_height) {
         if (s->msmpeg4_version != MSMP4_UNUSED) {
             if (s->slice_height == 0 || s->mb_x != 0 || slice_ret < 0 ||
@@ -33,6 +33,22 @@
 
 #include "hevc/hevc.h"
 
+/* A 00 00 xx sequence cannot begin in a word without zero bytes. */
+#if HAVE_FAST_UNALIGNED
+#if HAVE_FAST_64BIT
+#define WORD_SIZE 8
+#define HAS_ZERO_BYTE(p)                                                \
+    ((~AV_RN64(p) & (AV_RN64(p) - 0x0101010101010101ULL)) &            \
+     0x8080808080808080ULL)
+#define COPY_WORD(d, s) AV_COPY64U(d, s)
+#else
+#define WORD_SIZE 4
+#define HAS_ZERO_BYTE(p)                                                \
+    ((~AV_RN32(p) & (AV_RN32(p) - 0x01010101U)) & 0x80808080U)
+#define COPY_WORD(d, s) AV_COPY32U(d, s)
+#endif /* HAVE_FAST_64BIT */
+#endif /* HAVE_FAST_UNALIGNED */
+
 int ff_h2645_extract_rbsp(const uint8_t *src, int length,
                           H2645RBSP *rbsp, H2645NAL *nal, int small_padding)
 {
@@ -102,6 +118,14 @@ int ff_h2645_extract_rbsp(const uint8_t *src, int length,
     while (si + 2 < length) {
         // remove escapes (very rare 1:2^22)
         if (src[si + 2] > 3) {
+#if HAVE_FAST_UNALIGNED
+            if (si + WORD_SIZE <= length && !HAS_ZERO_BYTE(src + si)) {
+                COPY_WORD(dst + di, src + si);
+                si += WORD_SIZE;
+                di += WORD_SIZE;
+                continue;
+            }
+#endif
             dst[di++] = src[si++];
             dst[di++] = src[si++];
         } else if (src[si] == 0 && src[si + 1] == 0 && src[si + 2] != 0) {
@@ -402,17 +426,27 @@ static int h264_parse_nal_header(H2645NAL *nal, void *logctx)
 
 static int find_next_start_code(const uint8_t *buf, const uint8_t *next_avc)
 {
-    int i = 0;
+    int i = 0, size = next_avc - buf;
 
-    if (buf + 3 >= next_avc)
-        return next_avc - buf;
+    if (size <= 3)
+        return size;
 
-    while (buf + i + 3 < next_avc) {
-        if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1)
+    while (i + 3 < size) {
+#if HAVE_FAST_UNALIGNED
+        if (i + WORD_SIZE <= size && !HAS_ZERO_BYTE(buf + i)) {
+            i += WORD_SIZE;
+            continue;
+        }
+#endif
+        /* buf[i + 2] > 1 rules out a start code at i, i + 1 and i + 2 */
+        if (buf[i + 2] > 1)
+            i += 3;
+        else if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1)
             break;
-        i++;
+        else
+            i++;
     }
-    return i + 3;
+    return FFMIN(i, size - 3) + 3;
 }
 
 static void alloc_rbsp_buffer(H2645RBSP *rbsp, unsigned int size, int use_ref)
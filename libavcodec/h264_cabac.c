@@ -1747,10 +1747,7 @@ decode_cabac_residual_internal(const H264Context *h, H264SliceContext *sl,
                     j++; \
                 } \
 \
-                coeff_abs=1; \
-                while( j-- ) { \
-                    coeff_abs += coeff_abs + get_cabac_bypass( CC ); \
-                } \
+                coeff_abs = (1 << j) + get_cabac_bypass_bits(CC, j); \
                 coeff_abs+= 14U; \
             } \
 \
@@ -36,6 +36,7 @@
 #include "libavutil/pixfmt.h"
 
 #include "avcodec.h"
+#include "bytestream.h"
 #include "get_bits.h"
 #include "golomb.h"
 #include "h264.h"
@@ -56,6 +57,7 @@ typedef struct H264ParseContext {
     H264DSPContext h264dsp;
     H264POCContext poc;
     H264SEIContext sei;
+    H2645RBSP rbsp;
     int is_avc;
     int nal_length_size;
     int got_first;
@@ -246,6 +248,51 @@ static int scan_mmco_reset(AVCodecParserContext *s, GetBitContext *gb,
     return 0;
 }
 
+/**
+ * Look for a recovery point SEI message and skip everything else, which
+ * is all that is needed to tell whether the picture is a keyframe.
+ */
+static void scan_recovery_point(H264ParseContext *p, GetBitContext *gb)
+{
+    GetByteContext gbyte;
+
+    bytestream2_init(&gbyte, gb->buffer + get_bits_count(gb) / 8,
+                     get_bits_left(gb) / 8);
+
+    while (bytestream2_get_bytes_left(&gbyte) > 2 && bytestream2_peek_ne16(&gbyte)) {
+        GetBitContext gb_payload;
+        int type = 0;
+        unsigned size = 0;
+
+        do {
+            if (bytestream2_get_bytes_left(&gbyte) <= 0)
+                return;
+            type += bytestream2_peek_byteu(&gbyte);
+        } while (bytestream2_get_byteu(&gbyte) == 255);
+
+        do {
+            if (bytestream2_get_bytes_left(&gbyte) <= 0)
+                return;
+            size += bytestream2_peek_byteu(&gbyte);
+        } while (bytestream2_get_byteu(&gbyte) == 255);
+
+        if (size > bytestream2_get_bytes_left(&gbyte))
+            return;
+
+        if (type == SEI_TYPE_RECOVERY_POINT) {
+            unsigned recovery_frame_cnt;
+
+            if (init_get_bits8(&gb_payload, gbyte.buffer, size) < 0)
+                return;
+            recovery_frame_cnt = get_ue_golomb_long(&gb_payload);
+            if (recovery_frame_cnt < (1 << MAX_LOG2_MAX_FRAME_NUM))
+                p->sei.recovery_point.recovery_frame_cnt = recovery_frame_cnt;
+            return;
+        }
+        bytestream2_skipu(&gbyte, size);
+    }
+}
+
 /**
  * Parse NAL units of found picture and decode some basic information.
  *
@@ -259,8 +306,9 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                                   const uint8_t * const buf, int buf_size)
 {
     H264ParseContext *p = s->priv_data;
-    H2645RBSP rbsp = { NULL };
+    H2645RBSP *rbsp = &p->rbsp;
     H2645NAL nal = { NULL };
+    const int boundaries_only = s->flags & PARSER_FLAG_BOUNDARIES_ONLY;
     int buf_index, next_avc;
     unsigned int pps_id;
     unsigned int slice_type;
@@ -281,9 +329,10 @@ static inline int parse_nal_units(AVCodecParserContext *s,
     if (!buf_size)
         return 0;
 
-    av_fast_padded_malloc(&rbsp.rbsp_buffer, &rbsp.rbsp_buffer_alloc_size, buf_size);
-    if (!rbsp.rbsp_buffer)
+    av_fast_padded_malloc(&rbsp->rbsp_buffer, &rbsp->rbsp_buffer_alloc_size, buf_size);
+    if (!rbsp->rbsp_buffer)
         return AVERROR(ENOMEM);
+    rbsp->rbsp_buffer_size = 0;
 
     buf_index     = 0;
     next_avc      = p->is_avc ? 0 : buf_size;
@@ -310,7 +359,11 @@ static inline int parse_nal_units(AVCodecParserContext *s,
         case H264_NAL_SLICE:
         case H264_NAL_IDR_SLICE:
             // Do not walk the whole buffer just to decode slice header
-            if ((state & 0x1f) == H264_NAL_IDR_SLICE || ((state >> 5) & 0x3) == 0) {
+            if (boundaries_only) {
+                /* Nothing past the field flags is read. */
+                if (src_length > 32)
+                    src_length = 32;
+            } else if ((state & 0x1f) == H264_NAL_IDR_SLICE || ((state >> 5) & 0x3) == 0) {
                 /* IDR or disposable slice
                  * No need to decode many bytes because MMCOs shall not be present. */
                 if (src_length > 60)
@@ -322,7 +375,7 @@ static inline int parse_nal_units(AVCodecParserContext *s,
             }
             break;
         }
-        consumed = ff_h2645_extract_rbsp(buf + buf_index, src_length, &rbsp, &nal, 1);
+        consumed = ff_h2645_extract_rbsp(buf + buf_index, src_length, rbsp, &nal, 1);
         if (consumed < 0)
             break;
 
@@ -344,7 +397,10 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                                                  nal.size_bits);
             break;
         case H264_NAL_SEI:
-            ff_h264_sei_decode(&p->sei, &nal.gb, &p->ps, avctx);
+            if (boundaries_only)
+                scan_recovery_point(p, &nal.gb);
+            else
+                ff_h264_sei_decode(&p->sei, &nal.gb, &p->ps, avctx);
             break;
         case H264_NAL_IDR_SLICE:
             s->key_frame = 1;
@@ -426,6 +482,10 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                 }
             }
 
+            field_poc[0] = field_poc[1] = INT_MAX;
+            if (boundaries_only)
+                goto skip_poc;
+
             if (nal.type == H264_NAL_IDR_SLICE)
                 get_ue_golomb_long(&nal.gb); /* idr_pic_id */
             if (sps->poc_type == 0) {
@@ -447,7 +507,6 @@ static inline int parse_nal_units(AVCodecParserContext *s,
 
             /* Decode POC of this picture.
              * The prev_ values needed for decoding POC of the next picture are not set here. */
-            field_poc[0] = field_poc[1] = INT_MAX;
             ret = ff_h264_init_poc(field_poc, &s->output_picture_number, sps,
                              &p->poc, p->picture_structure, nal.ref_idc);
             if (ret < 0)
@@ -477,6 +536,7 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                 }
             }
 
+skip_poc:
             if (p->sei.picture_timing.present) {
                 ret = ff_h264_sei_process_picture_timing(&p->sei.picture_timing,
                                                          sps, avctx);
@@ -566,18 +626,14 @@ static inline int parse_nal_units(AVCodecParserContext *s,
                           sps->num_units_in_tick * 2, den, 1 << 30);
             }
 
-            av_freep(&rbsp.rbsp_buffer);
             return 0; /* no need to evaluate the rest */
         }
     }
-    if (q264) {
-        av_freep(&rbsp.rbsp_buffer);
+    if (q264)
         return 0;
-    }
     /* didn't find a picture! */
     av_log(avctx, AV_LOG_ERROR, "missing picture in access unit with size %d\n", buf_size);
 fail:
-    av_freep(&rbsp.rbsp_buffer);
     return -1;
 }
 
@@ -632,7 +688,7 @@ static int h264_parse(AVCodecParserContext *s,
     }
 
     if (s->flags & PARSER_FLAG_ONCE) {
-        s->flags &= PARSER_FLAG_COMPLETE_FRAMES;
+        s->flags &= PARSER_FLAG_COMPLETE_FRAMES | PARSER_FLAG_BOUNDARIES_ONLY;
     }
 
     if (s->dts_sync_point >= 0) {
@@ -669,6 +725,7 @@ static void h264_close(AVCodecParserContext *s)
 
     ff_h264_sei_uninit(&p->sei);
     ff_h264_ps_uninit(&p->ps);
+    av_freep(&p->rbsp.rbsp_buffer);
 }
 
 static av_cold int init(AVCodecParserContext *s)
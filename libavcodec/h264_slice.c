@@ -2524,7 +2524,10 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
         top    = 0;
     }
 
-    ff_h264_draw_horiz_band(h, sl, top, height);
+    /* with postponed deblocking the row is not final yet, the band is
+     * drawn once the filter has run over it */
+    if (!h->postpone_filter)
+        ff_h264_draw_horiz_band(h, sl, top, height);
 
     if (h->droppable || h->er.error_occurred)
         return;
@@ -2823,6 +2826,8 @@ int ff_h264_execute_decode_slices(H264Context *h)
                     sl->mb_y = j;
                     loop_filter(h, sl, j > sl->resync_mb_y ? 0 : sl->resync_mb_x,
                                 j == y_end - 1 ? x_end : h->mb_width);
+                    if (j < y_end - 1 || x_end == h->mb_width)
+                        decode_finish_row(h, sl);
                 }
             }
         }
@@ -943,14 +943,12 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCLocalContext *l
     int prefix = 0;
     int suffix = 0;
     int last_coeff_abs_level_remaining;
-    int i;
 
     while (prefix < CABAC_MAX_BIN && get_cabac_bypass(&lc->cc))
         prefix++;
 
     if (prefix < 3) {
-        for (i = 0; i < rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&lc->cc);
+        suffix = get_cabac_bypass_bits(&lc->cc, rc_rice_param);
         last_coeff_abs_level_remaining = (prefix << rc_rice_param) + suffix;
     } else {
         int prefix_minus3 = prefix - 3;
@@ -960,8 +958,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCLocalContext *l
             return 0;
         }
 
-        for (i = 0; i < prefix_minus3 + rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&lc->cc);
+        suffix = get_cabac_bypass_bits(&lc->cc, prefix_minus3 + rc_rice_param);
         last_coeff_abs_level_remaining = (((1 << prefix_minus3) + 3 - 1)
                                               << rc_rice_param) + suffix;
     }
@@ -970,12 +967,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCLocalContext *l
 
 static av_always_inline int coeff_sign_flag_decode(HEVCLocalContext *lc, uint8_t nb)
 {
-    int i;
-    int ret = 0;
-
-    for (i = 0; i < nb; i++)
-        ret = (ret << 1) | get_cabac_bypass(&lc->cc);
-    return ret;
+    return get_cabac_bypass_bits(&lc->cc, nb);
 }
 
 void ff_hevc_hls_residual_coding(HEVCLocalContext *lc, const HEVCPPS *pps,
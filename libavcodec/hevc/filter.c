@@ -23,9 +23,11 @@
  */
 
 #include "libavutil/common.h"
+#include "libavutil/emms.h"
 #include "libavutil/internal.h"
 
 #include "hevcdec.h"
+#include "mpegutils.h"
 #include "progressframe.h"
 
 #define LUMA 0
@@ -869,6 +871,35 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
 #undef CB
 #undef CR
 
+/**
+ * Pass the luma rows [y, y_end) of the current picture, which are final
+ * once all in-loop filters touching them have run, to draw_horiz_band().
+ */
+static void draw_horiz_band(const HEVCContext *s, const HEVCSPS *sps,
+                            int y, int y_end)
+{
+    AVCodecContext *avctx = s->avctx;
+    const AVFrame *src;
+    int offset[AV_NUM_DATA_POINTERS] = { 0 };
+
+    if (!avctx->draw_horiz_band ||
+        !(s->layers_active_output & (1 << s->cur_layer)))
+        return;
+
+    y     = FFMAX(y, 0);
+    y_end = FFMIN(y_end, sps->height);
+    if (y >= y_end)
+        return;
+
+    src = s->cur_frame->f;
+    for (int i = 0; i < 3 && src->data[i]; i++)
+        offset[i] = (y >> sps->vshift[i]) * src->linesize[i];
+
+    emms_c();
+
+    avctx->draw_horiz_band(avctx, src, offset, y, PICT_FRAME, y_end - y);
+}
+
 void ff_hevc_hls_filter(HEVCLocalContext *lc, const HEVCLayerContext *l,
                         const HEVCPPS *pps,
                         int x, int y, int ctb_size)
@@ -899,14 +930,21 @@ void ff_hevc_hls_filter(HEVCLocalContext *lc, const HEVCLayerContext *l,
             sao_filter_CTB(lc, l, s, pps, sps, x, y - ctb_size);
             if (s->avctx->active_thread_type & FF_THREAD_FRAME )
                 ff_progress_frame_report(&s->cur_frame->tf, y);
+            draw_horiz_band(s, sps, y - ctb_size, y);
         }
         if (x_end && y_end) {
             sao_filter_CTB(lc, l, s, pps, sps, x , y);
             if (s->avctx->active_thread_type & FF_THREAD_FRAME )
                 ff_progress_frame_report(&s->cur_frame->tf, y + ctb_size);
+            draw_horiz_band(s, sps, y, y + ctb_size);
         }
-    } else if (s->avctx->active_thread_type & FF_THREAD_FRAME && x_end)
-        ff_progress_frame_report(&s->cur_frame->tf, y + ctb_size - 4);
+    } else if (x_end) {
+        if (s->avctx->active_thread_type & FF_THREAD_FRAME)
+            ff_progress_frame_report(&s->cur_frame->tf, y + ctb_size - 4);
+        /* the last 4 rows of a CTB row are deblocked with the next one */
+        draw_horiz_band(s, sps, y - 4,
+                        y >= sps->height - ctb_size ? sps->height : y + ctb_size - 4);
+    }
 }
 
 void ff_hevc_hls_filters(HEVCLocalContext *lc, const HEVCLayerContext *l,
@@ -4108,6 +4108,7 @@ const FFCodec ff_hevc_decoder = {
     .flush                 = hevc_decode_flush,
     UPDATE_THREAD_CONTEXT(hevc_update_thread_context),
     .p.capabilities        = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                             AV_CODEC_CAP_DRAW_HORIZ_BAND |
                              AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .caps_internal         = FF_CODEC_CAP_EXPORTS_CROPPING |
                              FF_CODEC_CAP_USES_PROGRESSFRAMES |
@@ -30,6 +30,7 @@
 #include "sei.h"
 #include "h2645_parse.h"
 #include "parser.h"
+#include "startcode.h"
 
 #define START_CODE 0x000001 ///< start_code_prefix_one_3bytes
 
@@ -40,6 +41,7 @@ typedef struct HEVCParserContext {
     ParseContext pc;
 
     H2645Packet pkt;
+    H2645RBSP rbsp;
     HEVCParamSets ps;
     HEVCSEI sei;
 
@@ -142,6 +144,9 @@ static int hevc_parse_slice_header(AVCodecParserContext *s, H2645NAL *nal,
                    slice_type == HEVC_SLICE_P ? AV_PICTURE_TYPE_P :
                                                 AV_PICTURE_TYPE_I;
 
+    if (s->flags & PARSER_FLAG_BOUNDARIES_ONLY)
+        return 1;
+
     if (pps->output_flag_present_flag)
         skip_bits1(gb); // pic_output_flag
 
@@ -250,6 +255,117 @@ static int parse_nal_units(AVCodecParserContext *s, const uint8_t *buf,
     return -1;
 }
 
+static int is_slice_nal(int nut)
+{
+    return nut <= HEVC_NAL_RASL_R ||
+           (nut >= HEVC_NAL_BLA_W_LP && nut <= HEVC_NAL_CRA_NUT);
+}
+
+/**
+ * Variant of parse_nal_units() for PARSER_FLAG_BOUNDARIES_ONLY.
+ *
+ * SEI messages are skipped and only the beginning of the first slice
+ * header is unescaped, instead of splitting the whole access unit.
+ */
+static int parse_nal_units_boundaries(AVCodecParserContext *s, const uint8_t *buf,
+                                      int buf_size, AVCodecContext *avctx)
+{
+    HEVCParserContext *ctx = s->priv_data;
+    HEVCParamSets *ps = &ctx->ps;
+    int flags = (H2645_FLAG_IS_NALFF * !!ctx->is_avc) | H2645_FLAG_SMALL_PADDING;
+    const uint8_t *ptr = buf, *end = buf + buf_size;
+    uint32_t state = -1;
+    int ret;
+
+    s->pict_type         = AV_PICTURE_TYPE_I;
+    s->key_frame         = 0;
+    s->picture_structure = AV_PICTURE_STRUCTURE_UNKNOWN;
+
+    ff_hevc_reset_sei(&ctx->sei);
+
+    av_fast_padded_malloc(&ctx->rbsp.rbsp_buffer, &ctx->rbsp.rbsp_buffer_alloc_size, 32);
+    if (!ctx->rbsp.rbsp_buffer)
+        return AVERROR(ENOMEM);
+
+    if (!ctx->is_avc)
+        ptr = avpriv_find_start_code(ptr, end, &state);
+
+    while (ptr < end) {
+        const uint8_t *nal_start, *nal_end, *next;
+        int nut, layer_id;
+
+        // Find the NAL unit header, the start of the NAL unit including its
+        // start code or length field, and the position of the next one.
+        if (ctx->is_avc) {
+            int buf_index = ptr - buf;
+            int nalsize = get_nalsize(ctx->nal_length_size, buf, buf_size,
+                                      &buf_index, avctx);
+            if (nalsize < 0)
+                break;
+            nal_start = ptr;
+            ptr       = buf + buf_index;
+            nal_end   = next = ptr + nalsize;
+        } else {
+            if ((state & 0xFFFFFF00) != 0x100)
+                break;
+            nal_start = ptr - 4;
+            ptr--;
+            nal_end   = next = NULL;
+        }
+        if (end - ptr < 2)
+            break;
+
+        nut      = (ptr[0] >> 1) & 0x3F;
+        layer_id = ((ptr[0] & 1) << 5) | (ptr[1] >> 3);
+
+        if (layer_id == 0 && is_slice_nal(nut)) {
+            H2645NAL nal = { NULL };
+
+            ctx->rbsp.rbsp_buffer_size = 0;
+            ff_h2645_extract_rbsp(ptr, FFMIN(end - ptr, 32), &ctx->rbsp, &nal, 1);
+            ret = init_get_bits8(&nal.gb, nal.data, nal.size);
+            if (ret < 0)
+                return ret;
+            skip_bits(&nal.gb, 13);
+            nal.type         = nut;
+            nal.nuh_layer_id = layer_id;
+            nal.temporal_id  = get_bits(&nal.gb, 3) - 1;
+            if (nal.temporal_id >= 0) {
+                ret = hevc_parse_slice_header(s, &nal, avctx);
+                if (ret)
+                    return ret;
+            }
+        }
+
+        if (!next) {
+            state = -1;
+            next = avpriv_find_start_code(ptr + 2, end, &state);
+            nal_end = (state & 0xFFFFFF00) == 0x100 ? next - 4 : end;
+        }
+
+        if (layer_id == 0 && nut >= HEVC_NAL_VPS && nut <= HEVC_NAL_PPS) {
+            ret = ff_h2645_packet_split(&ctx->pkt, nal_start, nal_end - nal_start,
+                                        avctx, ctx->nal_length_size,
+                                        AV_CODEC_ID_HEVC, flags);
+            if (ret >= 0 && ctx->pkt.nb_nals == 1) {
+                GetBitContext *gb = &ctx->pkt.nals[0].gb;
+
+                if (nut == HEVC_NAL_VPS)
+                    ff_hevc_decode_nal_vps(gb, avctx, ps);
+                else if (nut == HEVC_NAL_SPS)
+                    ff_hevc_decode_nal_sps(gb, avctx, ps, 0, 1);
+                else
+                    ff_hevc_decode_nal_pps(gb, avctx, ps);
+            }
+        }
+
+        ptr = next;
+    }
+    /* didn't find a picture! */
+    av_log(avctx, AV_LOG_ERROR, "missing picture in access unit with size %d\n", buf_size);
+    return -1;
+}
+
 /**
  * Find the end of the current frame in the bitstream.
  * @return the position of the first byte of the next frame, or END_NOT_FOUND
@@ -264,6 +380,10 @@ static int hevc_find_frame_end(AVCodecParserContext *s, const uint8_t *buf,
     for (i = 0; i < buf_size; i++) {
         int nut, layer_id;
 
+        i = ff_startcode_skip(buf, i, buf_size, &pc->state64);
+        if (i >= buf_size)
+            break;
+
         pc->state64 = (pc->state64 << 8) | buf[i];
 
         if (((pc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
@@ -333,8 +453,12 @@ static int hevc_parse(AVCodecParserContext *s, AVCodecContext *avctx,
 
     is_dummy_buf &= (dummy_buf == buf);
 
-    if (!is_dummy_buf)
-        parse_nal_units(s, buf, buf_size, avctx);
+    if (!is_dummy_buf) {
+        if (s->flags & PARSER_FLAG_BOUNDARIES_ONLY)
+            parse_nal_units_boundaries(s, buf, buf_size, avctx);
+        else
+            parse_nal_units(s, buf, buf_size, avctx);
+    }
 
     *poutbuf      = buf;
     *poutbuf_size = buf_size;
@@ -347,6 +471,7 @@ static void hevc_parser_close(AVCodecParserContext *s)
 
     ff_hevc_ps_uninit(&ctx->ps);
     ff_h2645_packet_uninit(&ctx->pkt);
+    av_freep(&ctx->rbsp.rbsp_buffer);
     ff_hevc_reset_sei(&ctx->sei);
 
     av_freep(&ctx->pc.buffer);
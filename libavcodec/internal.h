@@ -67,6 +67,11 @@ typedef struct AVCodecInternal {
     int pad_samples;
 
     struct FramePool *pool;
+    /**
+     * State shared by the frame pools of the default get_buffer2() across
+     * pool reinitializations and frame threads, video decoders only.
+     */
+    struct FramePoolCache *pool_cache;
 
     struct AVRefStructPool *progress_frame_pool;
 
@@ -70,6 +70,7 @@
 #include "encode.h"
 #include "bytestream.h"
 #include "jpeg2000.h"
+#include "jpeg2000htenc.h"
 #include "version.h"
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
@@ -87,6 +88,8 @@
 #define CODEC_JP2 1
 #define CODEC_J2K 0
 
+#define HT_DATA_SIZE (3 * 8192) ///< up to 31 MagSgn bits per sample, plus MEL and VLC
+
 static int lut_nmsedec_ref [1<<NMSEDEC_BITS],
            lut_nmsedec_ref0[1<<NMSEDEC_BITS],
            lut_nmsedec_sig [1<<NMSEDEC_BITS],
@@ -109,6 +112,15 @@ typedef struct {
    double *layer_rates;
 } Jpeg2000Tile;
 
+/* a row of code-blocks of one band, the unit of parallel tier-1 coding */
+typedef struct {
+    uint16_t tileno;
+    uint8_t  compno;
+    uint8_t  reslevelno;
+    uint8_t  bandno;
+    int      cblky;
+} Jpeg2000CblkRow;
+
 typedef struct {
     AVClass *class;
     AVCodecContext *avctx;
@@ -134,6 +146,9 @@ typedef struct {
     Jpeg2000QuantStyle  qntsty;
 
     Jpeg2000Tile *tile;
+    Jpeg2000CblkRow *cblk_rows;
+    int nb_cblk_rows;
+    int *job_ret;                 ///< return codes of the parallel jobs
     int layer_rates[100];
     uint8_t compression_rate_enc; ///< Is compression done using compression ratio?
 
@@ -143,6 +158,7 @@ typedef struct {
     int eph;
     int prog;
     int nlayers;
+    int ht;
     char *lr_str;
 } Jpeg2000EncoderContext;
 
@@ -307,7 +323,7 @@ static int put_siz(Jpeg2000EncoderContext *s)
 
     bytestream_put_be16(&s->buf, JPEG2000_SIZ);
     bytestream_put_be16(&s->buf, 38 + 3 * s->ncomponents); // Lsiz
-    bytestream_put_be16(&s->buf, 0); // Rsiz
+    bytestream_put_be16(&s->buf, s->ht ? 1 << 14 : 0); // Rsiz, bit 14 signals a CAP marker
     bytestream_put_be32(&s->buf, s->width); // width
     bytestream_put_be32(&s->buf, s->height); // height
     bytestream_put_be32(&s->buf, 0); // X0Siz
@@ -327,6 +343,26 @@ static int put_siz(Jpeg2000EncoderContext *s)
     return 0;
 }
 
+static int put_cap(Jpeg2000EncoderContext *s)
+{
+    Jpeg2000QuantStyle *qntsty = &s->qntsty;
+    int i, B = 0, P;
+
+    if (s->buf_end - s->buf < 10)
+        return -1;
+
+    // B is the largest number of magnitude bit-planes of any subband
+    for (i = 0; i < 3 * s->codsty.nreslevels - 2; i++)
+        B = FFMAX(B, qntsty->expn[i] + qntsty->nguardbits - 1);
+    P = B <= 8 ? 0 : B <= 27 ? B - 8 : 19 + (B - 24) / 4;
+
+    bytestream_put_be16(&s->buf, JPEG2000_CAP);
+    bytestream_put_be16(&s->buf, 8); // Lcap
+    bytestream_put_be32(&s->buf, 1 << (31 - 14)); // Pcap, Part 15 only
+    bytestream_put_be16(&s->buf, (s->codsty.transform != FF_DWT53) << 5 | P); // Ccap15, HTONLY
+    return 0;
+}
+
 static int put_cod(Jpeg2000EncoderContext *s)
 {
     Jpeg2000CodingStyle *codsty = &s->codsty;
@@ -354,7 +390,7 @@ static int put_cod(Jpeg2000EncoderContext *s)
     bytestream_put_byte(&s->buf, codsty->nreslevels - 1); // num of decomp. levels
     bytestream_put_byte(&s->buf, codsty->log2_cblk_width-2); // cblk width
     bytestream_put_byte(&s->buf, codsty->log2_cblk_height-2); // cblk height
-    bytestream_put_byte(&s->buf, 0); // cblk style
+    bytestream_put_byte(&s->buf, s->ht ? JPEG2000_CTSY_HTJ2K_F : 0); // cblk style
     bytestream_put_byte(&s->buf, codsty->transform == FF_DWT53); // transformation
     return 0;
 }
@@ -448,6 +484,60 @@ static void compute_rates(Jpeg2000EncoderContext* s)
 
 }
 
+/**
+ * list the code-block rows of all bands, which are coded in parallel,
+ * and allocate the buffers of their code-blocks
+ */
+static int init_cblk_rows(Jpeg2000EncoderContext *s)
+{
+    int tileno, compno, reslevelno, bandno, cblkno, n = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++)
+            for (compno = 0; compno < s->ncomponents; compno++) {
+                Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+
+                for (reslevelno = 0; reslevelno < s->codsty.nreslevels; reslevelno++) {
+                    Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+
+                    for (bandno = 0; bandno < reslevel->nbands; bandno++) {
+                        Jpeg2000Band *band = reslevel->band + bandno;
+                        Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
+
+                        if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
+                            continue;
+
+                        if (!pass) {
+                            n += prec->nb_codeblocks_height;
+                            for (cblkno = 0; cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height; cblkno++) {
+                                Jpeg2000Cblk *cblk = prec->cblk + cblkno;
+
+                                cblk->data   = av_malloc(1 + (s->ht ? HT_DATA_SIZE : 8192));
+                                cblk->passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof(*cblk->passes));
+                                if (!cblk->data || !cblk->passes)
+                                    return AVERROR(ENOMEM);
+                            }
+                            continue;
+                        }
+                        for (int cblky = 0; cblky < prec->nb_codeblocks_height; cblky++)
+                            s->cblk_rows[s->nb_cblk_rows++] = (Jpeg2000CblkRow) {
+                                tileno, compno, reslevelno, bandno, cblky
+                            };
+                    }
+                }
+            }
+        if (!pass) {
+            s->cblk_rows = av_malloc_array(n, sizeof(*s->cblk_rows));
+            s->job_ret   = av_malloc_array(FFMAX(n, s->numXtiles * s->numYtiles * s->ncomponents),
+                                           sizeof(*s->job_ret));
+            if (!s->cblk_rows || !s->job_ret)
+                return AVERROR(ENOMEM);
+        }
+    }
+
+    return 0;
+}
+
 /**
  * compute the sizes of tiles, resolution levels, bands, etc.
  * allocate memory for them
@@ -502,7 +592,7 @@ static int init_tiles(Jpeg2000EncoderContext *s)
             }
         }
     compute_rates(s);
-    return 0;
+    return init_cblk_rows(s);
 }
 
 #define COPY_FRAME(D, PIXEL)                                                                                                \
@@ -596,6 +686,7 @@ static void init_luts(void)
                                     << 1, 0);
     }
     ff_jpeg2000_init_tier1_luts();
+    ff_jpeg2000_ht_init_tables();
 }
 
 /* tier-1 routines */
@@ -764,6 +855,113 @@ static void encode_cblk(Jpeg2000EncoderContext *s, Jpeg2000T1Context *t1, Jpeg20
     }
 }
 
+static int64_t band_lambda(Jpeg2000EncoderContext *s, Jpeg2000Band *band, int bandpos, int lev)
+{
+    int64_t dwt_norm = dwt_norms[s->codsty.transform == FF_DWT53][bandpos][lev] * (int64_t)band->i_stepsize >> 15;
+
+    return av_rescale(s->lambda, 1 << WMSEDEC_SHIFT, dwt_norm * dwt_norm);
+}
+
+static int getcut(Jpeg2000Cblk *cblk, uint64_t lambda)
+{
+    int passno, res = 0;
+    for (passno = 0; passno < cblk->npasses; passno++){
+        int dr;
+        int64_t dd;
+
+        dr = cblk->passes[passno].rate
+           - (res ? cblk->passes[res-1].rate : 0);
+        dd = cblk->passes[passno].disto
+           - (res ? cblk->passes[res-1].disto : 0);
+
+        if (dd  >= dr * lambda)
+            res = passno+1;
+    }
+    return res;
+}
+
+/**
+ * code a code-block with the HT cleanup pass only; as the pass cannot be
+ * truncated, the number of dropped bit-planes is chosen here, from the
+ * distortion and an estimate of the rate of each candidate
+ */
+static int encode_cblk_ht(Jpeg2000EncoderContext *s, Jpeg2000T1Context *t1, Jpeg2000Cblk *cblk,
+                          int width, int height, int64_t lambda)
+{
+    int64_t disto[32] = { 0 };
+    int rate[32] = { 0 };
+    int lossless = s->codsty.transform == FF_DWT53;
+    int x, y, i, b, nb, max = 0, len;
+
+    for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+            max = FFMAX(max, FFABS(t1->data[y * t1->stride + x]));
+
+    nb = max >> NMSEDEC_FRACBITS ? av_log2(max) + 1 - NMSEDEC_FRACBITS : 0;
+    cblk->npasses     = 0;
+    cblk->ninclpasses = 0;
+    cblk->nonzerobits = 0;
+    if (!nb)
+        return 0;
+
+    // the quads of the cleanup pass share their MagSgn length
+    for (y = 0; y < height; y += 2) {
+        for (x = 0; x < width; x += 2) {
+            int a[4] = { 0 };
+
+            for (i = 0; i < 4; i++)
+                if (x + (i >> 1) < width && y + (i & 1) < height)
+                    a[i] = FFABS(t1->data[(y + (i & 1)) * t1->stride + x + (i >> 1)]);
+
+            for (b = 0; b < nb; b++) {
+                int nsig = 0, max_e = 0;
+
+                for (i = 0; i < 4; i++) {
+                    int mu = a[i] >> (b + NMSEDEC_FRACBITS);
+                    int64_t d;
+
+                    if (!mu)
+                        continue;
+                    // reconstruction in the middle of the interval, as the decoder does
+                    d = a[i] - ((int64_t)mu << (b + NMSEDEC_FRACBITS)) -
+                        (b || !lossless ? 1 << (b + NMSEDEC_FRACBITS - 1) : 0);
+                    disto[b] += (int64_t)a[i] * a[i] - d * d;
+                    max_e = FFMAX(max_e, av_log2(2 * mu - 1) + 1);
+                    nsig++;
+                }
+                if (!nsig)
+                    break;
+                // MagSgn bits and roughly the VLC codeword
+                rate[b] += nsig * max_e + 3;
+            }
+        }
+    }
+
+    // candidates from the coarsest to the finest quantization, like passes
+    for (b = nb - 1; b >= 0; b--) {
+        cblk->passes[nb - 1 - b].rate  = rate[b] + 7 >> 3;
+        cblk->passes[nb - 1 - b].disto = disto[b] * 2;
+    }
+    cblk->npasses = nb;
+    b = nb - getcut(cblk, lambda);
+    cblk->npasses = 0;
+    if (b == nb)
+        return 0;
+
+    len = ff_jpeg2000_encode_ht_cleanup(cblk->data + 1, HT_DATA_SIZE, t1->data, t1->stride,
+                                        width, height, b + NMSEDEC_FRACBITS);
+    if (len <= 0)
+        return len;
+
+    cblk->nonzerobits = b + 1;
+    cblk->npasses     = 1;
+    cblk->ninclpasses = 1;
+    cblk->passes[0].rate        = len;
+    cblk->passes[0].disto       = disto[b] * 2;
+    cblk->passes[0].flushed_len = 0;
+    return 0;
+}
+
 /* tier-2 routines: */
 
 static void putnumpasses(Jpeg2000EncoderContext *s, int n)
@@ -1349,24 +1547,6 @@ static void makelayers(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
-static int getcut(Jpeg2000Cblk *cblk, uint64_t lambda)
-{
-    int passno, res = 0;
-    for (passno = 0; passno < cblk->npasses; passno++){
-        int dr;
-        int64_t dd;
-
-        dr = cblk->passes[passno].rate
-           - (res ? cblk->passes[res-1].rate : 0);
-        dd = cblk->passes[passno].disto
-           - (res ? cblk->passes[res-1].disto : 0);
-
-        if (dd  >= dr * lambda)
-            res = passno+1;
-    }
-    return res;
-}
-
 static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
 {
     int precno, compno, reslevelno, bandno, cblkno, lev;
@@ -1384,12 +1564,12 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
                     Jpeg2000Band *band = reslevel->band + bandno;
                     Jpeg2000Prec *prec = band->prec + precno;
 
-                    int64_t dwt_norm = dwt_norms[codsty->transform == FF_DWT53][bandpos][lev] * (int64_t)band->i_stepsize >> 15;
-                    int64_t lambda_prime = av_rescale(s->lambda, 1 << WMSEDEC_SHIFT, dwt_norm * dwt_norm);
+                    int64_t lambda_prime = band_lambda(s, band, bandpos, lev);
                     for (cblkno = 0; cblkno < prec->nb_codeblocks_height * prec->nb_codeblocks_width; cblkno++){
                         Jpeg2000Cblk *cblk = prec->cblk + cblkno;
 
-                        cblk->ninclpasses = getcut(cblk, lambda_prime);
+                        // HT code-blocks were already cut by encode_cblk_ht()
+                        cblk->ninclpasses = s->ht ? cblk->npasses : getcut(cblk, lambda_prime);
                         cblk->layers[0].data_start = cblk->data;
                         cblk->layers[0].cum_passes = cblk->ninclpasses;
                         cblk->layers[0].npasses = cblk->ninclpasses;
@@ -1402,85 +1582,99 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
-static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+static int dwt_tile_comp(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
 {
-    int compno, reslevelno, bandno, ret;
-    Jpeg2000T1Context t1;
-    Jpeg2000CodingStyle *codsty = &s->codsty;
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    Jpeg2000Component *comp   = s->tile[jobnr / s->ncomponents].comp + jobnr % s->ncomponents;
 
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
+    return ff_dwt_encode(&comp->dwt, comp->i_data);
+}
 
-        av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
-        if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
-            return ret;
-        av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+/** @return the first error of the last nb_jobs parallel jobs, or 0 */
+static int job_error(const Jpeg2000EncoderContext *s, int nb_jobs)
+{
+    for (int i = 0; i < nb_jobs; i++)
+        if (s->job_ret[i] < 0)
+            return s->job_ret[i];
+    return 0;
+}
 
-        for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+static int encode_cblk_row(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s    = avctx->priv_data;
+    const Jpeg2000CblkRow *row   = s->cblk_rows + jobnr;
+    Jpeg2000CodingStyle *codsty  = &s->codsty;
+    Jpeg2000Tile *tile           = s->tile + row->tileno;
+    Jpeg2000Component *comp      = tile->comp + row->compno;
+    int reslevelno               = row->reslevelno;
+    Jpeg2000Band *band           = comp->reslevel[reslevelno].band + row->bandno;
+    Jpeg2000Prec *prec           = band->prec;
+    int bandno                   = row->bandno;
+    int cblkx, cblkno, xx0, x0, xx1, y0, yy0, yy1, bandpos, ret;
+    int64_t lambda_prime = 0;
+    Jpeg2000T1Context t1;
 
-            for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                Jpeg2000Band *band = reslevel->band + bandno;
-                Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
-                int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
-                yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
-                y0 = yy0;
-                yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
-                            band->coord[1][1]) - band->coord[1][0] + yy0;
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-                if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
-                    continue;
+    yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
+    y0 = yy0;
+    yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
+                band->coord[1][1]) - band->coord[1][0] + yy0;
+    if (row->cblky) {
+        yy0 = yy1 + (row->cblky - 1 << band->log2_cblk_height);
+        yy1 = FFMIN(yy0 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+    }
 
-                bandpos = bandno + (reslevelno > 0);
-
-                for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
-                    if (reslevelno == 0 || bandno == 1)
-                        xx0 = 0;
-                    else
-                        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
-                    x0 = xx0;
-                    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
-                                band->coord[0][1]) - band->coord[0][0] + xx0;
-
-                    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
-                            }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
-                            }
-                        }
-                        if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
-                        if (!prec->cblk[cblkno].passes)
-                            prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
-                        if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
-                            return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
-                        xx0 = xx1;
-                        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
-                    }
-                    yy0 = yy1;
-                    yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+    bandpos = bandno + (reslevelno > 0);
+    if (s->ht)
+        lambda_prime = band_lambda(s, band, bandpos, codsty->nreslevels - reslevelno - 1);
+
+    if (reslevelno == 0 || bandno == 1)
+        xx0 = 0;
+    else
+        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
+    x0 = xx0;
+    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
+                band->coord[0][1]) - band->coord[0][0] + xx0;
+
+    cblkno = row->cblky * prec->nb_codeblocks_width;
+    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
+        int y, x;
+        if (codsty->transform == FF_DWT53){
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
+                }
+            }
+        } else{
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
+                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                    ptr++;
                 }
             }
         }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+        if (s->ht) {
+            ret = encode_cblk_ht(s, &t1, prec->cblk + cblkno, xx1 - xx0, yy1 - yy0, lambda_prime);
+            if (ret < 0)
+                return ret;
+        } else
+            encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
+                        bandpos, codsty->nreslevels - reslevelno - 1);
+        xx0 = xx1;
+        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
     }
 
+    return 0;
+}
+
+static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+{
+    int ret;
+
     av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
     if (s->compression_rate_enc)
         makelayers(s, tile);
@@ -1511,6 +1705,9 @@ static void cleanup(Jpeg2000EncoderContext *s)
         av_freep(&s->tile[tileno].layer_rates);
     }
     av_freep(&s->tile);
+    av_freep(&s->cblk_rows);
+    av_freep(&s->job_ret);
+    s->nb_cblk_rows = 0;
 }
 
 static void reinit(Jpeg2000EncoderContext *s)
@@ -1635,6 +1832,8 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     bytestream_put_be16(&s->buf, JPEG2000_SOC);
     if ((ret = put_siz(s)) < 0)
         return ret;
+    if (s->ht && (ret = put_cap(s)) < 0)
+        return ret;
     if ((ret = put_cod(s)) < 0)
         return ret;
     if ((ret = put_qcd(s, 0)) < 0)
@@ -1642,6 +1841,18 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     if ((ret = put_com(s, 0)) < 0)
         return ret;
 
+    /* the transform and tier-1 coding of all tiles run in parallel, only
+     * the rate control and the packets are written sequentially */
+    av_log(s->avctx, AV_LOG_DEBUG, "dwt\n");
+    avctx->execute2(avctx, dwt_tile_comp, NULL, s->job_ret, s->numXtiles * s->numYtiles * s->ncomponents);
+    if ((ret = job_error(s, s->numXtiles * s->numYtiles * s->ncomponents)) < 0)
+        return ret;
+    av_log(s->avctx, AV_LOG_DEBUG, "after dwt -> tier1\n");
+    avctx->execute2(avctx, encode_cblk_row, NULL, s->job_ret, s->nb_cblk_rows);
+    if ((ret = job_error(s, s->nb_cblk_rows)) < 0)
+        return ret;
+    av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
         uint8_t *psotptr;
         if (!(psotptr = put_sot(s, tileno)))
@@ -1732,6 +1943,11 @@ static av_cold int j2kenc_init(AVCodecContext *avctx)
         s->compression_rate_enc = 0;
     }
 
+    if (s->ht && s->compression_rate_enc) {
+        av_log(avctx, AV_LOG_ERROR, "Layer rates are not supported with the HT block coder\n");
+        return AVERROR(EINVAL);
+    }
+
     if (avctx->pix_fmt == AV_PIX_FMT_PAL8 && (s->pred != FF_DWT97_INT || s->format != CODEC_JP2)) {
         av_log(s->avctx, AV_LOG_WARNING, "Forcing lossless jp2 for pal8\n");
         s->pred = 1;
@@ -1749,7 +1965,8 @@ static av_cold int j2kenc_init(AVCodecContext *avctx)
     codsty->log2_cblk_height = 4;
     codsty->transform        = s->pred ? FF_DWT53 : FF_DWT97_INT;
 
-    qntsty->nguardbits       = 1;
+    /* HT exponent bounds may exceed the magnitude bit-planes by one */
+    qntsty->nguardbits       = s->ht ? 2 : 1;
 
     if ((s->tile_width  & (s->tile_width -1)) ||
         (s->tile_height & (s->tile_height-1))) {
@@ -1824,6 +2041,7 @@ static const AVOption options[] = {
     { "pcrl",          NULL,                0,                     AV_OPT_TYPE_CONST,  { .i64 = JPEG2000_PGOD_PCRL }, 0,         0,           VE, .unit = "prog" },
     { "cprl",          NULL,                0,                     AV_OPT_TYPE_CONST,  { .i64 = JPEG2000_PGOD_CPRL }, 0,         0,           VE, .unit = "prog" },
     { "layer_rates",   "Layer Rates",       OFFSET(lr_str),        AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, VE },
+    { "ht",            "High-throughput block coder", OFFSET(ht),  AV_OPT_TYPE_BOOL,  { .i64 = 0           }, 0,         1,           VE, },
     { NULL }
 };
 
@@ -1840,7 +2058,7 @@ const FFCodec ff_jpeg2000_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_JPEG2000,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
-                      AV_CODEC_CAP_FRAME_THREADS,
+                      AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .priv_data_size = sizeof(Jpeg2000EncoderContext),
     .init           = j2kenc_init,
     FF_CODEC_ENCODE_CB(encode_frame),
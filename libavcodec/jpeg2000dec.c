@@ -2155,22 +2155,28 @@ static void dequantization_int(int x, int y, Jpeg2000Cblk *cblk,
     }
 }
 
-static void dequantization_int_97(int x, int y, Jpeg2000Cblk *cblk,
-                               Jpeg2000Component *comp,
-                               Jpeg2000T1Context *t1, Jpeg2000Band *band, const int M_b)
+#define PRESCALE 6 // At least 6 is required to pass the conformance tests in ISO/IEC 15444-4
+
+/* Integer step size used by dequantization_int_97(). It is set once per band
+ * before the code-blocks are decoded, as they may be decoded concurrently. */
+static int stepsize_int_97(const Jpeg2000Band *band, const int M_b)
 {
-    int i, j;
-    int w = cblk->coord[0][1] - cblk->coord[0][0];
     float fscale = band->f_stepsize;
     const int downshift = 31 - M_b;
-    const int PRESCALE = 6; // At least 6 is required to pass the conformance tests in ISO/IEC 15444-4
-    int scale;
 
     fscale /= (float)(1 << downshift);
     fscale *= (float)(1 << PRESCALE);
     fscale *= (float)(1 << (16 + I_PRESHIFT));
-    scale = (int)(fscale + 0.5);
-    band->i_stepsize = scale;
+    return (int)(fscale + 0.5);
+}
+
+static void dequantization_int_97(int x, int y, Jpeg2000Cblk *cblk,
+                               Jpeg2000Component *comp,
+                               Jpeg2000T1Context *t1, Jpeg2000Band *band, const int M_b)
+{
+    int i, j;
+    int w = cblk->coord[0][1] - cblk->coord[0][0];
+
     for (j = 0; j < (cblk->coord[1][1] - cblk->coord[1][0]); ++j) {
         int32_t *datap = &comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * (y + j) + x];
         int *src = t1->data + j*t1->stride;
@@ -2185,6 +2191,8 @@ static void dequantization_int_97(int x, int y, Jpeg2000Cblk *cblk,
     }
 }
 
+#undef PRESCALE
+
 static inline void mct_decode(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
 {
     int i, csize = 1;
@@ -2214,92 +2222,174 @@ static inline void mct_decode(const Jpeg2000DecoderContext *s, Jpeg2000Tile *til
 }
 
 
-static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
+/**
+ * Check that no non-empty band of a tile component has M_b >= 31 if it uses
+ * the HT block coder, which does not support such magnitudes.
+ */
+static int htj2k_comp_supported(const Jpeg2000Component *comp,
+                                const Jpeg2000CodingStyle *codsty,
+                                const Jpeg2000QuantStyle *quantsty)
 {
-    Jpeg2000T1Context t1;
+    int reslevelno, bandno, subbandno = 0;
 
-    int compno, reslevelno, bandno;
+    if (!(codsty->cblk_style & JPEG2000_CTSY_HTJ2K_F))
+        return 1;
 
-    /* Loop on tile components */
-    for (compno = 0; compno < s->ncomponents; compno++) {
-        Jpeg2000Component *comp      = tile->comp   + compno;
-        Jpeg2000CodingStyle *codsty  = tile->codsty + compno;
-        Jpeg2000QuantStyle *quantsty = tile->qntsty + compno;
-
-        int coded = 0;
-        int subbandno = 0;
-
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
-
-        /* Loop on resolution levels */
-        for (reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
-            Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
-            /* Loop on bands */
-            for (bandno = 0; bandno < rlevel->nbands; bandno++, subbandno++) {
-                int nb_precincts, precno;
-                Jpeg2000Band *band = rlevel->band + bandno;
-                int cblkno = 0, bandpos;
-                /* See Rec. ITU-T T.800, Equation E-2 */
-                int M_b = quantsty->expn[subbandno] + quantsty->nguardbits - 1;
-
-                bandpos = bandno + (reslevelno > 0);
-
-                if (band->coord[0][0] == band->coord[0][1] ||
-                    band->coord[1][0] == band->coord[1][1])
-                    continue;
+    for (reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
+        const Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
+        for (bandno = 0; bandno < rlevel->nbands; bandno++, subbandno++) {
+            const Jpeg2000Band *band = rlevel->band + bandno;
 
-                if ((codsty->cblk_style & JPEG2000_CTSY_HTJ2K_F) && M_b >= 31) {
+            if (band->coord[0][0] == band->coord[0][1] ||
+                band->coord[1][0] == band->coord[1][1])
+                continue;
+            /* See Rec. ITU-T T.800, Equation E-2 */
+            if (quantsty->expn[subbandno] + quantsty->nguardbits - 1 >= 31)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * List the code-blocks of all tiles, so that they can be decoded in parallel
+ * regardless of the number of tiles.
+ *
+ * @param jobs array to fill, or NULL to only count the code-blocks
+ * @return number of code-blocks
+ */
+static int list_codeblocks(Jpeg2000DecoderContext *s, Jpeg2000CblkJob *jobs)
+{
+    int tileno, compno, reslevelno, bandno, nb_jobs = 0;
+
+    for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++) {
+        Jpeg2000Tile *tile = s->tile + tileno;
+
+        /* Loop on tile components */
+        for (compno = 0; compno < s->ncomponents; compno++) {
+            Jpeg2000Component *comp      = tile->comp   + compno;
+            Jpeg2000CodingStyle *codsty  = tile->codsty + compno;
+            Jpeg2000QuantStyle *quantsty = tile->qntsty + compno;
+
+            int subbandno = 0;
+
+            tile->coded[compno] = 0;
+
+            /* Leave the whole component uncoded rather than failing the
+             * frame, as when the tiles were decoded one by one. */
+            if (!htj2k_comp_supported(comp, codsty, quantsty)) {
+                if (!jobs)
                     avpriv_request_sample(s->avctx, "JPEG2000_CTSY_HTJ2K_F and M_b >= 31");
-                    return AVERROR_PATCHWELCOME;
-                }
+                continue;
+            }
+
+            /* Loop on resolution levels */
+            for (reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
+                Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
+                /* Loop on bands */
+                for (bandno = 0; bandno < rlevel->nbands; bandno++, subbandno++) {
+                    int nb_precincts, precno;
+                    Jpeg2000Band *band = rlevel->band + bandno;
+                    int cblkno = 0, bandpos;
+                    /* See Rec. ITU-T T.800, Equation E-2 */
+                    int M_b = quantsty->expn[subbandno] + quantsty->nguardbits - 1;
+
+                    bandpos = bandno + (reslevelno > 0);
+
+                    if (band->coord[0][0] == band->coord[0][1] ||
+                        band->coord[1][0] == band->coord[1][1])
+                        continue;
+
+                    if (jobs && codsty->transform == FF_DWT97_INT)
+                        band->i_stepsize = stepsize_int_97(band, M_b);
 
-                nb_precincts = rlevel->num_precincts_x * rlevel->num_precincts_y;
-                /* Loop on precincts */
-                for (precno = 0; precno < nb_precincts; precno++) {
-                    Jpeg2000Prec *prec = band->prec + precno;
-
-                    /* Loop on codeblocks */
-                    for (cblkno = 0;
-                         cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height;
-                         cblkno++) {
-                        int x, y, ret;
-
-                        Jpeg2000Cblk *cblk = prec->cblk + cblkno;
-
-                        if (cblk->modes & JPEG2000_CTSY_HTJ2K_F)
-                            ret = ff_jpeg2000_decode_htj2k(s, codsty, &t1, cblk,
-                                                           cblk->coord[0][1] - cblk->coord[0][0],
-                                                           cblk->coord[1][1] - cblk->coord[1][0],
-                                                           M_b, comp->roi_shift);
-                        else
-                            ret = decode_cblk(s, codsty, &t1, cblk,
-                                              cblk->coord[0][1] - cblk->coord[0][0],
-                                              cblk->coord[1][1] - cblk->coord[1][0],
-                                              bandpos, comp->roi_shift, M_b);
-
-                        if (ret)
-                            coded = 1;
-                        else
+                    nb_precincts = rlevel->num_precincts_x * rlevel->num_precincts_y;
+                    /* Loop on precincts */
+                    for (precno = 0; precno < nb_precincts; precno++) {
+                        Jpeg2000Prec *prec = band->prec + precno;
+                        int nb_cblks = prec->nb_codeblocks_width * prec->nb_codeblocks_height;
+
+                        if (!jobs) {
+                            nb_jobs += nb_cblks;
                             continue;
-                        x = cblk->coord[0][0] - band->coord[0][0];
-                        y = cblk->coord[1][0] - band->coord[1][0];
-
-                        if (codsty->transform == FF_DWT97)
-                            dequantization_float(x, y, cblk, comp, &t1, band, M_b);
-                        else if (codsty->transform == FF_DWT97_INT)
-                            dequantization_int_97(x, y, cblk, comp, &t1, band, M_b);
-                        else
-                            dequantization_int(x, y, cblk, comp, &t1, band, M_b);
-                   } /* end cblk */
-                } /*end prec */
-            } /* end band */
-        } /* end reslevel */
-
-        /* inverse DWT */
-        if (coded)
-            ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
-
-    } /*end comp */
+                        }
+
+                        /* Loop on codeblocks */
+                        for (cblkno = 0; cblkno < nb_cblks; cblkno++) {
+                            Jpeg2000CblkJob *job = jobs + nb_jobs++;
+
+                            job->cblk    = prec->cblk + cblkno;
+                            job->band    = band;
+                            job->tileno  = tileno;
+                            job->compno  = compno;
+                            job->bandpos = bandpos;
+                            job->M_b     = M_b;
+                        }
+                    } /*end prec */
+                } /* end band */
+            } /* end reslevel */
+        } /*end comp */
+    } /*end tile */
+
+    return nb_jobs;
+}
+
+static int jpeg2000_decode_cblk(AVCodecContext *avctx, void *td,
+                                int jobnr, int threadnr)
+{
+    const Jpeg2000DecoderContext *s = avctx->priv_data;
+    Jpeg2000CblkJob *job = s->cblk_jobs + jobnr;
+    Jpeg2000Tile *tile = s->tile + job->tileno;
+    Jpeg2000Component *comp     = tile->comp   + job->compno;
+    Jpeg2000CodingStyle *codsty = tile->codsty + job->compno;
+    Jpeg2000Cblk *cblk = job->cblk;
+    Jpeg2000Band *band = job->band;
+    Jpeg2000T1Context t1;
+    int x, y, ret;
+
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
+
+    if (cblk->modes & JPEG2000_CTSY_HTJ2K_F)
+        ret = ff_jpeg2000_decode_htj2k(s, codsty, &t1, cblk,
+                                       cblk->coord[0][1] - cblk->coord[0][0],
+                                       cblk->coord[1][1] - cblk->coord[1][0],
+                                       job->M_b, comp->roi_shift);
+    else
+        ret = decode_cblk(s, codsty, &t1, cblk,
+                          cblk->coord[0][1] - cblk->coord[0][0],
+                          cblk->coord[1][1] - cblk->coord[1][0],
+                          job->bandpos, comp->roi_shift, job->M_b);
+
+    job->coded = !!ret;
+    if (!ret)
+        return 0;
+
+    x = cblk->coord[0][0] - band->coord[0][0];
+    y = cblk->coord[1][0] - band->coord[1][0];
+
+    if (codsty->transform == FF_DWT97)
+        dequantization_float(x, y, cblk, comp, &t1, band, job->M_b);
+    else if (codsty->transform == FF_DWT97_INT)
+        dequantization_int_97(x, y, cblk, comp, &t1, band, job->M_b);
+    else
+        dequantization_int(x, y, cblk, comp, &t1, band, job->M_b);
+
+    return 0;
+}
+
+static int jpeg2000_dwt_comp(AVCodecContext *avctx, void *td,
+                             int jobnr, int threadnr)
+{
+    const Jpeg2000DecoderContext *s = avctx->priv_data;
+    Jpeg2000Tile *tile = s->tile + jobnr / s->ncomponents;
+    int compno = jobnr % s->ncomponents;
+    Jpeg2000Component *comp     = tile->comp   + compno;
+    Jpeg2000CodingStyle *codsty = tile->codsty + compno;
+
+    /* inverse DWT */
+    if (tile->coded[compno])
+        ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
+
     return 0;
 }
 
@@ -2377,10 +2467,6 @@ static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
     AVFrame *picture = td;
     Jpeg2000Tile *tile = s->tile + jobnr;
 
-    int ret = tile_codeblocks(s, tile);
-    if (ret < 0)
-        return ret;
-
     /* inverse MCT transformation */
     if (tile->codsty[0].mct)
         mct_decode(s, tile);
@@ -2827,6 +2913,16 @@ static av_cold int jpeg2000_decode_init(AVCodecContext *avctx)
     return 0;
 }
 
+static av_cold int jpeg2000_decode_close(AVCodecContext *avctx)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+
+    av_freep(&s->cblk_jobs);
+    s->cblk_jobs_size = 0;
+
+    return 0;
+}
+
 static int jpeg2000_decode_frame(AVCodecContext *avctx, AVFrame *picture,
                                  int *got_frame, AVPacket *avpkt)
 {
@@ -2900,6 +2996,23 @@ static int jpeg2000_decode_frame(AVCodecContext *avctx, AVFrame *picture,
         if (++x == s->ncomponents)
             picture->flags |= AV_FRAME_FLAG_LOSSLESS;
 
+    /* Decode the code-blocks, then run the inverse DWT of each component
+     * and finally convert the tiles, so that a frame made of few tiles
+     * still keeps all the threads busy. */
+    ret = list_codeblocks(s, NULL);
+    av_fast_malloc(&s->cblk_jobs, &s->cblk_jobs_size, (ret + 1) * sizeof(*s->cblk_jobs));
+    if (!s->cblk_jobs) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    s->nb_cblk_jobs = list_codeblocks(s, s->cblk_jobs);
+
+    avctx->execute2(avctx, jpeg2000_decode_cblk, NULL, NULL, s->nb_cblk_jobs);
+    for (int i = 0; i < s->nb_cblk_jobs; i++)
+        s->tile[s->cblk_jobs[i].tileno].coded[s->cblk_jobs[i].compno] |= s->cblk_jobs[i].coded;
+
+    avctx->execute2(avctx, jpeg2000_dwt_comp, NULL, NULL,
+                    s->numXtiles * s->numYtiles * s->ncomponents);
     avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
 
     jpeg2000_dec_cleanup(s);
@@ -2940,6 +3053,7 @@ const FFCodec ff_jpeg2000_decoder = {
     .p.capabilities   = AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_DR1,
     .priv_data_size   = sizeof(Jpeg2000DecoderContext),
     .init             = jpeg2000_decode_init,
+    .close            = jpeg2000_decode_close,
     FF_CODEC_DECODE_CB(jpeg2000_decode_frame),
     .p.priv_class     = &jpeg2000_class,
     .p.max_lowres     = 5,
@@ -46,6 +46,11 @@
 #define I_LFTG_K             80621ll
 #define I_LFTG_X             53274ll
 
+/* The vertical inverse transforms run the lifting steps on DWT_COLS
+ * adjacent columns at once, interleaved in the line buffer, so that the
+ * rows are read and written contiguously and the inner loops vectorise. */
+#define DWT_COLS 16
+
 static inline void extend53(int *p, int i0, int i1)
 {
     p[i0 - 1] = p[i0 + 1];
@@ -324,11 +329,40 @@ static void sr_1d53(unsigned *p, int i0, int i1)
         p[2 * i + 1] += (int)(p[2 * i] + p[2 * i + 2]) >> 1;
 }
 
+static void sr_1d53_cols(int32_t *p, int i0, int i1, int n)
+{
+    int i, c;
+
+#define P(i) ((unsigned *)p)[(i) * DWT_COLS + c]
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (c = 0; c < n; c++)
+                P(1) = (int)P(1) >> 1;
+        return;
+    }
+
+    for (c = 0; c < n; c++) {
+        P(i0 - 1) = P(i0 + 1);
+        P(i1)     = P(i1 - 2);
+        P(i0 - 2) = P(i0 + 2);
+        P(i1 + 1) = P(i1 - 3);
+    }
+
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i) -= (int)(P(2 * i - 1) + P(2 * i + 1) + 2) >> 2;
+    for (i = (i0 >> 1); i < (i1 >> 1); i++)
+        for (c = 0; c < n; c++)
+            P(2 * i + 1) += (int)(P(2 * i) + P(2 * i + 2)) >> 1;
+#undef P
+}
+
 static void dwt_decode53(DWTContext *s, int *t)
 {
     int lev;
     int w     = s->linelen[s->ndeclevels - 1][0];
     int32_t *line = s->i_linebuf;
+    int32_t *cols = s->i_linebuf + 3 * DWT_COLS;
     line += 3;
 
     for (lev = 0; lev < s->ndeclevels; lev++) {
@@ -356,19 +390,23 @@ static void dwt_decode53(DWTContext *s, int *t)
         }
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = cols + mv * DWT_COLS;
+        for (lp = 0; lp < lh; lp += DWT_COLS) {
+            int n = FFMIN(DWT_COLS, lh - lp);
+            int i, c, j = 0;
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
-                l[i] = t[w * j + lp];
+                for (c = 0; c < n; c++)
+                    l[DWT_COLS * i + c] = t[w * j + lp + c];
             for (i = 1 - mv; i < lv; i += 2, j++)
-                l[i] = t[w * j + lp];
+                for (c = 0; c < n; c++)
+                    l[DWT_COLS * i + c] = t[w * j + lp + c];
 
-            sr_1d53(line, mv, mv + lv);
+            sr_1d53_cols(cols, mv, mv + lv, n);
 
             for (i = 0; i < lv; i++)
-                t[w * i + lp] = l[i];
+                for (c = 0; c < n; c++)
+                    t[w * i + lp + c] = l[DWT_COLS * i + c];
         }
     }
 }
@@ -400,11 +438,52 @@ static void sr_1d97_float(float *p, int i0, int i1)
         p[2 * i + 1] += F_LFTG_ALPHA * (p[2 * i]     + p[2 * i + 2]);
 }
 
+static void sr_1d97_float_cols(float *p, int i0, int i1, int n)
+{
+    int i, c;
+
+#define P(i) p[(i) * DWT_COLS + c]
+    if (i1 <= i0 + 1) {
+        for (c = 0; c < n; c++) {
+            if (i0 == 1)
+                P(1) *= F_LFTG_K/2;
+            else
+                P(0) *= F_LFTG_X;
+        }
+        return;
+    }
+
+    for (i = 1; i <= 4; i++) {
+        for (c = 0; c < n; c++) {
+            P(i0 - i)     = P(i0 + i);
+            P(i1 + i - 1) = P(i1 - i - 1);
+        }
+    }
+
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 2; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i)     -= F_LFTG_DELTA * (P(2 * i - 1) + P(2 * i + 1));
+    /* step 4 */
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 1; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i + 1) -= F_LFTG_GAMMA * (P(2 * i)     + P(2 * i + 2));
+    /*step 5*/
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i)     += F_LFTG_BETA  * (P(2 * i - 1) + P(2 * i + 1));
+    /* step 6 */
+    for (i = (i0 >> 1); i < (i1 >> 1); i++)
+        for (c = 0; c < n; c++)
+            P(2 * i + 1) += F_LFTG_ALPHA * (P(2 * i)     + P(2 * i + 2));
+#undef P
+}
+
 static void dwt_decode97_float(DWTContext *s, float *t)
 {
     int lev;
     int w       = s->linelen[s->ndeclevels - 1][0];
     float *line = s->f_linebuf;
+    float *cols = s->f_linebuf + 5 * DWT_COLS;
     float *data = t;
     /* position at index O of line range [0-5,w+5] cf. extend function */
     line += 5;
@@ -433,19 +512,23 @@ static void dwt_decode97_float(DWTContext *s, float *t)
         }
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = cols + mv * DWT_COLS;
+        for (lp = 0; lp < lh; lp += DWT_COLS) {
+            int n = FFMIN(DWT_COLS, lh - lp);
+            int i, c, j = 0;
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                for (c = 0; c < n; c++)
+                    l[DWT_COLS * i + c] = data[w * j + lp + c];
             for (i = 1 - mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                for (c = 0; c < n; c++)
+                    l[DWT_COLS * i + c] = data[w * j + lp + c];
 
-            sr_1d97_float(line, mv, mv + lv);
+            sr_1d97_float_cols(cols, mv, mv + lv, n);
 
             for (i = 0; i < lv; i++)
-                data[w * i + lp] = l[i];
+                for (c = 0; c < n; c++)
+                    data[w * i + lp + c] = l[DWT_COLS * i + c];
         }
     }
 }
@@ -480,6 +563,50 @@ static void sr_1d97_int(int32_t *p, int i0, int i1)
     }
 }
 
+static void sr_1d97_int_cols(int32_t *p, int i0, int i1, int n)
+{
+    int i, c;
+
+#define P(i) p[(i) * DWT_COLS + c]
+    if (i1 <= i0 + 1) {
+        for (c = 0; c < n; c++) {
+            if (i0 == 1)
+                P(1) = (P(1) * I_LFTG_K + (1<<16)) >> 17;
+            else
+                P(0) = (P(0) * I_LFTG_X + (1<<15)) >> 16;
+        }
+        return;
+    }
+
+    for (i = 1; i <= 4; i++) {
+        for (c = 0; c < n; c++) {
+            P(i0 - i)     = P(i0 + i);
+            P(i1 + i - 1) = P(i1 - i - 1);
+        }
+    }
+
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 2; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i)     -= (I_LFTG_DELTA * (P(2 * i - 1) + (int64_t)P(2 * i + 1)) + (1 << 15)) >> 16;
+    /* step 4 */
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 1; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i + 1) -= (I_LFTG_GAMMA * (P(2 * i)     + (int64_t)P(2 * i + 2)) + (1 << 15)) >> 16;
+    /*step 5*/
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        for (c = 0; c < n; c++)
+            P(2 * i)     += (I_LFTG_BETA  * (P(2 * i - 1) + (int64_t)P(2 * i + 1)) + (1 << 15)) >> 16;
+    /* step 6 */
+    for (i = (i0 >> 1); i < (i1 >> 1); i++) {
+        for (c = 0; c < n; c++) {
+            const int64_t sum = P(2 * i) + (int64_t)P(2 * i + 2);
+            P(2 * i + 1) += sum;
+            P(2 * i + 1) += (I_LFTG_ALPHA_PRIME * sum + (1 << 15)) >> 16;
+        }
+    }
+#undef P
+}
+
 static void dwt_decode97_int(DWTContext *s, int32_t *t)
 {
     int lev;
@@ -487,6 +614,7 @@ static void dwt_decode97_int(DWTContext *s, int32_t *t)
     int h       = s->linelen[s->ndeclevels - 1][1];
     int i;
     int32_t *line = s->i_linebuf;
+    int32_t *cols = s->i_linebuf + 5 * DWT_COLS;
     int32_t *data = t;
     /* position at index O of line range [0-5,w+5] cf. extend function */
     line += 5;
@@ -515,19 +643,23 @@ static void dwt_decode97_int(DWTContext *s, int32_t *t)
         }
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = cols + mv * DWT_COLS;
+        for (lp = 0; lp < lh; lp += DWT_COLS) {
+            int n = FFMIN(DWT_COLS, lh - lp);
+            int i, c, j = 0;
             // interleaving
             for (i = mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                for (c = 0; c < n; c++)
+                    l[DWT_COLS * i + c] = data[w * j + lp + c];
             for (i = 1 - mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                for (c = 0; c < n; c++)
+                    l[DWT_COLS * i + c] = data[w * j + lp + c];
 
-            sr_1d97_int(line, mv, mv + lv);
+            sr_1d97_int_cols(cols, mv, mv + lv, n);
 
             for (i = 0; i < lv; i++)
-                data[w * i + lp] = l[i];
+                for (c = 0; c < n; c++)
+                    data[w * i + lp + c] = l[DWT_COLS * i + c];
         }
     }
 
@@ -560,17 +692,17 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
         }
     switch (type) {
     case FF_DWT97:
-        s->f_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->f_linebuf));
+        s->f_linebuf = av_malloc_array((maxlen + 12) * DWT_COLS, sizeof(*s->f_linebuf));
         if (!s->f_linebuf)
             return AVERROR(ENOMEM);
         break;
      case FF_DWT97_INT:
-        s->i_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->i_linebuf));
+        s->i_linebuf = av_malloc_array((maxlen + 12) * DWT_COLS, sizeof(*s->i_linebuf));
         if (!s->i_linebuf)
             return AVERROR(ENOMEM);
         break;
     case FF_DWT53:
-        s->i_linebuf = av_malloc_array((maxlen +  6), sizeof(*s->i_linebuf));
+        s->i_linebuf = av_malloc_array((maxlen +  6) * DWT_COLS, sizeof(*s->i_linebuf));
         if (!s->i_linebuf)
             return AVERROR(ENOMEM);
         break;
@@ -0,0 +1,411 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * HT cleanup pass encoder, the inverse of the cleanup segment decoding in
+ * jpeg2000htdec.c. The MagSgn stream is written forward from the start of
+ * the segment, the MEL and VLC streams are collected separately and the MEL
+ * stream forward / VLC stream backward appended as the segment suffix.
+ */
+
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "jpeg2000htdata.h"
+#include "jpeg2000htenc.h"
+
+#define MAX_SCUP 4079   ///< maximum length of the MEL and VLC streams
+#define NO_EMB   16     ///< vlc_enc index of codewords without e_k bits
+
+/* See Rec. ITU-T T.800, Table 2 */
+static const uint8_t mel_e[13] = { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5 };
+
+/**
+ * CxtVLC codewords by [table][context][rho][u_off][e_1 pattern], each entry
+ * is codeword | length << 7 | e_k << 10, or 0 if there is none. The entries
+ * of index NO_EMB only use codewords without exponent bound bits.
+ */
+static uint16_t vlc_enc[2][8][16][2][17];
+
+typedef struct HTMagSgnWriter {
+    uint8_t *buf;
+    int pos, size;
+    uint32_t tmp;
+    int bits, max_bits;
+} HTMagSgnWriter;
+
+typedef struct HTMelWriter {
+    uint8_t buf[MAX_SCUP + 1];
+    int pos;
+    int tmp, remaining;
+    int k, run;
+} HTMelWriter;
+
+typedef struct HTVlcWriter {
+    uint8_t buf[MAX_SCUP + 1];  ///< bytes in reverse order, buf[0] is the last byte
+    int pos;
+    int tmp, used;
+    int last_gt_8f;
+} HTVlcWriter;
+
+typedef struct HTQuad {
+    uint32_t v[4];      ///< 2 * (mu - 1) + sign of the samples
+    uint8_t  E[4];      ///< exponents, 0 for insignificant samples
+    int rho;            ///< significance pattern
+    int U, u;
+    int emb_k;
+} HTQuad;
+
+av_cold void ff_jpeg2000_ht_init_tables(void)
+{
+    for (int t = 0; t < 2; t++) {
+        const uint16_t *tab = t ? ff_jpeg2000_ht_cxt_vlc_table1 : ff_jpeg2000_ht_cxt_vlc_table0;
+
+        for (int i = 0; i < 1024; i++) {
+            int cw   = i & 0x7F, ctx = i >> 7, v = tab[i];
+            int len  = (v & 0xF) >> 1, u_off = v & 1;
+            int rho  = v >> 4 & 0xF, emb_k = v >> 8 & 0xF, emb_1 = v >> 12;
+            int gain = len - av_popcount(emb_k);
+
+            /* every codeword appears 1 << (7 - len) times */
+            if (!len || cw >> len || emb_k & ~rho || emb_1 & ~emb_k)
+                continue;
+
+            for (int mask = 0; mask <= NO_EMB; mask++) {
+                uint16_t *e = &vlc_enc[t][ctx][rho][u_off][mask];
+
+                if (mask == NO_EMB ? emb_k : emb_1 != (emb_k & mask))
+                    continue;
+                /* each bit of e_k saves one MagSgn bit */
+                if (!*e || gain < (*e >> 7 & 7) - av_popcount(*e >> 10))
+                    *e = cw | len << 7 | emb_k << 10;
+            }
+        }
+    }
+}
+
+static void ms_put(HTMagSgnWriter *ms, uint32_t val, int n)
+{
+    while (n > 0) {
+        int t = FFMIN(n, ms->max_bits - ms->bits);
+
+        ms->tmp  |= (val & ((1 << t) - 1)) << ms->bits;
+        ms->bits += t;
+        val     >>= t;
+        n        -= t;
+        if (ms->bits == ms->max_bits) {
+            if (ms->pos < ms->size)
+                ms->buf[ms->pos] = ms->tmp;
+            ms->pos++;
+            ms->max_bits = ms->tmp == 0xFF ? 7 : 8;
+            ms->tmp  = 0;
+            ms->bits = 0;
+        }
+    }
+}
+
+static void ms_terminate(HTMagSgnWriter *ms)
+{
+    if (ms->bits) {
+        ms->tmp |= (0xFF << ms->bits) & ((1 << ms->max_bits) - 1);
+        if (ms->pos < ms->size)
+            ms->buf[ms->pos] = ms->tmp;
+        ms->pos++;
+    }
+    if (ms->pos > ms->size)
+        return;
+    /* the decoder pads the stream with 0xFF */
+    while (ms->pos > 0 && ms->buf[ms->pos - 1] == 0xFF)
+        ms->pos--;
+}
+
+static void mel_put_bit(HTMelWriter *mel, int bit)
+{
+    mel->tmp = mel->tmp << 1 | bit;
+    if (!--mel->remaining) {
+        if (mel->pos < MAX_SCUP)
+            mel->buf[mel->pos] = mel->tmp;
+        mel->pos++;
+        mel->remaining = mel->tmp == 0xFF ? 7 : 8;
+        mel->tmp = 0;
+    }
+}
+
+static void mel_encode(HTMelWriter *mel, int sym)
+{
+    if (!sym) {
+        if (++mel->run >= 1 << mel_e[mel->k]) {
+            mel_put_bit(mel, 1);
+            mel->run = 0;
+            mel->k   = FFMIN(12, mel->k + 1);
+        }
+    } else {
+        mel_put_bit(mel, 0);
+        for (int t = mel_e[mel->k] - 1; t >= 0; t--)
+            mel_put_bit(mel, mel->run >> t & 1);
+        mel->run = 0;
+        mel->k   = FFMAX(0, mel->k - 1);
+    }
+}
+
+static void mel_terminate(HTMelWriter *mel)
+{
+    int max_bits;
+
+    if (mel->run)
+        mel_put_bit(mel, 1);
+    max_bits = mel->pos && mel->buf[mel->pos - 1] == 0xFF ? 7 : 8;
+    if (mel->remaining < max_bits) {
+        mel->tmp <<= mel->remaining;
+        if (mel->pos < MAX_SCUP)
+            mel->buf[mel->pos] = mel->tmp;
+        mel->pos++;
+    }
+    /* keep the following VLC byte from forming a marker */
+    if (mel->pos && mel->pos < MAX_SCUP && mel->buf[mel->pos - 1] == 0xFF)
+        mel->buf[mel->pos++] = 0;
+}
+
+static void vlc_put(HTVlcWriter *vlc, uint32_t val, int n)
+{
+    for (; n > 0; n--, val >>= 1) {
+        vlc->tmp |= (val & 1) << vlc->used++;
+        if (vlc->used == 8 ||
+            (vlc->used == 7 && vlc->last_gt_8f && vlc->tmp == 0x7F)) {
+            if (vlc->pos < MAX_SCUP)
+                vlc->buf[vlc->pos] = vlc->tmp;
+            vlc->pos++;
+            vlc->last_gt_8f = vlc->tmp > 0x8F;
+            vlc->tmp  = 0;
+            vlc->used = 0;
+        }
+    }
+}
+
+static void vlc_put_u_prefix(HTVlcWriter *vlc, int u)
+{
+    if (u == 1)
+        vlc_put(vlc, 1, 1);
+    else if (u == 2)
+        vlc_put(vlc, 2, 2);
+    else
+        vlc_put(vlc, u < 5 ? 4 : 0, 3);
+}
+
+static void vlc_put_u_suffix(HTVlcWriter *vlc, int u)
+{
+    if (u >= 33)
+        vlc_put(vlc, 28 + (u - 33 & 3), 5);
+    else if (u >= 5)
+        vlc_put(vlc, u - 5, 5);
+    else if (u >= 3)
+        vlc_put(vlc, u - 3, 1);
+}
+
+static void vlc_put_u_ext(HTVlcWriter *vlc, int u)
+{
+    if (u >= 33)
+        vlc_put(vlc, u - 33 >> 2, 4);
+}
+
+static void load_quad(HTQuad *q, const int *src, ptrdiff_t stride,
+                      int width, int height, int x, int y, int shift)
+{
+    q->rho = 0;
+    for (int i = 0; i < 4; i++) {
+        int xx = x + (i >> 1), yy = y + (i & 1);
+        uint32_t mu = 0;
+        int val = 0;
+
+        if (xx < width && yy < height) {
+            val = src[yy * stride + xx];
+            mu  = FFABS(val) >> shift;
+        }
+        if (mu) {
+            q->v[i]  = 2 * (mu - 1) + (val < 0);
+            q->E[i]  = av_log2(2 * mu - 1) + 1;
+            q->rho  |= 1 << i;
+        } else {
+            q->v[i]  = 0;
+            q->E[i]  = 0;
+        }
+    }
+}
+
+/**
+ * Code the significance pattern and the exponent bound bits of a quad.
+ */
+static void code_quad(HTMelWriter *mel, HTVlcWriter *vlc, HTQuad *q,
+                      int table, int ctx, int kappa)
+{
+    int max_e = FFMAX(FFMAX(q->E[0], q->E[1]), FFMAX(q->E[2], q->E[3]));
+    int mask = 0, e;
+
+    q->U     = FFMAX(kappa, max_e);
+    q->u     = q->rho ? q->U - kappa : 0;
+    q->emb_k = 0;
+
+    if (!ctx) {
+        mel_encode(mel, !!q->rho);
+        if (!q->rho)
+            return;
+    }
+
+    /* the decoder ignores samples with no MagSgn bits left */
+    if (q->U > 1) {
+        for (int i = 0; i < 4; i++)
+            mask |= (q->v[i] >> (q->U - 1) & 1) << i;
+    } else
+        mask = NO_EMB;
+
+    e = vlc_enc[table][ctx][q->rho][q->u > 0][mask];
+    vlc_put(vlc, e & 0x7F, e >> 7 & 7);
+    q->emb_k = e >> 10;
+}
+
+static void put_mag_sgn(HTMagSgnWriter *ms, const HTQuad *q)
+{
+    for (int i = 0; i < 4; i++) {
+        int m = (q->rho >> i & 1) * q->U - (q->emb_k >> i & 1);
+
+        if (m > 0)
+            ms_put(ms, q->v[i] & ((1U << m) - 1), m);
+    }
+}
+
+static int initial_context(const HTQuad *q)
+{
+    return ((q->rho | q->rho >> 1) & 1) + (q->rho >> 2 & 1) * 2 + (q->rho >> 3 & 1) * 4;
+}
+
+int ff_jpeg2000_encode_ht_cleanup(uint8_t *dst, int size, const int *src,
+                                  ptrdiff_t stride, int width, int height,
+                                  int shift)
+{
+    HTMagSgnWriter ms = { .buf = dst, .size = size, .max_bits = 8 };
+    HTMelWriter  mel  = { .remaining = 8 };
+    HTVlcWriter  vlc  = { .buf = { 0xFF }, .pos = 1, .tmp = 0xF, .used = 4, .last_gt_8f = 1 };
+    /* exponents of the previous and the current quad row */
+    uint8_t E[2][4 * 512];
+    const int quad_width  = (width  + 1) >> 1;
+    const int quad_height = (height + 1) >> 1;
+    int ctx = 0, sig = 0, scup, lcup;
+
+    for (int qy = 0; qy < quad_height; qy++) {
+        uint8_t *E_n = E[qy & 1] , *E_p = E[!(qy & 1)];
+
+        for (int qx = 0; qx < quad_width; qx += 2) {
+            int nq = FFMIN(2, quad_width - qx);
+            HTQuad q[2];
+
+            for (int j = 0; j < nq; j++) {
+                int n = qx + j, kappa = 1;
+
+                load_quad(&q[j], src, stride, width, height, 2 * n, 2 * qy, shift);
+                memcpy(E_n + 4 * n, q[j].E, 4);
+                sig |= q[j].rho;
+
+                if (qy) {
+                    const uint8_t *a = E_p + 4 * n;
+                    int max_e = FFMAX(a[1], a[3]);
+
+                    ctx = !!a[1] + !!a[3] * 4;
+                    if (n) {
+                        ctx |= !!a[-1];
+                        ctx += (!!E_n[4 * n - 1] | !!E_n[4 * n - 2]) << 1;
+                        max_e = FFMAX(max_e, a[-1]);
+                    }
+                    if (n + 1 < quad_width) {
+                        ctx |= !!a[5] << 2;
+                        max_e = FFMAX(max_e, a[5]);
+                    }
+                    if (av_popcount(q[j].rho) >= 2)
+                        kappa = FFMAX(1, max_e - 1);
+                }
+
+                code_quad(&mel, &vlc, &q[j], qy > 0, ctx, kappa);
+                if (!qy)
+                    ctx = initial_context(&q[j]);
+            }
+
+            if (nq == 2 && q[0].u && q[1].u) {
+                int u0 = q[0].u, u1 = q[1].u;
+
+                if (!qy) {
+                    mel_encode(&mel, u0 > 2 && u1 > 2);
+                    if (u0 > 2 && u1 > 2) {
+                        u0 -= 2;
+                        u1 -= 2;
+                    } else if (u0 > 2) {
+                        vlc_put_u_prefix(&vlc, u0);
+                        vlc_put(&vlc, u1 - 1, 1);
+                        vlc_put_u_suffix(&vlc, u0);
+                        vlc_put_u_ext(&vlc, u0);
+                        u0 = 0;
+                    }
+                }
+                if (u0) {
+                    vlc_put_u_prefix(&vlc, u0);
+                    vlc_put_u_prefix(&vlc, u1);
+                    vlc_put_u_suffix(&vlc, u0);
+                    vlc_put_u_suffix(&vlc, u1);
+                    vlc_put_u_ext(&vlc, u0);
+                    vlc_put_u_ext(&vlc, u1);
+                }
+            } else {
+                for (int j = 0; j < nq; j++) {
+                    if (!q[j].u)
+                        continue;
+                    vlc_put_u_prefix(&vlc, q[j].u);
+                    vlc_put_u_suffix(&vlc, q[j].u);
+                    vlc_put_u_ext(&vlc, q[j].u);
+                }
+            }
+
+            for (int j = 0; j < nq; j++)
+                put_mag_sgn(&ms, &q[j]);
+        }
+    }
+
+    if (!sig)
+        return 0;
+
+    ms_terminate(&ms);
+    mel_terminate(&mel);
+    if (vlc.used) {
+        if (vlc.pos < MAX_SCUP)
+            vlc.buf[vlc.pos] = vlc.tmp;
+        vlc.pos++;
+    }
+
+    scup = mel.pos + vlc.pos;
+    lcup = ms.pos + scup;
+    if (scup > MAX_SCUP || lcup > size)
+        return AVERROR_BUFFER_TOO_SMALL;
+
+    memcpy(dst + ms.pos, mel.buf, mel.pos);
+    for (int i = 0; i < vlc.pos; i++)
+        dst[lcup - 1 - i] = vlc.buf[i];
+    dst[lcup - 1] = scup >> 4;
+    dst[lcup - 2] = (dst[lcup - 2] & 0xF0) | (scup & 0xF);
+
+    return lcup;
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_JPEG2000HTENC_H
+#define AVCODEC_JPEG2000HTENC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * HT block encoder as specified in Rec. ITU-T T.814 | ISO/IEC 15444-15.
+ * Only the HT cleanup pass is produced.
+ */
+
+/**
+ * Build the encoder side CxtVLC tables, must be called once before
+ * ff_jpeg2000_encode_ht_cleanup().
+ */
+void ff_jpeg2000_ht_init_tables(void);
+
+/**
+ * Encode the HT cleanup segment of a code-block.
+ *
+ * @param dst    output buffer
+ * @param size   size of dst in bytes
+ * @param src    signed sample values of the code-block
+ * @param stride distance between two rows of src in samples
+ * @param width  code-block width, the code-block holds at most 4096 samples
+ * @param height code-block height
+ * @param shift  number of least significant magnitude bits to discard
+ * @return the length of the segment, 0 if no sample is significant, or
+ *         a negative error code if the segment does not fit into dst
+ */
+int ff_jpeg2000_encode_ht_cleanup(uint8_t *dst, int size, const int *src,
+                                  ptrdiff_t stride, int width, int height,
+                                  int shift);
+
+#endif /* AVCODEC_JPEG2000HTENC_H */
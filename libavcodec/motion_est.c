@@ -1126,6 +1126,116 @@ int ff_pre_estimate_p_frame_motion(MpegEncContext * s,
     return dmin;
 }
 
+static int coarse_downscale_row(AVCodecContext *avctx, void *arg,
+                                int mb_y, int threadnr)
+{
+    MpegEncContext *const s = arg;
+    const uint8_t *const src[2] = { s->new_pic->data[0], s->last_pic.data[0] };
+
+    for (int i = 0; i < 2; i++)
+        s->mpvencdsp.shrink[1](s->coarse_planes[i] + 8 * mb_y * s->coarse_stride,
+                               s->coarse_stride,
+                               src[i] + 16 * mb_y * s->linesize, s->linesize,
+                               8 * s->mb_width, 8);
+
+    return 0;
+}
+
+#define COARSE_MAX_STEPS 16
+
+#define COARSE_CHECK(cx, cy)                                               \
+    do {                                                                   \
+        const int x1 = av_clip(cx, xmin, xmax);                            \
+        const int y1 = av_clip(cy, ymin, ymax);                            \
+        if (x1 != best_x || y1 != best_y) {                                \
+            const int d = sad(NULL, src, ref + y1 * stride + x1, stride, 8); \
+            if (d < dmin) {                                                \
+                dmin   = d;                                                \
+                best_x = x1;                                               \
+                best_y = y1;                                               \
+            }                                                              \
+        }                                                                  \
+    } while (0)
+
+int ff_me_coarse_search(me_cmp_func sad, const uint8_t *src, const uint8_t *ref,
+                        ptrdiff_t stride, int xmin, int xmax, int ymin, int ymax,
+                        const int (*pred)[2], int nb_pred, int *mx_ptr, int *my_ptr)
+{
+    int best_x = 0, best_y = 0;
+    int dmin = sad(NULL, src, ref, stride, 8);
+
+    for (int i = 0; i < nb_pred; i++)
+        COARSE_CHECK(pred[i][0], pred[i][1]);
+
+    /* large diamond first, then refine with the small one */
+    for (int step = 2; step > 0; step >>= 1) {
+        for (int i = 0; i < COARSE_MAX_STEPS; i++) {
+            const int cx = best_x, cy = best_y;
+            COARSE_CHECK(cx - step, cy);
+            COARSE_CHECK(cx + step, cy);
+            COARSE_CHECK(cx, cy - step);
+            COARSE_CHECK(cx, cy + step);
+            if (best_x == cx && best_y == cy)
+                break;
+        }
+    }
+
+    *mx_ptr = best_x;
+    *my_ptr = best_y;
+    return dmin;
+}
+
+/*
+ * Search one row of macroblocks on the half resolution planes. Only the
+ * left neighbour of the current frame is used as a predictor, the others
+ * come from the previous frame, so that all rows can be searched at once.
+ */
+static int coarse_search_row(AVCodecContext *avctx, void *arg,
+                             int mb_y, int threadnr)
+{
+    MpegEncContext *const s = arg;
+    const int shift  = 2 + s->quarter_sample;
+    const int stride = s->coarse_stride;
+    const int16_t (*last_mv)[2] = s->coarse_last_mv;
+    int mx = 0, my = 0;
+
+    for (int mb_x = 0; mb_x < s->mb_width; mb_x++) {
+        const int xy = mb_x + mb_y * s->mb_stride;
+        const int x  = 8 * mb_x, y = 8 * mb_y;
+        const int last[3] = { xy, xy + 1, xy + s->mb_stride };
+        int pred[4][2] = { { mx, my } };
+
+        for (int i = 0; i < 3; i++) {
+            pred[i + 1][0] = ROUNDED_DIV(last_mv[last[i]][0], 1 << shift);
+            pred[i + 1][1] = ROUNDED_DIV(last_mv[last[i]][1], 1 << shift);
+        }
+
+        ff_me_coarse_search(s->me.pix_abs[1][0],
+                            s->coarse_planes[0] + y * stride + x,
+                            s->coarse_planes[1] + y * stride + x, stride,
+                            -x, 8 * (s->mb_width  - 1) - x,
+                            -y, 8 * (s->mb_height - 1) - y,
+                            pred, 4, &mx, &my);
+
+        s->p_mv_table[xy][0] = mx * (1 << shift);
+        s->p_mv_table[xy][1] = my * (1 << shift);
+    }
+
+    return 0;
+}
+
+void ff_coarse_estimate_p_frame_motion(MpegEncContext *s)
+{
+    AVCodecContext *const avctx = s->avctx;
+
+    /* the vectors of the previous P-frame serve as temporal predictors */
+    memcpy(s->coarse_last_mv_base, s->p_mv_table_base,
+           ((s->mb_height + 2) * s->mb_stride + 1) * sizeof(*s->p_mv_table_base));
+
+    avctx->execute2(avctx, coarse_downscale_row, s, NULL, s->mb_height);
+    avctx->execute2(avctx, coarse_search_row,    s, NULL, s->mb_height);
+}
+
 static int estimate_motion_b(MpegEncContext *s, int mb_x, int mb_y,
                              int16_t (*mv_table)[2], int ref_index, int f_code)
 {
@@ -128,6 +128,25 @@ void ff_estimate_b_frame_motion(struct MpegEncContext *s, int mb_x, int mb_y);
 int ff_pre_estimate_p_frame_motion(struct MpegEncContext *s,
                                    int mb_x, int mb_y);
 
+/**
+ * Estimate coarse motion vectors for a whole P-frame on half resolution
+ * luma planes and store them in p_mv_table, where the full resolution
+ * search picks them up as predictors. All macroblock rows are searched
+ * in parallel.
+ */
+void ff_coarse_estimate_p_frame_motion(struct MpegEncContext *s);
+
+/**
+ * Search the best full pel position of an 8x8 block, starting from the
+ * given predictors and refining with a diamond search.
+ *
+ * @param xmin, xmax, ymin, ymax  allowed vector range
+ * @return the SAD of the best position, which is stored in mx_ptr/my_ptr
+ */
+int ff_me_coarse_search(me_cmp_func sad, const uint8_t *src, const uint8_t *ref,
+                        ptrdiff_t stride, int xmin, int xmax, int ymin, int ymax,
+                        const int (*pred)[2], int nb_pred, int *mx_ptr, int *my_ptr);
+
 int ff_epzs_motion_search(struct MpegEncContext *s, int *mx_ptr, int *my_ptr,
                           int P[10][2], int src_index, int ref_index,
                           const int16_t (*last_mv)[2], int ref_mv_scale,
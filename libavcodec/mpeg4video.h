@@ -52,7 +52,8 @@ int ff_mpeg4_set_direct_mv(MpegEncContext *s, int mx, int my);
 static inline int ff_mpeg4_pred_dc(MpegEncContext *s, int n, int level,
                                    int *dir_ptr, int encoding)
 {
-    int a, b, c, wrap, pred, scale, ret;
+    int a = 1024, b = 1024, c = 1024, wrap, pred, scale, ret;
+    int top_out, left_out;
     int16_t *dc_val;
 
     /* find prediction */
@@ -69,22 +70,20 @@ static inline int ff_mpeg4_pred_dc(MpegEncContext *s, int n, int level,
     /* B C
      * A X
      */
-    a = dc_val[-1];
-    b = dc_val[-1 - wrap];
-    c = dc_val[-wrap];
-
     /* outside slice handling (we can't do that by memset as we need the
-     * dc for error resilience) */
-    if (s->first_slice_line && n != 3) {
-        if (n != 2)
-            b = c = 1024;
-        if (n != 1 && s->mb_x == s->resync_mb_x)
-            b = a = 1024;
-    }
-    if (s->mb_x == s->resync_mb_x && s->mb_y == s->resync_mb_y + 1) {
-        if (n == 0 || n == 4 || n == 5)
-            b = 1024;
-    }
+     * dc for error resilience); neighbours in a previous video packet are
+     * not even loaded, they may belong to another slice thread */
+    top_out  = s->first_slice_line && n != 2 && n != 3;
+    left_out = s->first_slice_line && n != 1 && n != 3 &&
+               s->mb_x == s->resync_mb_x;
+    if (!left_out)
+        a = dc_val[-1];
+    if (!top_out)
+        c = dc_val[-wrap];
+    if (!top_out && !left_out &&
+        !(s->mb_x == s->resync_mb_x && s->mb_y == s->resync_mb_y + 1 &&
+          (n == 0 || n == 4 || n == 5)))
+        b = dc_val[-1 - wrap];
 
     if (abs(a - b) < abs(b - c)) {
         pred     = c;
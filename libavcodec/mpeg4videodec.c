@@ -309,6 +309,9 @@ void ff_mpeg4_decode_studio(MpegEncContext *s, uint8_t *dest_y, uint8_t *dest_cb
 
 /**
  * Predict the ac.
+ * Neighbours in a previous video packet predict as zero, which is what
+ * ff_mpeg4_clean_buffers() leaves there; skipping them explicitly means
+ * slice threads never read AC values owned by another thread.
  * @param n block index (0-3 are luma, 4-5 are chroma)
  * @param dir the ac prediction direction
  */
@@ -327,7 +330,10 @@ void ff_mpeg4_pred_ac(MpegEncContext *s, int16_t *block, int n, int dir)
             /* left prediction */
             ac_val -= 16;
 
-            if (s->mb_x == 0 || s->qscale == qscale_table[xy] ||
+            if (n != 1 && n != 3 &&
+                s->mb_x == s->resync_mb_x && s->mb_y == s->resync_mb_y) {
+                /* left MB is in the previous video packet */
+            } else if (s->mb_x == 0 || s->qscale == qscale_table[xy] ||
                 n == 1 || n == 3) {
                 /* same qscale */
                 for (i = 1; i < 8; i++)
@@ -342,7 +348,9 @@ void ff_mpeg4_pred_ac(MpegEncContext *s, int16_t *block, int n, int dir)
             /* top prediction */
             ac_val -= 16 * s->block_wrap[n];
 
-            if (s->mb_y == 0 || s->qscale == qscale_table[xy] ||
+            if (n != 2 && n != 3 && s->first_slice_line) {
+                /* top MB is in the previous video packet */
+            } else if (s->mb_y == 0 || s->qscale == qscale_table[xy] ||
                 n == 2 || n == 3) {
                 /* same qscale */
                 for (i = 1; i < 8; i++)
@@ -367,9 +375,9 @@ void ff_mpeg4_pred_ac(MpegEncContext *s, int16_t *block, int n, int dir)
  * check if the next stuff is a resync marker or the end.
  * @return 0 if not
  */
-static inline int mpeg4_is_resync(Mpeg4DecContext *ctx)
+static inline int mpeg4_is_resync(MpegEncContext *s)
 {
-    MpegEncContext *s = &ctx->m;
+    const Mpeg4DecContext *ctx = s->avctx->priv_data;
     int bits_count = get_bits_count(&s->gb);
     int v          = show_bits(&s->gb, 16);
 
@@ -692,10 +700,9 @@ static int decode_new_pred(Mpeg4DecContext *ctx, GetBitContext *gb) {
  * Decode the next video packet.
  * @return <0 if something went wrong
  */
-int ff_mpeg4_decode_video_packet_header(Mpeg4DecContext *ctx)
+int ff_mpeg4_decode_video_packet_header(MpegEncContext *s)
 {
-    MpegEncContext *s = &ctx->m;
-
+    Mpeg4DecContext *ctx = s->avctx->priv_data;
     int mb_num_bits      = av_log2(s->mb_num - 1) + 1;
     int header_extension = 0, mb_num, len;
 
@@ -833,9 +840,9 @@ int ff_mpeg4_decode_studio_slice_header(Mpeg4DecContext *ctx)
  * @param n either 0 for the x component or 1 for y
  * @return the average MV for a GMC MB
  */
-static inline int get_amv(Mpeg4DecContext *ctx, int n)
+static inline int get_amv(MpegEncContext *s, int n)
 {
-    MpegEncContext *s = &ctx->m;
+    const Mpeg4DecContext *ctx = s->avctx->priv_data;
     int x, y, mb_v, sum, dx, dy, shift;
     int len     = 1 << (s->f_code + 4);
     const int a = ctx->sprite_warping_accuracy;
@@ -1010,8 +1017,8 @@ try_again:
                                                          MB_TYPE_16x16 |
                                                          MB_TYPE_GMC   |
                                                          MB_TYPE_FORWARD_MV;
-                        mx = get_amv(ctx, 0);
-                        my = get_amv(ctx, 1);
+                        mx = get_amv(s, 0);
+                        my = get_amv(s, 1);
                     } else {
                         s->cur_pic.mb_type[xy] = MB_TYPE_SKIP  |
                                                          MB_TYPE_16x16 |
@@ -1082,8 +1089,8 @@ try_again:
                             s->cur_pic.mb_type[xy] = MB_TYPE_16x16 |
                                                              MB_TYPE_FORWARD_MV;
                         } else {
-                            mx = get_amv(ctx, 0);
-                            my = get_amv(ctx, 1);
+                            mx = get_amv(s, 0);
+                            my = get_amv(s, 1);
                             s->cur_pic.mb_type[xy] = MB_TYPE_16x16 |
                                                              MB_TYPE_GMC   |
                                                              MB_TYPE_FORWARD_MV;
@@ -1285,11 +1292,10 @@ int ff_mpeg4_decode_partitions(Mpeg4DecContext *ctx)
  * Decode a block.
  * @return <0 if an error occurred
  */
-static inline int mpeg4_decode_block(Mpeg4DecContext *ctx, int16_t *block,
+static inline int mpeg4_decode_block(MpegEncContext *s, int16_t *block,
                                      int n, int coded, int intra,
                                      int use_intra_dc_vlc, int rvlc)
 {
-    MpegEncContext *s = &ctx->m;
     int level, i, last, run, qmul, qadd;
     int av_uninit(dc_pred_dir);
     const RLTable *rl;
@@ -1559,12 +1565,10 @@ not_coded:
  */
 static int mpeg4_decode_partitioned_mb(MpegEncContext *s, int16_t block[6][64])
 {
-    Mpeg4DecContext *ctx = s->avctx->priv_data;
+    const Mpeg4DecContext *ctx = s->avctx->priv_data;
     int cbp, mb_type, use_intra_dc_vlc;
     const int xy = s->mb_x + s->mb_y * s->mb_stride;
 
-    av_assert2(s == (void*)ctx);
-
     mb_type = s->cur_pic.mb_type[xy];
     cbp     = s->cbp_table[xy];
 
@@ -1620,7 +1624,7 @@ static int mpeg4_decode_partitioned_mb(MpegEncContext *s, int16_t block[6][64])
         s->bdsp.clear_blocks(s->block[0]);
         /* decode each block */
         for (i = 0; i < 6; i++) {
-            if (mpeg4_decode_block(ctx, block[i], i, cbp & 32, s->mb_intra,
+            if (mpeg4_decode_block(s, block[i], i, cbp & 32, s->mb_intra,
                                    use_intra_dc_vlc, ctx->rvlc) < 0) {
                 av_log(s->avctx, AV_LOG_ERROR,
                        "texture corrupted at %d %d %d\n",
@@ -1633,12 +1637,12 @@ static int mpeg4_decode_partitioned_mb(MpegEncContext *s, int16_t block[6][64])
 
     /* per-MB end of slice check */
     if (--s->mb_num_left <= 0) {
-        if (mpeg4_is_resync(ctx))
+        if (mpeg4_is_resync(s))
             return SLICE_END;
         else
             return SLICE_NOEND;
     } else {
-        if (mpeg4_is_resync(ctx)) {
+        if (mpeg4_is_resync(s)) {
             const int delta = s->mb_x + 1 == s->mb_width ? 2 : 1;
             if (s->cbp_table[xy + delta])
                 return SLICE_END;
@@ -1649,13 +1653,12 @@ static int mpeg4_decode_partitioned_mb(MpegEncContext *s, int16_t block[6][64])
 
 static int mpeg4_decode_mb(MpegEncContext *s, int16_t block[6][64])
 {
-    Mpeg4DecContext *ctx = s->avctx->priv_data;
+    const Mpeg4DecContext *ctx = s->avctx->priv_data;
     int cbpc, cbpy, i, cbp, pred_x, pred_y, mx, my, dquant;
     static const int8_t quant_tab[4] = { -1, -2, 1, 2 };
     const int xy = s->mb_x + s->mb_y * s->mb_stride;
     int next;
 
-    av_assert2(s ==  (void*)ctx);
     av_assert2(s->h263_pred);
 
     if (s->pict_type == AV_PICTURE_TYPE_P ||
@@ -1675,8 +1678,8 @@ static int mpeg4_decode_mb(MpegEncContext *s, int16_t block[6][64])
                                                      MB_TYPE_16x16 |
                                              MB_TYPE_FORWARD_MV;
                     s->mcsel       = 1;
-                    s->mv[0][0][0] = get_amv(ctx, 0);
-                    s->mv[0][0][1] = get_amv(ctx, 1);
+                    s->mv[0][0][0] = get_amv(s, 0);
+                    s->mv[0][0][1] = get_amv(s, 1);
                     s->cur_pic.mbskip_table[xy] = 0;
                     s->mb_skipped  = 0;
                 } else {
@@ -1730,8 +1733,8 @@ static int mpeg4_decode_mb(MpegEncContext *s, int16_t block[6][64])
                                          MB_TYPE_FORWARD_MV;
                 /* 16x16 global motion prediction */
                 s->mv_type     = MV_TYPE_16X16;
-                mx             = get_amv(ctx, 0);
-                my             = get_amv(ctx, 1);
+                mx             = get_amv(s, 0);
+                my             = get_amv(s, 1);
                 s->mv[0][0][0] = mx;
                 s->mv[0][0][1] = my;
             } else if ((!s->progressive_sequence) && get_bits1(&s->gb)) {
@@ -1986,7 +1989,7 @@ intra:
         s->bdsp.clear_blocks(s->block[0]);
         /* decode each block */
         for (i = 0; i < 6; i++) {
-            if (mpeg4_decode_block(ctx, block[i], i, cbp & 32,
+            if (mpeg4_decode_block(s, block[i], i, cbp & 32,
                                    1, use_intra_dc_vlc, 0) < 0)
                 return AVERROR_INVALIDDATA;
             cbp += cbp;
@@ -1996,14 +1999,14 @@ intra:
 
     /* decode each block */
     for (i = 0; i < 6; i++) {
-        if (mpeg4_decode_block(ctx, block[i], i, cbp & 32, 0, 0, 0) < 0)
+        if (mpeg4_decode_block(s, block[i], i, cbp & 32, 0, 0, 0) < 0)
             return AVERROR_INVALIDDATA;
         cbp += cbp;
     }
 
 end:
     /* per-MB end of slice check */
-    next = mpeg4_is_resync(ctx);
+    next = mpeg4_is_resync(s);
     if (next) {
         if        (s->mb_x + s->mb_y*s->mb_width + 1 >  next && (s->avctx->err_recognition & AV_EF_AGGRESSIVE)) {
             return AVERROR_INVALIDDATA;
@@ -3842,7 +3845,8 @@ const FFCodec ff_mpeg4_decoder = {
     FF_CODEC_DECODE_CB(ff_h263_decode_frame),
     .close                 = ff_mpv_decode_close,
     .p.capabilities        = AV_CODEC_CAP_DRAW_HORIZ_BAND | AV_CODEC_CAP_DR1 |
-                             AV_CODEC_CAP_DELAY | AV_CODEC_CAP_FRAME_THREADS,
+                             AV_CODEC_CAP_DELAY | AV_CODEC_CAP_FRAME_THREADS |
+                             AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal         = FF_CODEC_CAP_INIT_CLEANUP |
                              FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
     .flush                 = ff_mpeg_flush,
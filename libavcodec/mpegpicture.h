@@ -82,6 +82,7 @@ typedef struct MPVPicture {
     int field_picture;          ///< whether or not the picture was encoded in separate fields
 
     int b_frame_score;
+    int64_t rc_cplx[2];         ///< intra and inter complexity estimated by the rate control lookahead
 
     int reference;
     int shared;
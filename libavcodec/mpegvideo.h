@@ -49,6 +49,7 @@
 #define MAX_THREADS 32
 
 #define MAX_B_FRAMES 16
+#define MAX_RC_LOOKAHEAD 48
 
 /**
  * Scantable.
@@ -257,6 +258,11 @@ typedef struct MpegEncContext {
     int motion_est;                      ///< ME algorithm
     int me_penalty_compensation;
     int me_pre;                          ///< prepass for motion estimation
+    int me_pre_coarse;                   ///< half resolution prepass for motion estimation
+    uint8_t *coarse_planes[2];           ///< half resolution luma of the current and the reference picture
+    int coarse_stride;
+    int16_t (*coarse_last_mv_base)[2];
+    int16_t (*coarse_last_mv)[2];        ///< copy of p_mv_table of the previous P-frame for the coarse prepass
     int mv_dir;
 #define MV_DIR_FORWARD   1
 #define MV_DIR_BACKWARD  2
@@ -351,6 +357,8 @@ typedef struct MpegEncContext {
     int resync_mb_y;                 ///< y position of last resync marker
     GetBitContext last_resync_gb;    ///< used to search for the next resync marker
     int mb_num_left;                 ///< number of MBs left in this video packet (for partitioned Slices only)
+    int slice_start_mb;              ///< first MB (mb_x + mb_y * mb_width) decoded by this slice thread
+    int slice_end_mb;                ///< first MB not decoded by this slice thread anymore
 
     /* H.263 specific */
     int gob_index;
@@ -524,6 +532,7 @@ typedef struct MpegEncContext {
     int vbv_ignore_qmax;
 
     char *rc_eq;
+    int rc_lookahead;
 
     /* temp buffers for rate control */
     float *cplx_tab, *bits_tab;
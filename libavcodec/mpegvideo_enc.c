@@ -840,6 +840,18 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
         return AVERROR(EINVAL);
     }
 
+    if (s->rc_lookahead) {
+        if (!(avctx->codec->capabilities & AV_CODEC_CAP_DELAY) ||
+            !avctx->rc_buffer_size || !avctx->rc_max_rate ||
+            (avctx->flags & AV_CODEC_FLAG_PASS2)) {
+            av_log(avctx, AV_LOG_WARNING,
+                   "rc_lookahead needs a VBV buffer, 1-pass encoding and an "
+                   "encoder supporting delay, disabling it\n");
+            s->rc_lookahead = 0;
+        }
+        avctx->delay += s->rc_lookahead;
+    }
+
     avctx->has_b_frames = !s->low_delay;
 
     s->encoding = 1;
@@ -873,7 +885,7 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
         !FF_ALLOCZ_TYPED_ARRAY(s->q_intra_matrix16,        32) ||
         !FF_ALLOCZ_TYPED_ARRAY(s->q_chroma_intra_matrix16, 32) ||
         !FF_ALLOCZ_TYPED_ARRAY(s->q_inter_matrix16,        32) ||
-        !FF_ALLOCZ_TYPED_ARRAY(s->input_picture,           MAX_B_FRAMES + 1) ||
+        !FF_ALLOCZ_TYPED_ARRAY(s->input_picture,           MAX_B_FRAMES + 1 + MAX_RC_LOOKAHEAD) ||
         !FF_ALLOCZ_TYPED_ARRAY(s->reordered_input_picture, MAX_B_FRAMES + 1) ||
         !(s->new_pic = av_frame_alloc()) ||
         !(s->picture_pool = ff_mpv_alloc_pic_pool(0)))
@@ -896,6 +908,16 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
     s->b_bidir_back_mv_table = s->b_bidir_back_mv_table_base + s->mb_stride + 1;
     s->b_direct_mv_table     = s->b_direct_mv_table_base + s->mb_stride + 1;
 
+    if (s->me_pre_coarse) {
+        s->coarse_stride = 8 * s->mb_width;
+        for (int i = 0; i < 2; i++)
+            if (!(s->coarse_planes[i] = av_malloc(s->coarse_stride * 8 * s->mb_height)))
+                return AVERROR(ENOMEM);
+        if (!FF_ALLOCZ_TYPED_ARRAY(s->coarse_last_mv_base, mv_table_size))
+            return AVERROR(ENOMEM);
+        s->coarse_last_mv = s->coarse_last_mv_base + s->mb_stride + 1;
+    }
+
     /* Allocate MB type table */
     mb_array_size = s->mb_stride * s->mb_height;
     if (!FF_ALLOCZ_TYPED_ARRAY(s->mb_type,      mb_array_size) ||
@@ -1049,10 +1071,10 @@ av_cold int ff_mpv_encode_end(AVCodecContext *avctx)
     av_refstruct_pool_uninit(&s->picture_pool);
 
     if (s->input_picture && s->reordered_input_picture) {
-        for (int i = 0; i < MAX_B_FRAMES + 1; i++) {
+        for (int i = 0; i < MAX_B_FRAMES + 1 + MAX_RC_LOOKAHEAD; i++)
             av_refstruct_unref(&s->input_picture[i]);
+        for (int i = 0; i < MAX_B_FRAMES + 1; i++)
             av_refstruct_unref(&s->reordered_input_picture[i]);
-        }
     }
     for (i = 0; i < FF_ARRAY_ELEMS(s->tmp_frames); i++)
         av_frame_free(&s->tmp_frames[i]);
@@ -1068,6 +1090,9 @@ av_cold int ff_mpv_encode_end(AVCodecContext *avctx)
     av_freep(&s->b_bidir_back_mv_table_base);
     av_freep(&s->b_direct_mv_table_base);
     av_freep(&s->b_field_mv_table_base);
+    av_freep(&s->coarse_planes[0]);
+    av_freep(&s->coarse_planes[1]);
+    av_freep(&s->coarse_last_mv_base);
     av_freep(&s->b_field_select_table[0][0]);
     av_freep(&s->p_field_select_table[0]);
 
@@ -1193,8 +1218,8 @@ static int load_input_picture(MpegEncContext *s, const AVFrame *pic_arg)
     MPVPicture *pic = NULL;
     int64_t pts;
     int display_picture_number = 0, ret;
-    int encoding_delay = s->max_b_frames ? s->max_b_frames
-                                         : (s->low_delay ? 0 : 1);
+    int encoding_delay = (s->max_b_frames ? s->max_b_frames
+                                          : (s->low_delay ? 0 : 1)) + s->rc_lookahead;
     int flush_offset = 1;
     int direct = 1;
 
@@ -1301,6 +1326,10 @@ static int load_input_picture(MpegEncContext *s, const AVFrame *pic_arg)
 
         pic->display_picture_number = display_picture_number;
         pic->f->pts = pts; // we set this here to avoid modifying pic_arg
+
+        /* the lookahead implies a VBV buffer, so there is no INPLACE_OFFSET */
+        if (s->rc_lookahead)
+            ff_rate_control_lookahead(s, pic, pic->f->data[0]);
     } else if (!s->reordered_input_picture[1]) {
         /* Flushing: When the above check is true, the encoder is about to run
          * out of frames to encode. Check if there are input_pictures left;
@@ -1315,9 +1344,10 @@ static int load_input_picture(MpegEncContext *s, const AVFrame *pic_arg)
     }
 
     /* shift buffer entries */
-    for (int i = flush_offset; i <= MAX_B_FRAMES; i++)
+    for (int i = flush_offset; i <= MAX_B_FRAMES + MAX_RC_LOOKAHEAD; i++)
         s->input_picture[i - flush_offset] = s->input_picture[i];
-    for (int i = MAX_B_FRAMES + 1 - flush_offset; i <= MAX_B_FRAMES; i++)
+    for (int i = MAX_B_FRAMES + MAX_RC_LOOKAHEAD + 1 - flush_offset;
+         i <= MAX_B_FRAMES + MAX_RC_LOOKAHEAD; i++)
         s->input_picture[i] = NULL;
 
     s->input_picture[encoding_delay] = pic;
@@ -3668,6 +3698,8 @@ static int encode_picture(MpegEncContext *s, const AVPacket *pkt)
         s->lambda  = (s->lambda  * s->me_penalty_compensation + 128) >> 8;
         s->lambda2 = (s->lambda2 * (int64_t) s->me_penalty_compensation + 128) >> 8;
         if (s->pict_type != AV_PICTURE_TYPE_B) {
+            if (s->me_pre_coarse)
+                ff_coarse_estimate_p_frame_motion(s);
             if ((s->me_pre && s->last_non_b_pict_type == AV_PICTURE_TYPE_I) ||
                 s->me_pre == 2) {
                 s->avctx->execute(s->avctx, pre_estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
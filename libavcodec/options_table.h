@@ -409,6 +409,10 @@ static const AVOption avcodec_options[] = {
 {"unsafe_output", "allow potentially unsafe hwaccel frame output that might require special care to process successfully", 0, AV_OPT_TYPE_CONST, {.i64 = AV_HWACCEL_FLAG_UNSAFE_OUTPUT }, INT_MIN, INT_MAX, V | D, .unit = "hwaccel_flags"},
 {"extra_hw_frames", "Number of extra hardware frames to allocate for the user", OFFSET(extra_hw_frames), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, INT_MAX, V|D },
 {"discard_damaged_percentage", "Percentage of damaged samples to discard a frame", OFFSET(discard_damaged_percentage), AV_OPT_TYPE_INT, {.i64 = 95 }, 0, 100, V|D },
+{"frame_pool_reuse", "keep frame buffer pools across resolution changes", OFFSET(frame_pool_reuse), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, V|D },
+{"frame_pool_max_bytes", "maximum memory for frame buffers, 0 for no limit", OFFSET(frame_pool_max_bytes), AV_OPT_TYPE_INT64, {.i64 = 0 }, 0, INT64_MAX, V|D },
+{"frame_pool_hits", "number of frame buffers reused from the pool", OFFSET(frame_pool_hits), AV_OPT_TYPE_INT64, {.i64 = 0 }, 0, INT64_MAX, V|D|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
+{"frame_pool_misses", "number of frame buffers allocated for the pool", OFFSET(frame_pool_misses), AV_OPT_TYPE_INT64, {.i64 = 0 }, 0, INT64_MAX, V|D|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
 {"side_data_prefer_packet", "Comma-separated list of side data types for which user-supplied (container) data is preferred over coded bytestream",
     OFFSET(side_data_prefer_packet), AV_OPT_TYPE_INT | AR, .min = -1, .max = INT_MAX, .flags = V|A|S|D, .unit = "side_data_pkt" },
     {"replaygain",                  .default_val.i64 = AV_PKT_DATA_REPLAYGAIN,                  .type = AV_OPT_TYPE_CONST, .flags = A|D, .unit = "side_data_pkt" },
@@ -399,21 +399,44 @@ static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
     s->dual_stereo_used += td2 < td1;
 }
 
+typedef struct IntensityTrials {
+    OpusPsyContext *s;
+    const CeltFrame *f;
+    float dist[CELT_MAX_BANDS + 1];
+} IntensityTrials;
+
+/* Every candidate starts from the same frame state, so that the result
+ * does not depend on the order in which they are evaluated. */
+static int intensity_trial(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    IntensityTrials *t = arg;
+    OpusPsyContext *s = t->s;
+    CeltFrame *f = &s->trial_frames[threadnr];
+    int band = t->f->end_band - jobnr;
+
+    memcpy(f, t->f, sizeof(*f));
+    f->pvq = s->trial_pvq[threadnr];
+    f->intensity_stereo = band;
+    bands_dist(s, f, &t->dist[band]);
+
+    return 0;
+}
+
 static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
 {
+    IntensityTrials t = { .s = s, .f = f };
     int i, best_band = CELT_MAX_BANDS - 1;
-    float dist, best_dist = FLT_MAX;
+    float best_dist = FLT_MAX;
     /* TODO: fix, make some heuristic up here using the lambda value */
     float end_band = 0;
 
     if (s->avctx->ch_layout.nb_channels < 2)
         return;
 
+    s->avctx->execute2(s->avctx, intensity_trial, &t, NULL, f->end_band + 1);
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
-        if (best_dist > dist) {
-            best_dist = dist;
+        if (best_dist > t.dist[i]) {
+            best_dist = t.dist[i];
             best_band = i;
         }
     }
@@ -513,6 +536,15 @@ void ff_opus_psy_postencode_update(OpusPsyContext *s, CeltFrame *f)
     s->inflection_points_count = 0;
 }
 
+static av_cold void free_trials(OpusPsyContext *s)
+{
+    for (int i = 0; i < s->nb_trials; i++)
+        ff_celt_pvq_uninit(&s->trial_pvq[i]);
+    s->nb_trials = 0;
+    av_freep(&s->trial_pvq);
+    av_freep(&s->trial_frames);
+}
+
 av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
                              struct FFBufQueue *bufqueue, OpusEncOptions *options)
 {
@@ -554,6 +586,25 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
         }
     }
 
+    /* The intensity stereo trials always run on scratch frames, so that
+     * the frame being encoded is the same for any number of threads. */
+    if (avctx->ch_layout.nb_channels > 1) {
+        int nb_trials = avctx->active_thread_type & FF_THREAD_SLICE ?
+                        avctx->thread_count : 1;
+
+        s->trial_frames = av_malloc_array(nb_trials, sizeof(*s->trial_frames));
+        s->trial_pvq    = av_calloc(nb_trials, sizeof(*s->trial_pvq));
+        if (!s->trial_frames || !s->trial_pvq) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        for (i = 0; i < nb_trials; i++) {
+            if ((ret = ff_celt_pvq_init(&s->trial_pvq[i], 1)) < 0)
+                goto fail;
+            s->nb_trials++;
+        }
+    }
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         float tmp;
         const int len = OPUS_BLOCK_SIZE(i);
@@ -575,6 +626,7 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
 fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
+    free_trials(s);
 
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         av_tx_uninit(&s->mdct[i]);
@@ -598,6 +650,7 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
 
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
+    free_trials(s);
 
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         av_tx_uninit(&s->mdct[i]);
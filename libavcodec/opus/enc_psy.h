@@ -69,6 +69,11 @@ typedef struct OpusPsyContext {
 
     DECLARE_ALIGNED(32, float, scratch)[2048];
 
+    /* Per thread scratch state for the intensity stereo search */
+    CeltFrame *trial_frames;
+    struct CeltPVQ **trial_pvq;
+    int nb_trials;
+
     /* Stats */
     float avg_is_band;
     int64_t dual_stereo_used;
@@ -30,6 +30,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/crc.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/csp.h"
 #include "libavutil/libm.h"
 #include "libavutil/mastering_display_metadata.h"
@@ -41,6 +42,10 @@
 #include <zlib.h>
 
 #define IOBUF_SIZE 4096
+/* Minimum amount of filtered data deflated by one job with slice threading,
+ * like the pigz block size. */
+#define CHUNK_SIZE (128 * 1024)
+#define DICT_SIZE  (32 * 1024)
 
 typedef struct APNGFctlChunk {
     uint32_t sequence_number;
@@ -62,6 +67,23 @@ typedef struct PNGEncContext {
 
     FFZStream zstream;
     uint8_t buf[IOBUF_SIZE];
+    int compression_level;
+
+    // slice threading
+    FFZStream *chunk_zstreams;   ///< raw deflate streams, one per thread
+    int nb_chunk_zstreams;
+    uint8_t *filter_bufs;        ///< filtering scratch, one per thread
+    int filter_buf_size;
+    uint8_t *filtered;           ///< filtered rows, each with its filter byte
+    unsigned int filtered_size;
+    uint8_t *chunk_buf;          ///< deflated chunks, chunk_buf_stride apart
+    unsigned int chunk_buf_size;
+    int chunk_buf_stride;
+    int chunk_rows;
+    int *chunk_len;
+    uLong *chunk_adler;
+    int *chunk_ret;              ///< return codes of the chunk jobs
+    unsigned int chunk_len_size, chunk_adler_size, chunk_ret_size;
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
 
@@ -196,6 +218,33 @@ static void png_filter_row(PNGEncContext *c, uint8_t *dst, int filter_type,
     }
 }
 
+/* sum of the absolute values of the bytes taken as signed, 8 at a time */
+static int png_filter_cost(const uint8_t *buf, int size)
+{
+    const uint64_t lsb = 0x0101010101010101ULL;
+    const uint64_t low = 0x00FF00FF00FF00FFULL;
+    int cost = 0, i = 0;
+
+    while (size - i >= 8) {
+        uint64_t acc = 0;
+        // each 16 bit lane grows by at most 256 per step
+        int end = i + 8 * FFMIN((size - i) >> 3, 255);
+
+        for (; i < end; i += 8) {
+            uint64_t v = AV_RN64(buf + i);
+            uint64_t m = v >> 7 & lsb;
+
+            v = (v ^ m * 0xFF) + m;
+            acc += (v & low) + (v >> 8 & low);
+        }
+        acc = (acc & 0x0000FFFF0000FFFFULL) + (acc >> 16 & 0x0000FFFF0000FFFFULL);
+        cost += (acc + (acc >> 32)) & 0xFFFFFFFF;
+    }
+    for (; i < size; i++)
+        cost += abs((int8_t) buf[i]);
+    return cost;
+}
+
 static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
                                   const uint8_t *src, const uint8_t *top, int size, int bpp)
 {
@@ -204,15 +253,12 @@ static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
     if (!top && pred)
         pred = PNG_FILTER_VALUE_SUB;
     if (pred == PNG_FILTER_VALUE_MIXED) {
-        int i;
         int cost, bcost = INT_MAX;
         uint8_t *buf1 = dst, *buf2 = dst + size + 16;
         for (pred = 0; pred < 5; pred++) {
             png_filter_row(s, buf1 + 1, pred, src, top, size, bpp);
             buf1[0] = pred;
-            cost = 0;
-            for (i = 0; i <= size; i++)
-                cost += abs((int8_t) buf1[i]);
+            cost = png_filter_cost(buf1, size + 1);
             if (cost < bcost) {
                 bcost = cost;
                 FFSWAP(uint8_t *, buf1, buf2);
@@ -506,6 +552,122 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int filter_chunk(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s = avctx->priv_data;
+    const AVFrame *p = arg;
+    int row_size = (p->width * s->bits_per_pixel + 7) >> 3;
+    uint8_t *crow_buf = s->filter_bufs + threadnr * s->filter_buf_size + 15;
+    int y0 = jobnr * s->chunk_rows;
+    int y1 = FFMIN(y0 + s->chunk_rows, p->height);
+
+    for (int y = y0; y < y1; y++) {
+        const uint8_t *ptr = p->data[0] + y * p->linesize[0];
+        const uint8_t *top = y ? ptr - p->linesize[0] : NULL;
+        const uint8_t *crow = png_choose_filter(s, crow_buf, ptr, top,
+                                                row_size, s->bits_per_pixel >> 3);
+        memcpy(s->filtered + y * (row_size + 1LL), crow, row_size + 1);
+    }
+    return 0;
+}
+
+/* Deflate a chunk of filtered rows into a raw deflate stream, primed with
+ * the end of the previous chunk and ending on a byte boundary, so that the
+ * chunks can simply be concatenated. */
+static int deflate_chunk(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s = avctx->priv_data;
+    const AVFrame *p = arg;
+    z_stream *const zstream = &s->chunk_zstreams[threadnr].zstream;
+    int row_size = (p->width * s->bits_per_pixel + 7) >> 3;
+    int y0 = jobnr * s->chunk_rows;
+    int y1 = FFMIN(y0 + s->chunk_rows, p->height);
+    int last = y1 == p->height;
+    const uint8_t *src = s->filtered + y0 * (row_size + 1LL);
+    uInt len = (y1 - y0) * (row_size + 1);
+    int ret;
+
+    if (deflateReset(zstream) != Z_OK)
+        return AVERROR_EXTERNAL;
+    if (y0) {
+        uInt dict = FFMIN(y0 * (row_size + 1LL), DICT_SIZE);
+        if (deflateSetDictionary(zstream, src - dict, dict) != Z_OK)
+            return AVERROR_EXTERNAL;
+    }
+
+    zstream->next_in   = src;
+    zstream->avail_in  = len;
+    zstream->next_out  = s->chunk_buf + jobnr * (size_t)s->chunk_buf_stride;
+    zstream->avail_out = s->chunk_buf_stride;
+    ret = deflate(zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret != (last ? Z_STREAM_END : Z_OK) || zstream->avail_in || !zstream->avail_out)
+        return AVERROR_EXTERNAL;
+
+    s->chunk_len[jobnr]   = s->chunk_buf_stride - zstream->avail_out;
+    s->chunk_adler[jobnr] = adler32(adler32(0, NULL, 0), src, len);
+    return 0;
+}
+
+static int encode_frame_chunks(AVCodecContext *avctx, const AVFrame *pict, int nb_chunks)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
+    int level = s->compression_level, flags;
+    uLong adler;
+
+    av_fast_malloc(&s->filtered, &s->filtered_size, pict->height * (row_size + 1LL));
+    av_fast_malloc(&s->chunk_len, &s->chunk_len_size, nb_chunks * sizeof(*s->chunk_len));
+    av_fast_malloc(&s->chunk_adler, &s->chunk_adler_size, nb_chunks * sizeof(*s->chunk_adler));
+    av_fast_malloc(&s->chunk_ret, &s->chunk_ret_size, nb_chunks * sizeof(*s->chunk_ret));
+    // room for the zlib header and trailer around the raw deflate data
+    s->chunk_buf_stride = deflateBound(&s->chunk_zstreams[0].zstream,
+                                       s->chunk_rows * (row_size + 1LL)) + 16;
+    av_fast_malloc(&s->chunk_buf, &s->chunk_buf_size,
+                   nb_chunks * (size_t)s->chunk_buf_stride);
+    if (!s->filtered || !s->chunk_len || !s->chunk_adler || !s->chunk_ret || !s->chunk_buf)
+        return AVERROR(ENOMEM);
+
+    avctx->execute2(avctx, filter_chunk, (void *)pict, s->chunk_ret, nb_chunks);
+    for (int i = 0; i < nb_chunks; i++)
+        if (s->chunk_ret[i] < 0)
+            return s->chunk_ret[i];
+    avctx->execute2(avctx, deflate_chunk, (void *)pict, s->chunk_ret, nb_chunks);
+    for (int i = 0; i < nb_chunks; i++)
+        if (s->chunk_ret[i] < 0)
+            return s->chunk_ret[i];
+
+    if (level == Z_DEFAULT_COMPRESSION)
+        level = 6;
+    flags  = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8;
+    flags |= (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+    flags += 31 - flags % 31;
+
+    adler = s->chunk_adler[0];
+    for (int i = 1; i < nb_chunks; i++) {
+        int rows = FFMIN(s->chunk_rows, pict->height - i * s->chunk_rows);
+        adler = adler32_combine(adler, s->chunk_adler[i], rows * (row_size + 1LL));
+    }
+
+    for (int i = 0; i < nb_chunks; i++) {
+        uint8_t *buf = s->chunk_buf + i * (size_t)s->chunk_buf_stride;
+        int len = s->chunk_len[i];
+
+        if (!i) {
+            memmove(buf + 2, buf, len);
+            AV_WB16(buf, flags);
+            len += 2;
+        }
+        if (i == nb_chunks - 1) {
+            AV_WB32(buf + len, adler);
+            len += 4;
+        }
+        if (s->bytestream_end - s->bytestream < len + 100)
+            return AVERROR(ENOSPC);
+        png_write_image_data(avctx, buf, len);
+    }
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -520,6 +682,12 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
+    if (s->chunk_zstreams && !s->is_progressive) {
+        int nb_chunks = (pict->height + s->chunk_rows - 1) / s->chunk_rows;
+        if (nb_chunks > 1)
+            return encode_frame_chunks(avctx, pict, nb_chunks);
+    }
+
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
     if (!crow_base) {
         ret = AVERROR(ENOMEM);
@@ -1184,6 +1352,27 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
     compression_level = avctx->compression_level == FF_COMPRESSION_DEFAULT
                       ? Z_DEFAULT_COMPRESSION
                       : av_clip(avctx->compression_level, 0, 9);
+    s->compression_level = compression_level;
+
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        int row_size = (avctx->width * s->bits_per_pixel + 7) >> 3;
+        int ret;
+
+        s->chunk_rows      = (CHUNK_SIZE + row_size) / (row_size + 1);
+        s->filter_buf_size = FFALIGN((row_size + 32) << 1, 16);
+        s->filter_bufs     = av_malloc_array(avctx->thread_count, s->filter_buf_size);
+        s->chunk_zstreams  = av_calloc(avctx->thread_count, sizeof(*s->chunk_zstreams));
+        if (!s->filter_bufs || !s->chunk_zstreams)
+            return AVERROR(ENOMEM);
+        for (int i = 0; i < avctx->thread_count; i++) {
+            ret = ff_deflate_init2(&s->chunk_zstreams[i], compression_level,
+                                   -MAX_WBITS, avctx);
+            if (ret < 0)
+                return ret;
+            s->nb_chunk_zstreams++;
+        }
+    }
+
     return ff_deflate_init(&s->zstream, compression_level, avctx);
 }
 
@@ -1192,6 +1381,15 @@ static av_cold int png_enc_close(AVCodecContext *avctx)
     PNGEncContext *s = avctx->priv_data;
 
     ff_deflate_end(&s->zstream);
+    for (int i = 0; i < s->nb_chunk_zstreams; i++)
+        ff_deflate_end(&s->chunk_zstreams[i]);
+    av_freep(&s->chunk_zstreams);
+    av_freep(&s->filter_bufs);
+    av_freep(&s->filtered);
+    av_freep(&s->chunk_buf);
+    av_freep(&s->chunk_len);
+    av_freep(&s->chunk_adler);
+    av_freep(&s->chunk_ret);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1228,6 +1426,7 @@ const FFCodec ff_png_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_PNG,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .priv_data_size = sizeof(PNGEncContext),
     .init           = png_enc_init,
@@ -1242,7 +1441,7 @@ const FFCodec ff_png_encoder = {
         AV_PIX_FMT_MONOBLACK, AV_PIX_FMT_NONE
     },
     .p.priv_class   = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_ICC_PROFILES,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES,
 };
 
 const FFCodec ff_apng_encoder = {
@@ -1265,5 +1464,5 @@ const FFCodec ff_apng_encoder = {
         AV_PIX_FMT_NONE
     },
     .p.priv_class   = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_ICC_PROFILES,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES,
 };
@@ -30,9 +30,11 @@
 
 #include "config_components.h"
 
+#include "libavutil/avassert.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
+#include "libavutil/thread.h"
 
 #include "avcodec.h"
 #include "codec_internal.h"
@@ -132,8 +134,77 @@ static void unpack_alpha_12(GetBitContext *gb, uint16_t *dst, int num_coeffs,
     }
 }
 
+#define FIRST_DC_CB 0xB8
+
+static const uint8_t dc_codebook[7] = { 0x04, 0x28, 0x28, 0x4D, 0x4D, 0x70, 0x70};
+
+// adaptive codebook switching lut according to previous run/level values
+static const uint8_t run_to_cb[16] = { 0x06, 0x06, 0x05, 0x05, 0x04, 0x29, 0x29, 0x29, 0x29, 0x28, 0x28, 0x28, 0x28, 0x28, 0x28, 0x4C };
+static const uint8_t lev_to_cb[10] = { 0x04, 0x0A, 0x05, 0x06, 0x04, 0x28, 0x28, 0x28, 0x28, 0x4C };
+
+/* Codewords of up to CW_LUT_BITS bits are decoded with a single lookup,
+ * each entry holding (value << 4) | length, or 0 for longer codewords. */
+#define CW_LUT_BITS 9
+#define MAX_CODEBOOKS 10
+
+static uint16_t cw_lut[MAX_CODEBOOKS][1 << CW_LUT_BITS];
+static const uint16_t *first_dc_lut, *dc_lut[7], *run_lut[16], *lev_lut[10];
+
+static av_cold const uint16_t *get_codeword_lut(int codebook)
+{
+    static uint8_t codebooks[MAX_CODEBOOKS];
+    static int nb_codebooks;
+    unsigned switch_bits = codebook & 3;
+    unsigned rice_order  = codebook >> 5;
+    unsigned exp_order   = (codebook >> 2) & 7;
+    uint16_t *lut;
+
+    for (int i = 0; i < nb_codebooks; i++)
+        if (codebooks[i] == codebook)
+            return cw_lut[i];
+
+    av_assert0(nb_codebooks < MAX_CODEBOOKS);
+    codebooks[nb_codebooks] = codebook;
+    lut = cw_lut[nb_codebooks++];
+
+    for (unsigned i = 1; i < 1 << CW_LUT_BITS; i++) {
+        uint32_t buf = i << (32 - CW_LUT_BITS);
+        unsigned q = 31 - av_log2(buf);
+        unsigned len, val;
+
+        if (q > switch_bits) {
+            len = exp_order - switch_bits + (q << 1);
+            if (len > CW_LUT_BITS)
+                continue;
+            val = (buf >> (32 - len)) - (1 << exp_order) +
+                  ((switch_bits + 1) << rice_order);
+        } else {
+            len = q + 1 + rice_order;
+            if (len > CW_LUT_BITS)
+                continue;
+            val = q << rice_order;
+            if (rice_order)
+                val += (buf << (q + 1)) >> (32 - rice_order);
+        }
+        lut[i] = val << 4 | len;
+    }
+    return lut;
+}
+
+static av_cold void init_codeword_luts(void)
+{
+    first_dc_lut = get_codeword_lut(FIRST_DC_CB);
+    for (int i = 0; i < FF_ARRAY_ELEMS(dc_lut); i++)
+        dc_lut[i] = get_codeword_lut(dc_codebook[i]);
+    for (int i = 0; i < FF_ARRAY_ELEMS(run_lut); i++)
+        run_lut[i] = get_codeword_lut(run_to_cb[i]);
+    for (int i = 0; i < FF_ARRAY_ELEMS(lev_lut); i++)
+        lev_lut[i] = get_codeword_lut(lev_to_cb[i]);
+}
+
 static av_cold int decode_init(AVCodecContext *avctx)
 {
+    static AVOnce init_static_once = AV_ONCE_INIT;
     int ret = 0;
     ProresContext *ctx = avctx->priv_data;
     uint8_t idct_permutation[64];
@@ -172,7 +243,6 @@ static av_cold int decode_init(AVCodecContext *avctx)
         av_log(avctx, AV_LOG_DEBUG, "Auto bitdepth precision. Use 12b decoding based on codec tag.\n");
     }
 
-    ff_blockdsp_init(&ctx->bdsp);
     ret = ff_proresdsp_init(&ctx->prodsp, avctx->bits_per_raw_sample);
     if (ret < 0) {
         av_log(avctx, AV_LOG_ERROR, "Fail to init proresdsp for bits per raw sample %d\n", avctx->bits_per_raw_sample);
@@ -195,6 +265,9 @@ static av_cold int decode_init(AVCodecContext *avctx)
         av_log(avctx, AV_LOG_ERROR, "Fail to set unpack_alpha for bits per raw sample %d\n", avctx->bits_per_raw_sample);
         return AVERROR_BUG;
     }
+
+    ff_thread_once(&init_static_once, init_codeword_luts);
+
     return ret;
 }
 
@@ -455,11 +528,20 @@ static int decode_picture_header(AVCodecContext *avctx, const uint8_t *buf, cons
         }                                                               \
     } while (0)
 
-#define TOSIGNED(x) (((x) >> 1) ^ (-((x) & 1)))
-
-#define FIRST_DC_CB 0xB8
+#define DECODE_CODEWORD_LUT(val, lut, codebook, SKIP)                  \
+    do {                                                                \
+        unsigned int entry;                                             \
+                                                                        \
+        UPDATE_CACHE(re, gb);                                           \
+        entry = (lut)[SHOW_UBITS(re, gb, CW_LUT_BITS)];                 \
+        if (entry) {                                                    \
+            val = entry >> 4;                                           \
+            SKIP(re, gb, entry & 15);                                   \
+        } else                                                          \
+            DECODE_CODEWORD(val, codebook, SKIP);                       \
+    } while (0)
 
-static const uint8_t dc_codebook[7] = { 0x04, 0x28, 0x28, 0x4D, 0x4D, 0x70, 0x70};
+#define TOSIGNED(x) (((x) >> 1) ^ (-((x) & 1)))
 
 static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
                                               int blocks_per_slice)
@@ -469,7 +551,7 @@ static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
 
     OPEN_READER(re, gb);
 
-    DECODE_CODEWORD(code, FIRST_DC_CB, LAST_SKIP_BITS);
+    DECODE_CODEWORD_LUT(code, first_dc_lut, FIRST_DC_CB, LAST_SKIP_BITS);
     prev_dc = TOSIGNED(code);
     out[0] = prev_dc;
 
@@ -478,7 +560,8 @@ static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
     code = 5;
     sign = 0;
     for (i = 1; i < blocks_per_slice; i++, out += 64) {
-        DECODE_CODEWORD(code, dc_codebook[FFMIN(code, 6U)], LAST_SKIP_BITS);
+        unsigned cb = FFMIN(code, 6U);
+        DECODE_CODEWORD_LUT(code, dc_lut[cb], dc_codebook[cb], LAST_SKIP_BITS);
         if(code) sign ^= -(code & 1);
         else     sign  = 0;
         prev_dc += (((code + 1) >> 1) ^ sign) - sign;
@@ -488,16 +571,12 @@ static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
     return 0;
 }
 
-// adaptive codebook switching lut according to previous run/level values
-static const uint8_t run_to_cb[16] = { 0x06, 0x06, 0x05, 0x05, 0x04, 0x29, 0x29, 0x29, 0x29, 0x28, 0x28, 0x28, 0x28, 0x28, 0x28, 0x4C };
-static const uint8_t lev_to_cb[10] = { 0x04, 0x0A, 0x05, 0x06, 0x04, 0x28, 0x28, 0x28, 0x28, 0x4C };
-
 static av_always_inline int decode_ac_coeffs(AVCodecContext *avctx, GetBitContext *gb,
                                              int16_t *out, int blocks_per_slice)
 {
     const ProresContext *ctx = avctx->priv_data;
     int block_mask, sign;
-    unsigned pos, run, level;
+    unsigned pos, run, level, cb;
     int max_coeffs, i, bits_left;
     int log2_block_count = av_log2(blocks_per_slice);
 
@@ -514,14 +593,16 @@ static av_always_inline int decode_ac_coeffs(AVCodecContext *avctx, GetBitContex
         if (bits_left <= 0 || (bits_left < 32 && !SHOW_UBITS(re, gb, bits_left)))
             break;
 
-        DECODE_CODEWORD(run, run_to_cb[FFMIN(run,  15)], LAST_SKIP_BITS);
+        cb = FFMIN(run, 15);
+        DECODE_CODEWORD_LUT(run, run_lut[cb], run_to_cb[cb], LAST_SKIP_BITS);
         pos += run + 1;
         if (pos >= max_coeffs) {
             av_log(avctx, AV_LOG_ERROR, "ac tex damaged %d, %d\n", pos, max_coeffs);
             return AVERROR_INVALIDDATA;
         }
 
-        DECODE_CODEWORD(level, lev_to_cb[FFMIN(level, 9)], SKIP_BITS);
+        cb = FFMIN(level, 9);
+        DECODE_CODEWORD_LUT(level, lev_lut[cb], lev_to_cb[cb], SKIP_BITS);
         level += 1;
 
         i = pos >> log2_block_count;
@@ -547,8 +628,7 @@ static int decode_slice_luma(AVCodecContext *avctx, SliceContext *slice,
     int i, blocks_per_slice = slice->mb_count<<2;
     int ret;
 
-    for (i = 0; i < blocks_per_slice; i++)
-        ctx->bdsp.clear_block(blocks+(i<<6));
+    memset(blocks, 0, blocks_per_slice * 64 * sizeof(*blocks));
 
     init_get_bits(&gb, buf, buf_size << 3);
 
@@ -581,8 +661,7 @@ static int decode_slice_chroma(AVCodecContext *avctx, SliceContext *slice,
     int i, j, blocks_per_slice = slice->mb_count << log2_blocks_per_mb;
     int ret;
 
-    for (i = 0; i < blocks_per_slice; i++)
-        ctx->bdsp.clear_block(blocks+(i<<6));
+    memset(blocks, 0, blocks_per_slice * 64 * sizeof(*blocks));
 
     init_get_bits(&gb, buf, buf_size << 3);
 
@@ -616,9 +695,7 @@ static void decode_slice_alpha(const ProresContext *ctx,
     LOCAL_ALIGNED_32(int16_t, blocks, [8*4*64]);
     int16_t *block;
 
-    for (i = 0; i < blocks_per_slice<<2; i++)
-        ctx->bdsp.clear_block(blocks+(i<<6));
-
+    /* unpack_alpha() always fills all the coefficients */
     init_get_bits(&gb, buf, buf_size << 3);
 
     if (ctx->alpha_info == 2) {
@@ -636,15 +713,75 @@ static void decode_slice_alpha(const ProresContext *ctx,
     }
 }
 
+/**
+ * Parse the slice header.
+ * @return header size or a negative error code if the plane sizes are invalid
+ */
+static int decode_slice_header(const SliceContext *slice, int *qscale,
+                               int data_size[4])
+{
+    const uint8_t *buf = slice->data;
+    int hdr_size;
+
+    hdr_size = buf[0] >> 3;
+    *qscale  = av_clip(buf[1], 1, 224);
+    *qscale  = *qscale > 128 ? *qscale - 96 << 2 : *qscale;
+    data_size[0] = AV_RB16(buf + 2);
+    data_size[1] = AV_RB16(buf + 4);
+    data_size[2] = slice->data_size - data_size[0] - data_size[1] - hdr_size;
+    if (hdr_size > 7) data_size[2] = AV_RB16(buf + 6);
+    data_size[3] = slice->data_size - data_size[0] - data_size[1] -
+                   data_size[2] - hdr_size;
+
+    if (data_size[0] < 0 || data_size[1] < 0 || data_size[2] < 0 ||
+        hdr_size + data_size[0] + data_size[1] + data_size[2] > slice->data_size)
+        return AVERROR_INVALIDDATA;
+
+    return hdr_size;
+}
+
+/**
+ * Whether the alpha plane of each slice is decoded by a job of its own,
+ * interleaved with the luma/chroma jobs, rather than after the chroma
+ * planes in the same job.
+ */
+static int alpha_in_own_job(const ProresContext *ctx)
+{
+    return ctx->alpha_info && ctx->frame->data[3];
+}
+
+static int decode_alpha_thread(AVCodecContext *avctx, const SliceContext *slice)
+{
+    const ProresContext *ctx = avctx->priv_data;
+    AVFrame *pic = ctx->frame;
+    int hdr_size, qscale, data_size[4], luma_stride;
+    uint8_t *dest_a;
+
+    /* errors are reported by the luma/chroma job of the slice */
+    hdr_size = decode_slice_header(slice, &qscale, data_size);
+    if (hdr_size < 0 || !data_size[3])
+        return 0;
+
+    luma_stride = ctx->frame_type ? pic->linesize[0] << 1 : pic->linesize[0];
+    dest_a = pic->data[3] + (slice->mb_y << 4) * luma_stride + (slice->mb_x << 5);
+    if (ctx->frame_type && ctx->first_field ^ !!(ctx->frame->flags & AV_FRAME_FLAG_TOP_FIELD_FIRST))
+        dest_a += pic->linesize[3];
+
+    decode_slice_alpha(ctx, (uint16_t*)dest_a, luma_stride,
+                       slice->data + hdr_size + data_size[0] + data_size[1] + data_size[2],
+                       data_size[3], slice->mb_count);
+    return 0;
+}
+
 static int decode_slice_thread(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
 {
     const ProresContext *ctx = avctx->priv_data;
-    SliceContext *slice = &ctx->slices[jobnr];
-    const uint8_t *buf = slice->data;
+    SliceContext *slice;
+    const uint8_t *buf;
     AVFrame *pic = ctx->frame;
     int i, hdr_size, qscale, log2_chroma_blocks_per_mb;
     int luma_stride, chroma_stride;
-    int y_data_size, u_data_size, v_data_size, a_data_size, offset;
+    int y_data_size, u_data_size, v_data_size, data_size[4];
     uint8_t *dest_y, *dest_u, *dest_v;
     LOCAL_ALIGNED_16(int16_t, qmat_luma_scaled,  [64]);
     LOCAL_ALIGNED_16(int16_t, qmat_chroma_scaled,[64]);
@@ -652,26 +789,26 @@ static int decode_slice_thread(AVCodecContext *avctx, void *arg, int jobnr, int
     int ret;
     uint16_t val_no_chroma;
 
+    if (alpha_in_own_job(ctx)) {
+        if (jobnr & 1)
+            return decode_alpha_thread(avctx, &ctx->slices[jobnr >> 1]);
+        jobnr >>= 1;
+    }
+    slice = &ctx->slices[jobnr];
+    buf   = slice->data;
+
     slice->ret = -1;
     //av_log(avctx, AV_LOG_INFO, "slice %d mb width %d mb x %d y %d\n",
     //       jobnr, slice->mb_count, slice->mb_x, slice->mb_y);
 
-    // slice header
-    hdr_size = buf[0] >> 3;
-    qscale = av_clip(buf[1], 1, 224);
-    qscale = qscale > 128 ? qscale - 96 << 2: qscale;
-    y_data_size = AV_RB16(buf + 2);
-    u_data_size = AV_RB16(buf + 4);
-    v_data_size = slice->data_size - y_data_size - u_data_size - hdr_size;
-    if (hdr_size > 7) v_data_size = AV_RB16(buf + 6);
-    a_data_size = slice->data_size - y_data_size - u_data_size -
-                  v_data_size - hdr_size;
-
-    if (y_data_size < 0 || u_data_size < 0 || v_data_size < 0
-        || hdr_size+y_data_size+u_data_size+v_data_size > slice->data_size){
+    hdr_size = decode_slice_header(slice, &qscale, data_size);
+    if (hdr_size < 0) {
         av_log(avctx, AV_LOG_ERROR, "invalid plane data size\n");
-        return AVERROR_INVALIDDATA;
+        return hdr_size;
     }
+    y_data_size = data_size[0];
+    u_data_size = data_size[1];
+    v_data_size = data_size[2];
 
     buf += hdr_size;
 
@@ -697,8 +834,7 @@ static int decode_slice_thread(AVCodecContext *avctx, void *arg, int jobnr, int
         log2_chroma_blocks_per_mb = 1;
     }
 
-    offset = (slice->mb_y << 4) * luma_stride + (slice->mb_x << 5);
-    dest_y = pic->data[0] + offset;
+    dest_y = pic->data[0] + (slice->mb_y << 4) * luma_stride + (slice->mb_x << 5);
     dest_u = pic->data[1] + (slice->mb_y << 4) * chroma_stride + (slice->mb_x << mb_x_shift);
     dest_v = pic->data[2] + (slice->mb_y << 4) * chroma_stride + (slice->mb_x << mb_x_shift);
 
@@ -706,7 +842,6 @@ static int decode_slice_thread(AVCodecContext *avctx, void *arg, int jobnr, int
         dest_y += pic->linesize[0];
         dest_u += pic->linesize[1];
         dest_v += pic->linesize[2];
-        offset += pic->linesize[3];
     }
 
     ret = decode_slice_luma(avctx, slice, (uint16_t*)dest_y, luma_stride,
@@ -742,14 +877,6 @@ static int decode_slice_thread(AVCodecContext *avctx, void *arg, int jobnr, int
             }
     }
 
-    /* decode alpha plane if available */
-    if (ctx->alpha_info && pic->data[3] && a_data_size) {
-        uint8_t *dest_a = pic->data[3] + offset;
-        decode_slice_alpha(ctx, (uint16_t*)dest_a, luma_stride,
-                           buf + y_data_size + u_data_size + v_data_size,
-                           a_data_size, slice->mb_count);
-    }
-
     slice->ret = 0;
     return 0;
 }
@@ -760,7 +887,8 @@ static int decode_picture(AVCodecContext *avctx)
     int i;
     int error = 0;
 
-    avctx->execute2(avctx, decode_slice_thread, NULL, NULL, ctx->slice_count);
+    avctx->execute2(avctx, decode_slice_thread, NULL, NULL,
+                    ctx->slice_count << alpha_in_own_job(ctx));
 
     for (i = 0; i < ctx->slice_count; i++)
         error += ctx->slices[i].ret < 0;
@@ -25,7 +25,6 @@
 #include <stdint.h>
 
 #include "get_bits.h"
-#include "blockdsp.h"
 #include "proresdsp.h"
 
 #include "libavutil/frame.h"
@@ -41,7 +40,6 @@ typedef struct {
 } SliceContext;
 
 typedef struct {
-    BlockDSPContext bdsp;
     ProresDSPContext prodsp;
     AVFrame *frame;
     int frame_type;              ///< 0 = progressive, 1 = tff, 2 = bff
@@ -61,6 +61,11 @@ enum {
     QUANT_MAT_DEFAULT,
 };
 
+enum {
+    QUALITY_EXHAUSTIVE = 0,
+    QUALITY_FAST,
+};
+
 static const uint8_t prores_quant_matrices[][64] = {
     { // proxy
          4,  7,  9, 11, 13, 14, 15, 63,
@@ -259,6 +264,7 @@ typedef struct ProresContext {
 
     char *vendor;
     int quant_sel;
+    int quality;
 
     int frame_size_upper_bound;
 
@@ -669,19 +675,29 @@ static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
     int idx, i;
     int prev_run = 4;
     int prev_level = 2;
-    int run, level;
+    int run;
     int max_coeffs, abs_level;
     int bits = 0;
+    uint32_t recip[64];
 
     max_coeffs = blocks_per_slice << 6;
     run        = 0;
 
+    /* Replace the divisions by multiplications with a reciprocal; the result
+     * is exact since all quantiser matrix entries are >= 2 and a coefficient
+     * times its divisor always fits in 32 bits. */
+    for (i = 0; i < 64; i++)
+        recip[i] = (UINT64_C(1) << 32) / qmat[i] + 1;
+
     for (i = 1; i < 64; i++) {
+        const unsigned q = qmat[scan[i]], r = recip[scan[i]];
+
         for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level   = blocks[idx] / qmat[scan[i]];
-            *error += FFABS(blocks[idx]) % qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
+            unsigned coef = FFABS(blocks[idx]);
+
+            abs_level = (uint64_t)coef * r >> 32;
+            *error   += coef - abs_level * q;
+            if (abs_level) {
                 bits += estimate_vlc(ff_prores_run_to_cb[prev_run], run);
                 bits += estimate_vlc(ff_prores_level_to_cb[prev_level],
                                      abs_level - 1) + 1;
@@ -699,7 +715,6 @@ static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
 }
 
 static int estimate_slice_plane(ProresContext *ctx, int *error, int plane,
-                                const uint16_t *src, ptrdiff_t linesize,
                                 int mbs_per_slice,
                                 int blocks_per_mb,
                                 const int16_t *qmat, ProresThreadData *td)
@@ -772,31 +787,25 @@ static int estimate_alpha_plane(ProresContext *ctx,
     return bits;
 }
 
-static int find_slice_quant(AVCodecContext *avctx,
-                            int trellis_node, int x, int y, int mbs_per_slice,
-                            ProresThreadData *td)
+/**
+ * Load the DCT coefficients (and the alpha values) of a slice into td->blocks.
+ *
+ * @return the estimated number of bits needed for the alpha plane
+ */
+static int load_slice(AVCodecContext *avctx, int x, int y, int mbs_per_slice,
+                      int num_cblocks[MAX_PLANES], ProresThreadData *td)
 {
     ProresContext *ctx = avctx->priv_data;
-    int i, q, pq, xp, yp;
+    int i, xp, yp;
     const uint16_t *src;
-    int num_cblocks[MAX_PLANES], pwidth;
+    int pwidth;
     int is_chroma[MAX_PLANES];
-    const int min_quant = ctx->profile_info->min_quant;
-    const int max_quant = ctx->profile_info->max_quant;
-    int error, bits, bits_limit;
-    int mbs, prev, cur, new_score;
-    int slice_bits[TRELLIS_WIDTH], slice_score[TRELLIS_WIDTH];
-    int overquant;
-    uint16_t *qmat;
-    uint16_t *qmat_chroma;
     int linesize[4], line_add;
-    int alpha_bits = 0;
 
     if (ctx->pictures_per_frame == 1)
         line_add = 0;
     else
         line_add = ctx->cur_picture_idx ^ !(ctx->pic->flags & AV_FRAME_FLAG_TOP_FIELD_FIRST);
-    mbs = x + mbs_per_slice;
 
     for (i = 0; i < ctx->num_planes; i++) {
         is_chroma[i]    = (i == 1 || i == 2);
@@ -828,30 +837,76 @@ static int find_slice_quant(AVCodecContext *avctx,
         }
     }
 
+    if (!ctx->alpha_bits)
+        return 0;
+    return estimate_alpha_plane(ctx, src, linesize[3],
+                                mbs_per_slice, td->blocks[3]);
+}
+
+/**
+ * Estimate the number of bits needed for the luma and chroma planes of the
+ * slice loaded in td->blocks at the given quantiser.
+ */
+static int estimate_slice(ProresContext *ctx, int *error, int q,
+                          int mbs_per_slice, const int num_cblocks[MAX_PLANES],
+                          ProresThreadData *td)
+{
+    const int16_t *qmat, *qmat_chroma;
+    int i, bits;
+
+    if (q < MAX_STORED_Q) {
+        qmat = ctx->quants[q];
+        qmat_chroma = ctx->quants_chroma[q];
+    } else {
+        for (i = 0; i < 64; i++) {
+            td->custom_q[i] = ctx->quant_mat[i] * q;
+            td->custom_chroma_q[i] = ctx->quant_chroma_mat[i] * q;
+        }
+        qmat = td->custom_q;
+        qmat_chroma = td->custom_chroma_q;
+    }
+
+    bits = estimate_slice_plane(ctx, error, 0,
+                                mbs_per_slice, num_cblocks[0],
+                                qmat, td); /* estimate luma plane */
+    for (i = 1; i < ctx->num_planes - !!ctx->alpha_bits; i++) { /* estimate chroma plane */
+        bits += estimate_slice_plane(ctx, error, i,
+                                     mbs_per_slice, num_cblocks[i],
+                                     qmat_chroma, td);
+    }
+
+    return bits;
+}
+
+static int find_slice_quant(AVCodecContext *avctx,
+                            int trellis_node, int x, int y, int mbs_per_slice,
+                            ProresThreadData *td)
+{
+    ProresContext *ctx = avctx->priv_data;
+    int q, pq;
+    int num_cblocks[MAX_PLANES];
+    const int min_quant = ctx->profile_info->min_quant;
+    const int max_quant = ctx->profile_info->max_quant;
+    int error, bits, bits_limit;
+    int mbs, prev, cur, new_score;
+    int slice_bits[TRELLIS_WIDTH], slice_score[TRELLIS_WIDTH];
+    int overquant;
+    int alpha_bits;
+
+    mbs = x + mbs_per_slice;
+
+    alpha_bits = load_slice(avctx, x, y, mbs_per_slice, num_cblocks, td);
+
     for (q = min_quant; q < max_quant + 2; q++) {
         td->nodes[trellis_node + q].prev_node = -1;
         td->nodes[trellis_node + q].quant     = q;
     }
 
-    if (ctx->alpha_bits)
-        alpha_bits = estimate_alpha_plane(ctx, src, linesize[3],
-                                          mbs_per_slice, td->blocks[3]);
     // todo: maybe perform coarser quantising to fit into frame size when needed
     for (q = min_quant; q <= max_quant; q++) {
-        bits  = alpha_bits;
         error = 0;
-        bits += estimate_slice_plane(ctx, &error, 0,
-                                     src, linesize[0],
-                                     mbs_per_slice,
-                                     num_cblocks[0],
-                                     ctx->quants[q], td); /* estimate luma plane */
-        for (i = 1; i < ctx->num_planes - !!ctx->alpha_bits; i++) { /* estimate chroma plane */
-            bits += estimate_slice_plane(ctx, &error, i,
-                                         src, linesize[i],
-                                         mbs_per_slice,
-                                         num_cblocks[i],
-                                         ctx->quants_chroma[q], td);
-        }
+        bits  = alpha_bits + estimate_slice(ctx, &error, q, mbs_per_slice,
+                                            num_cblocks, td);
         if (bits > 65000 * 8)
             error = SCORE_LIMIT;
 
@@ -864,31 +919,9 @@ static int find_slice_quant(AVCodecContext *avctx,
         overquant = max_quant;
     } else {
         for (q = max_quant + 1; q < 128; q++) {
-            bits  = alpha_bits;
             error = 0;
-            if (q < MAX_STORED_Q) {
-                qmat = ctx->quants[q];
-                qmat_chroma = ctx->quants_chroma[q];
-            } else {
-                qmat = td->custom_q;
-                qmat_chroma = td->custom_chroma_q;
-                for (i = 0; i < 64; i++) {
-                    qmat[i] = ctx->quant_mat[i] * q;
-                    qmat_chroma[i] = ctx->quant_chroma_mat[i] * q;
-                }
-            }
-            bits += estimate_slice_plane(ctx, &error, 0,
-                                         src, linesize[0],
-                                         mbs_per_slice,
-                                         num_cblocks[0],
-                                         qmat, td);/* estimate luma plane */
-            for (i = 1; i < ctx->num_planes - !!ctx->alpha_bits; i++) { /* estimate chroma plane */
-                bits += estimate_slice_plane(ctx, &error, i,
-                                             src, linesize[i],
-                                             mbs_per_slice,
-                                             num_cblocks[i],
-                                             qmat_chroma, td);
-            }
+            bits  = alpha_bits + estimate_slice(ctx, &error, q, mbs_per_slice,
+                                                num_cblocks, td);
             if (bits <= ctx->bits_per_mb * mbs_per_slice)
                 break;
         }
@@ -937,6 +970,32 @@ static int find_slice_quant(AVCodecContext *avctx,
     return pq;
 }
 
+/**
+ * Fast quantiser search: pick the lowest quantiser whose estimate fits the
+ * bits left in the slice row budget instead of evaluating the whole range
+ * and running the trellis over the slice row.
+ */
+static int find_slice_quant_fast(AVCodecContext *avctx, int x, int y,
+                                 int mbs_per_slice, int bits_limit, int *bits,
+                                 ProresThreadData *td)
+{
+    ProresContext *ctx = avctx->priv_data;
+    int num_cblocks[MAX_PLANES];
+    int q, error, alpha_bits;
+
+    alpha_bits = load_slice(avctx, x, y, mbs_per_slice, num_cblocks, td);
+
+    for (q = ctx->profile_info->min_quant; q < 128; q++) {
+        error = 0;
+        *bits = alpha_bits + estimate_slice(ctx, &error, q, mbs_per_slice,
+                                            num_cblocks, td);
+        if (*bits <= bits_limit)
+            break;
+    }
+
+    return q;
+}
+
 static int find_quant_thread(AVCodecContext *avctx, void *arg,
                              int jobnr, int threadnr)
 {
@@ -945,6 +1004,21 @@ static int find_quant_thread(AVCodecContext *avctx, void *arg,
     int mbs_per_slice = ctx->mbs_per_slice;
     int x, y = jobnr, mb, q = 0;
 
+    if (ctx->quality == QUALITY_FAST) {
+        int bits, row_bits = 0;
+
+        for (x = mb = 0; x < ctx->mb_width; x += mbs_per_slice, mb++) {
+            while (ctx->mb_width - x < mbs_per_slice)
+                mbs_per_slice >>= 1;
+            ctx->slice_q[mb + y * ctx->slices_width] =
+                find_slice_quant_fast(avctx, x, y, mbs_per_slice,
+                                      (x + mbs_per_slice) * ctx->bits_per_mb - row_bits,
+                                      &bits, td);
+            row_bits += bits;
+        }
+        return 0;
+    }
+
     for (x = mb = 0; x < ctx->mb_width; x += mbs_per_slice, mb++) {
         while (ctx->mb_width - x < mbs_per_slice)
             mbs_per_slice >>= 1;
@@ -1360,6 +1434,12 @@ static const AVOption options[] = {
         0, 0, VE, .unit = "quant_mat" },
     { "alpha_bits", "bits for alpha plane", OFFSET(alpha_bits), AV_OPT_TYPE_INT,
         { .i64 = 16 }, 0, 16, VE },
+    { "quality", "quantiser search", OFFSET(quality), AV_OPT_TYPE_INT,
+        { .i64 = QUALITY_EXHAUSTIVE }, QUALITY_EXHAUSTIVE, QUALITY_FAST, VE, .unit = "quality" },
+    { "exhaustive",    "estimate every quantiser and pick the best per slice row",
+        0, AV_OPT_TYPE_CONST, { .i64 = QUALITY_EXHAUSTIVE }, 0, 0, VE, .unit = "quality" },
+    { "fast",          "use the lowest quantiser fitting each slice budget",
+        0, AV_OPT_TYPE_CONST, { .i64 = QUALITY_FAST }, 0, 0, VE, .unit = "quality" },
     { NULL }
 };
 
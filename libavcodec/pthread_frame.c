@@ -785,6 +785,7 @@ void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
             }
 
             av_refstruct_unref(&ctx->internal->pool);
+            av_refstruct_unref(&ctx->internal->pool_cache);
             av_packet_free(&ctx->internal->in_pkt);
             av_packet_free(&ctx->internal->last_pkt_props);
             ff_decode_internal_uninit(ctx);
@@ -854,6 +855,7 @@ static av_cold int init_thread(PerThreadContext *p, int *threads_to_free,
     ff_decode_internal_sync(copy, avctx);
     copy->internal->thread_ctx = p;
     copy->internal->progress_frame_pool = avctx->internal->progress_frame_pool;
+    av_refstruct_replace(&copy->internal->pool_cache, avctx->internal->pool_cache);
 
     copy->delay = avctx->delay;
 
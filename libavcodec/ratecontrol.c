@@ -637,6 +637,18 @@ av_cold int ff_rate_control_init(MpegEncContext *s)
             return res;
     }
 
+    if (s->rc_lookahead) {
+        rcc->lookahead_stride = 8 * s->mb_width;
+        for (i = 0; i < 2; i++) {
+            rcc->lookahead_lowres[i] = av_malloc(rcc->lookahead_stride * 8 * s->mb_height);
+            if (!rcc->lookahead_lowres[i])
+                return AVERROR(ENOMEM);
+        }
+        rcc->lookahead_row_cplx = av_malloc_array(s->mb_height, sizeof(*rcc->lookahead_row_cplx));
+        if (!rcc->lookahead_row_cplx)
+            return AVERROR(ENOMEM);
+    }
+
     if (!(s->avctx->flags & AV_CODEC_FLAG_PASS2)) {
         rcc->short_term_qsum   = 0.001;
         rcc->short_term_qcount = 0.001;
@@ -704,6 +716,9 @@ av_cold void ff_rate_control_uninit(RateControlContext *rcc)
     av_expr_free(rcc->rc_eq_eval);
     rcc->rc_eq_eval = NULL;
     av_freep(&rcc->entry);
+    av_freep(&rcc->lookahead_lowres[0]);
+    av_freep(&rcc->lookahead_lowres[1]);
+    av_freep(&rcc->lookahead_row_cplx);
 }
 
 int ff_vbv_update(MpegEncContext *s, int frame_size)
@@ -881,6 +896,192 @@ static void adaptive_quantization(MpegEncContext *s, double q)
     }
 }
 
+typedef struct LookaheadRows {
+    MpegEncContext *s;
+    const uint8_t *luma;
+} LookaheadRows;
+
+/*
+ * Analyze one row of macroblocks of a picture entering the lookahead.
+ * The intra complexity is the macroblock variance as computed by the motion
+ * estimation, the inter complexity is estimated from the error of a coarse
+ * search on half resolution planes against the previous input picture.
+ */
+static int lookahead_analyze_row(AVCodecContext *avctx, void *arg,
+                                 int mb_y, int threadnr)
+{
+    const LookaheadRows *const rows = arg;
+    MpegEncContext *const s  = rows->s;
+    RateControlContext *rcc  = &s->rc_context;
+    const int stride         = rcc->lookahead_stride;
+    const uint8_t *luma      = rows->luma + 16 * mb_y * s->linesize;
+    uint8_t *cur             = rcc->lookahead_lowres[0] + 8 * mb_y * stride;
+    const uint8_t *ref       = rcc->lookahead_lowres[1] + 8 * mb_y * stride;
+    int64_t intra = 0, inter = 0;
+    int mx = 0, my = 0;
+
+    s->mpvencdsp.shrink[1](cur, stride, luma, s->linesize, 8 * s->mb_width, 8);
+
+    for (int mb_x = 0; mb_x < s->mb_width; mb_x++) {
+        const uint8_t *pix = luma + 16 * mb_x;
+        const int sum = s->mpvencdsp.pix_sum(pix, s->linesize);
+        const int var = (s->mpvencdsp.pix_norm1(pix, s->linesize) -
+                         (((unsigned) sum * sum) >> 8) + 500 + 128) >> 8;
+        int mc_var = var;
+
+        if (rcc->lookahead_frames) {
+            const int pred[1][2] = { { mx, my } };
+            const int x = 8 * mb_x, y = 8 * mb_y;
+            const int d = ff_me_coarse_search(s->me.pix_abs[1][0],
+                                              cur + x, ref + x, stride,
+                                              -x, 8 * (s->mb_width  - 1) - x,
+                                              -y, 8 * (s->mb_height - 1) - y,
+                                              pred, 1, &mx, &my);
+            /* the mean square of a Laplacian residual is twice its squared
+             * mean absolute value */
+            mc_var = FFMIN(mc_var, (d * d) >> 11);
+        }
+        intra += var;
+        inter += mc_var;
+    }
+
+    rcc->lookahead_row_cplx[mb_y][0] = intra;
+    rcc->lookahead_row_cplx[mb_y][1] = inter;
+
+    return 0;
+}
+
+void ff_rate_control_lookahead(MpegEncContext *s, MPVPicture *pic,
+                               const uint8_t *luma)
+{
+    RateControlContext *rcc = &s->rc_context;
+    LookaheadRows rows = { s, luma };
+
+    s->avctx->execute2(s->avctx, lookahead_analyze_row, &rows, NULL, s->mb_height);
+    emms_c();
+
+    pic->rc_cplx[0] = pic->rc_cplx[1] = 0;
+    for (int i = 0; i < s->mb_height; i++) {
+        pic->rc_cplx[0] += rcc->lookahead_row_cplx[i][0];
+        pic->rc_cplx[1] += rcc->lookahead_row_cplx[i][1];
+    }
+
+    FFSWAP(uint8_t *, rcc->lookahead_lowres[0], rcc->lookahead_lowres[1]);
+    rcc->lookahead_frames++;
+}
+
+#define LOOKAHEAD_MAX_FACTOR 8.0
+#define LOOKAHEAD_MAX_FRAMES (1 + 2 * (MAX_B_FRAMES + 1) + MAX_RC_LOOKAHEAD)
+
+/*
+ * Run the VBV buffer model over the pictures in the lookahead window,
+ * with the given size predictions and all qscales multiplied by factor.
+ * Returns 1 if the buffer underflows and 0 otherwise.
+ */
+static int lookahead_underflow(MpegEncContext *s, const double *cplx,
+                               const double *qscale, int n, double factor)
+{
+    const double buffer_size = s->avctx->rc_buffer_size;
+    const double fps         = get_fps(s->avctx);
+    const double min_rate    = s->avctx->rc_min_rate / fps;
+    const double max_rate    = s->avctx->rc_max_rate / fps;
+    double buffer_index      = s->rc_context.buffer_index;
+
+    for (int i = 0; i < n; i++) {
+        buffer_index -= cplx[i] / (qscale[i] * factor);
+        if (buffer_index < 0)
+            return 1;
+        buffer_index += av_clipd(buffer_size - buffer_index - 1, min_rate, max_rate);
+    }
+
+    return 0;
+}
+
+static double lookahead_qfactor(const AVCodecContext *avctx, int pict_type)
+{
+    if (pict_type == AV_PICTURE_TYPE_I)
+        return FFABS(avctx->i_quant_factor);
+    if (pict_type == AV_PICTURE_TYPE_B)
+        return FFABS(avctx->b_quant_factor);
+    return 1.0;
+}
+
+/*
+ * Raise the qscale of the current picture so that the VBV buffer does not
+ * underflow while coding the pictures queued in the lookahead. Their
+ * qscales are assumed to follow the current one like the rate control
+ * equation would make them. Lowering it to avoid stuffing is left to
+ * modify_qscale(), which already does so for the current picture.
+ */
+static double lookahead_qscale(MpegEncContext *s, double q, int pict_type,
+                               int64_t var)
+{
+    RateControlContext *rcc = &s->rc_context;
+    const double qcomp      = 1.0 - s->avctx->qcompress;
+    const double qfactor    = lookahead_qfactor(s->avctx, pict_type);
+    double cplx[LOOKAHEAD_MAX_FRAMES], qscale[LOOKAHEAD_MAX_FRAMES];
+    const MPVPicture *pics[LOOKAHEAD_MAX_FRAMES];
+    double lo = 1.0, hi = LOOKAHEAD_MAX_FACTOR;
+    int n = 0;
+
+    /* the pictures after the current one in coding order: pending B-frames,
+     * then the not yet reordered input */
+    for (int i = 0; i <= MAX_B_FRAMES; i++)
+        if (s->reordered_input_picture[i])
+            pics[n++] = s->reordered_input_picture[i];
+    for (int i = 0; i <= MAX_B_FRAMES + MAX_RC_LOOKAHEAD; i++)
+        if (s->input_picture[i])
+            pics[n++] = s->input_picture[i];
+    if (!n)
+        return q;
+
+    cplx[0]   = FFMAX(predict_size(&rcc->pred[pict_type], 1.0, sqrt(var)), 1.0);
+    qscale[0] = q;
+    for (int i = 0; i < n; i++) {
+        const MPVPicture *pic = pics[i];
+        int type = pic->f->pict_type;
+        double v;
+
+        if (!type) {
+            const int gop_pos = s->picture_in_gop_number + i + 1;
+
+            if (s->gop_size && gop_pos % s->gop_size == 0)
+                type = AV_PICTURE_TYPE_I;
+            else if (s->max_b_frames && (i + 1) % (s->max_b_frames + 1))
+                type = AV_PICTURE_TYPE_B;
+            else
+                type = AV_PICTURE_TYPE_P;
+        }
+        v = pic->rc_cplx[type != AV_PICTURE_TYPE_I] *
+            (rcc->lookahead_scale[type != AV_PICTURE_TYPE_I] ?
+             rcc->lookahead_scale[type != AV_PICTURE_TYPE_I] : 1.0);
+
+        cplx[i + 1]   = FFMAX(predict_size(&rcc->pred[type], 1.0, sqrt(v)), 1.0);
+        qscale[i + 1] = q * pow(cplx[i + 1] / cplx[0], qcomp) *
+                        lookahead_qfactor(s->avctx, type) / qfactor;
+    }
+    n++;
+
+    if (!lookahead_underflow(s, cplx, qscale, n, 1.0))
+        return q;
+
+    /* find the smallest factor avoiding the underflow */
+    for (int i = 0; i < 16; i++) {
+        const double mid = sqrt(lo * hi);
+
+        if (lookahead_underflow(s, cplx, qscale, n, mid))
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    if (s->avctx->debug & FF_DEBUG_RC)
+        av_log(s->avctx, AV_LOG_DEBUG, "lookahead over %d pictures: q %f -> %f\n",
+               n, q, q * hi);
+
+    return q * hi;
+}
+
 void ff_get_2pass_fcode(MpegEncContext *s)
 {
     const RateControlContext *rcc = &s->rc_context;
@@ -1022,6 +1223,19 @@ float ff_rate_estimate_qscale(MpegEncContext *s, int dry_run)
         }
         av_assert0(q > 0.0);
 
+        if (s->rc_lookahead) {
+            if (!dry_run) {
+                const int k       = pict_type != AV_PICTURE_TYPE_I;
+                const int64_t est = s->cur_pic.ptr->rc_cplx[k];
+
+                if (est > 0)
+                    rcc->lookahead_scale[k] = rcc->lookahead_scale[k] ?
+                        0.7 * rcc->lookahead_scale[k] + 0.3 * var / est :
+                        (double)var / est;
+            }
+            q = lookahead_qscale(s, q, pict_type, var);
+        }
+
         q = modify_qscale(s, rce, q, picture_number);
 
         rcc->pass1_wanted_bits += s->bit_rate / fps;
@@ -78,9 +78,17 @@ typedef struct RateControlContext{
     int last_non_b_pict_type;
 
     struct AVExpr *rc_eq_eval;
+
+    /* lookahead */
+    uint8_t *lookahead_lowres[2]; ///< half resolution luma of the last two input pictures
+    int lookahead_stride;
+    int lookahead_frames;         ///< number of analyzed input pictures
+    int64_t (*lookahead_row_cplx)[2];
+    double lookahead_scale[2];    ///< ratio of measured to estimated intra and inter complexity
 }RateControlContext;
 
 struct MpegEncContext;
+struct MPVPicture;
 
 /* rate control */
 int ff_rate_control_init(struct MpegEncContext *s);
@@ -90,4 +98,13 @@ int ff_vbv_update(struct MpegEncContext *s, int frame_size);
 void ff_get_2pass_fcode(struct MpegEncContext *s);
 void ff_rate_control_uninit(RateControlContext *rcc);
 
+/**
+ * Estimate the intra and inter complexity of a picture entering the
+ * lookahead queue. Macroblock rows are analyzed in parallel.
+ *
+ * @param luma  luma plane of the picture, with the encoder's linesize
+ */
+void ff_rate_control_lookahead(struct MpegEncContext *s, struct MPVPicture *pic,
+                               const uint8_t *luma);
+
 #endif /* AVCODEC_RATECONTROL_H */
@@ -27,10 +27,55 @@
 
 #include <stdint.h>
 
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
 const uint8_t *avpriv_find_start_code(const uint8_t *p,
                                       const uint8_t *end,
                                       uint32_t *state);
 
 int ff_startcode_find_candidate_c(const uint8_t *buf, int size);
 
+/**
+ * Advance a parser which shifts every byte read into state64, most recent
+ * byte in the low bits, to the next position of buf which is preceded by a
+ * 00 00 01 start code prefix and two more bytes, i.e. where the parser sees
+ * the prefix in bits 24-47 of state64 after reading the byte.
+ * state64 is updated as if the skipped bytes had been read.
+ *
+ * @param pos  position of the next byte to read
+ * @return the new position, size if there is none
+ */
+static inline int ff_startcode_skip(const uint8_t *buf, int pos, int size,
+                                    uint64_t *state64)
+{
+    int p = pos - 3;
+
+    /* The prefix may start in the bytes only available in state64. */
+    if (pos < 5)
+        return pos;
+
+    /* p is the position of the last byte of the prefix; a byte > 1 rules
+     * out a prefix ending there or in the next two bytes. */
+    while (p < size) {
+        if (buf[p] > 1)
+            p += 3;
+        else if (!buf[p])
+            p++;
+        else if (!buf[p - 1] && !buf[p - 2])
+            break;
+        else
+            p += 3;
+    }
+    p = FFMIN(p + 3, size);
+
+    if (p >= 8) {
+        *state64 = AV_RB64(buf + p - 8);
+    } else {
+        for (int i = pos; i < p; i++)
+            *state64 = (*state64 << 8) | buf[i];
+    }
+    return p;
+}
+
 #endif /* AVCODEC_STARTCODE_H */
@@ -24,6 +24,7 @@
 #define SIZE 10240
 
 #include "libavutil/lfg.h"
+#include "libavutil/timer.h"
 #include "libavcodec/put_bits.h"
 
 typedef struct CABACTestContext {
@@ -136,7 +137,37 @@ static void init_cabac_encoder(CABACTestContext *c, uint8_t *buf, int buf_size)
     c->pb.bit_left++; //avoids firstBitFlag
 }
 
-int main(void){
+static void bench(const uint8_t *b, int chunk)
+{
+    CABACContext c;
+    uint8_t state[10];
+
+    for (int i = 0; i < 1000; i++) {
+        ff_init_cabac_decoder(&c, b, SIZE);
+        {
+            START_TIMER;
+            for (int j = 0; j < SIZE; j++)
+                get_cabac_bypass(&c);
+            STOP_TIMER("get_cabac_bypass");
+        }
+        ff_init_cabac_decoder(&c, b, SIZE);
+        {
+            START_TIMER;
+            for (int j = 0; j < SIZE; j += chunk)
+                get_cabac_bypass_bits(&c, chunk);
+            STOP_TIMER("get_cabac_bypass_bits");
+        }
+        memset(state, 0, sizeof(state));
+        {
+            START_TIMER;
+            for (int j = 0; j < SIZE; j++)
+                get_cabac_inline(&c, state);
+            STOP_TIMER("get_cabac");
+        }
+    }
+}
+
+int main(int argc, char **argv){
     CABACTestContext c;
     uint8_t b[9*SIZE];
     uint8_t r[9*SIZE];
@@ -164,6 +195,11 @@ int main(void){
     b[i++] = av_lfg_get(&prng);
     b[i  ] = av_lfg_get(&prng);
 
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench(b, 8);
+        return 0;
+    }
+
     ff_init_cabac_decoder(&c.dec, b, SIZE);
 
     memset(state, 0, sizeof(state));
@@ -186,5 +222,32 @@ int main(void){
         ret = 1;
     }
 
+    ff_init_cabac_decoder(&c.dec, b, SIZE);
+
+    for (i = 0; i < SIZE;) {
+        int n = FFMIN(1 + av_lfg_get(&prng) % 31, SIZE - i);
+        unsigned bits = get_cabac_bypass_bits(&c.dec, n);
+
+        for (int j = 0; j < n; j++, i++) {
+            if ((r[i] & 1) != ((bits >> (n - 1 - j)) & 1)) {
+                av_log(NULL, AV_LOG_ERROR, "CABAC bypass bits failure at %d\n", i);
+                ret = 1;
+            }
+        }
+    }
+
+    memset(state, 0, sizeof(state));
+
+    for(i=0; i<SIZE; i++){
+        if ((r[i] & 1) != get_cabac_noinline(&c.dec, state)) {
+            av_log(NULL, AV_LOG_ERROR, "CABAC failure after bypass bits at %d\n", i);
+            ret = 1;
+        }
+    }
+    if (!get_cabac_terminate(&c.dec)) {
+        av_log(NULL, AV_LOG_ERROR, "where's the Terminator after bypass bits?\n");
+        ret = 1;
+    }
+
     return ret;
 }
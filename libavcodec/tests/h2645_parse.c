@@ -0,0 +1,275 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+#include "libavcodec/defs.h"
+#include "libavcodec/h2645_parse.h"
+#include "libavcodec/startcode.h"
+
+#define NB_NALS     64
+#define MAX_PAYLOAD 4096
+/* NAL units and start code offsets spanning a few words of the
+ * word-at-a-time scans */
+#define MAX_SHORT   27
+#define SCAN_SIZE   48
+
+typedef struct TestNAL {
+    uint8_t payload[MAX_PAYLOAD];
+    int     size;
+    int     nb_escapes;
+} TestNAL;
+
+/* Random NAL units with a configurable density of zero bytes, so that
+ * both long runs without any zero and frequent emulation prevention
+ * bytes are exercised. */
+static void gen_payload(AVLFG *lfg, TestNAL *nal, int zero_prob)
+{
+    nal->size       = 2 + av_lfg_get(lfg) % (MAX_PAYLOAD - 2);
+    nal->payload[0] = 0x65;
+    for (int i = 1; i < nal->size; i++) {
+        unsigned r = av_lfg_get(lfg);
+        nal->payload[i] = r % 256 < zero_prob ? (r >> 8) % 4 : r >> 8;
+    }
+    nal->payload[nal->size - 1] |= 0x80;
+}
+
+static int write_nal(uint8_t *dst, TestNAL *nal, int long_start_code)
+{
+    int pos = 0, zeros = 0;
+
+    if (long_start_code)
+        dst[pos++] = 0;
+    dst[pos++] = 0;
+    dst[pos++] = 0;
+    dst[pos++] = 1;
+
+    nal->nb_escapes = 0;
+    for (int i = 0; i < nal->size; i++) {
+        if (zeros == 2 && nal->payload[i] <= 3) {
+            dst[pos++] = 3;
+            nal->nb_escapes++;
+            zeros = 0;
+        }
+        dst[pos++] = nal->payload[i];
+        zeros = nal->payload[i] ? 0 : zeros + 1;
+    }
+    return pos;
+}
+
+static int check_packet(const H2645Packet *pkt, const TestNAL *nals, int nb_nals)
+{
+    if (pkt->nb_nals != nb_nals) {
+        fprintf(stderr, "expected %d NAL units, got %d\n", nb_nals, pkt->nb_nals);
+        return 1;
+    }
+
+    for (int i = 0; i < nb_nals; i++) {
+        const H2645NAL *nal = &pkt->nals[i];
+
+        if (nal->size < nals[i].size ||
+            memcmp(nal->data, nals[i].payload, nals[i].size)) {
+            fprintf(stderr, "NAL %d: payload mismatch\n", i);
+            return 1;
+        }
+        for (int j = nals[i].size; j < nal->size; j++) {
+            if (nal->data[j]) {
+                fprintf(stderr, "NAL %d: trailing garbage\n", i);
+                return 1;
+            }
+        }
+        if (nal->skipped_bytes != nals[i].nb_escapes) {
+            fprintf(stderr, "NAL %d: expected %d escapes, got %d\n",
+                    i, nals[i].nb_escapes, nal->skipped_bytes);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Short NAL units without zero bytes of 1 to MAX_SHORT bytes, so that
+ * each following start code is found at every offset from the previous
+ * one, including straddling a word boundary, and the last one ends at the
+ * end of the buffer. The first start code is preceded by 0 to MAX_SHORT
+ * bytes of garbage, which are scanned by find_next_start_code(), and the
+ * buffer itself is misaligned by 0 to 7 bytes. */
+static int test_short_nals(H2645Packet *pkt, TestNAL *nals, uint8_t *buf, AVLFG *lfg)
+{
+    for (int garbage = 0; garbage <= MAX_SHORT; garbage++) {
+        for (int nb_nals = 1; nb_nals <= MAX_SHORT; nb_nals++) {
+            for (int misalign = 0; misalign < 8; misalign++) {
+                uint8_t *start = buf + misalign;
+                int size = garbage, err;
+
+                for (int i = 0; i < garbage; i++)
+                    start[i] = 1 + av_lfg_get(lfg) % 255;
+                for (int i = 0; i < nb_nals; i++) {
+                    TestNAL *nal = &nals[i];
+
+                    nal->size       = i + 1;
+                    nal->payload[0] = 0x65;
+                    for (int j = 1; j < nal->size; j++)
+                        nal->payload[j] = 1 + av_lfg_get(lfg) % 255;
+                    nal->payload[nal->size - 1] |= 1;
+                    size += write_nal(start + size, nal, (i + misalign) & 1);
+                }
+                memset(start + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+                err = ff_h2645_packet_split(pkt, start, size, NULL, 0,
+                                            AV_CODEC_ID_H264, 0);
+                if (err < 0 || check_packet(pkt, nals, nb_nals)) {
+                    fprintf(stderr, "split failed, %d bytes of garbage, %d short NAL units, "
+                            "misalignment %d\n", garbage, nb_nals, misalign);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* The frame boundary search of the HEVC and VVC parsers: every byte is
+ * shifted into state64 and a start code prefix is checked in bits 24-47,
+ * positions without one may be skipped with ff_startcode_skip(). */
+static int scan_start_codes(const uint8_t *buf, int size, uint64_t *state64,
+                            int skip, int offset, int *found)
+{
+    int nb_found = 0;
+
+    for (int i = 0; i < size; i++) {
+        if (skip) {
+            i = ff_startcode_skip(buf, i, size, state64);
+            if (i >= size)
+                break;
+        }
+        *state64 = (*state64 << 8) | buf[i];
+        if (((*state64 >> 3 * 8) & 0xFFFFFF) == 0x000001)
+            found[nb_found++] = offset + i;
+    }
+    return nb_found;
+}
+
+/* A start code at every offset of a buffer, including straddling the word
+ * boundaries and reaching into its last bytes, scanned in two calls split
+ * at every position so that the prefix is also split between calls. */
+static int test_startcode_skip(AVLFG *lfg)
+{
+    static const uint64_t init_states[] = { 0, UINT64_MAX };
+    uint8_t buf[SCAN_SIZE];
+
+    for (int sc = 0; sc < SCAN_SIZE; sc++) {
+        /* bytes 1 and 2 take the other branches of the skip */
+        for (int i = 0; i < SCAN_SIZE; i++) {
+            unsigned r = av_lfg_get(lfg);
+            buf[i] = r % 4 ? 1 + (r >> 8) % 255 : 1 + (r >> 8) % 2;
+        }
+        for (int i = sc; i < FFMIN(sc + 2, SCAN_SIZE); i++)
+            buf[i] = 0;
+        if (sc + 2 < SCAN_SIZE)
+            buf[sc + 2] = 1;
+
+        for (int k = 0; k < FF_ARRAY_ELEMS(init_states); k++) {
+            for (int split = 0; split <= SCAN_SIZE; split++) {
+                int found[2][SCAN_SIZE], nb_found[2];
+                uint64_t state64[2];
+
+                for (int skip = 0; skip < 2; skip++) {
+                    state64[skip]  = init_states[k];
+                    nb_found[skip] = scan_start_codes(buf, split, &state64[skip],
+                                                      skip, 0, found[skip]);
+                    nb_found[skip] += scan_start_codes(buf + split, SCAN_SIZE - split,
+                                                       &state64[skip], skip, split,
+                                                       found[skip] + nb_found[skip]);
+                }
+                if (nb_found[0] != nb_found[1] || state64[0] != state64[1] ||
+                    memcmp(found[0], found[1], nb_found[0] * sizeof(*found[0]))) {
+                    fprintf(stderr, "ff_startcode_skip() mismatch, start code at %d, "
+                            "split at %d, initial state %d\n", sc, split, k);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const int zero_probs[] = { 0, 2, 32, 128, 256 };
+    int iterations = argc > 1 ? atoi(argv[1]) : 0;
+    H2645Packet pkt = { 0 };
+    TestNAL *nals;
+    uint8_t *buf;
+    AVLFG lfg;
+    int ret = 0;
+
+    nals = av_malloc_array(NB_NALS, sizeof(*nals));
+    buf  = av_malloc(NB_NALS * (4 + MAX_PAYLOAD * 3 / 2) + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!nals || !buf) {
+        ret = 2;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int k = 0; k < FF_ARRAY_ELEMS(zero_probs); k++) {
+        int size = 0;
+
+        for (int i = 0; i < NB_NALS; i++) {
+            gen_payload(&lfg, &nals[i], zero_probs[k]);
+            size += write_nal(buf + size, &nals[i], i & 1);
+        }
+        memset(buf + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+        for (int flags = 0; flags <= H2645_FLAG_SMALL_PADDING; flags += H2645_FLAG_SMALL_PADDING) {
+            int err = ff_h2645_packet_split(&pkt, buf, size, NULL, 0,
+                                            AV_CODEC_ID_H264, flags);
+            if (err < 0 || check_packet(&pkt, nals, NB_NALS)) {
+                fprintf(stderr, "split failed, zero probability %d/256, flags %d\n",
+                        zero_probs[k], flags);
+                ret = 1;
+            }
+        }
+
+        /* Pass a number of iterations to benchmark the packet splitting. */
+        if (iterations > 0) {
+            int64_t start = av_gettime_relative();
+
+            for (int i = 0; i < iterations; i++)
+                ff_h2645_packet_split(&pkt, buf, size, NULL, 0, AV_CODEC_ID_H264, 0);
+            printf("zero probability %3d/256: %.1f MB/s\n", zero_probs[k],
+                   (double)size * iterations / (av_gettime_relative() - start));
+        }
+    }
+
+    if (test_short_nals(&pkt, nals, buf, &lfg) || test_startcode_skip(&lfg))
+        ret = 1;
+
+end:
+    ff_h2645_packet_uninit(&pkt);
+    av_free(nals);
+    av_free(buf);
+    return ret;
+}
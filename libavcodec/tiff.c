@@ -47,6 +47,8 @@
 #include "codec_internal.h"
 #include "decode.h"
 #include "faxcompr.h"
+#include "huffyuvdsp.h"
+#include "lossless_videodsp.h"
 #include "lzw.h"
 #include "tiff.h"
 #include "tiff_common.h"
@@ -55,6 +57,28 @@
 #include "thread.h"
 #include "get_bits.h"
 
+/**
+ * Scratch state of one slice thread, strips are decoded concurrently.
+ */
+typedef struct TiffThreadData {
+    GetByteContext gb;
+    LZWState *lzw;
+
+    uint8_t *deinvert_buf;
+    int deinvert_buf_size;
+    uint8_t *yuv_line;
+    unsigned int yuv_line_size;
+    uint8_t *fp_line;            ///< floating point predictor line
+    unsigned int fp_line_size;
+} TiffThreadData;
+
+typedef struct TiffStrip {
+    const uint8_t *src;
+    int size;
+    int start, lines;
+    int ret;
+} TiffStrip;
+
 typedef struct TiffContext {
     AVClass *class;
     AVCodecContext *avctx;
@@ -107,7 +131,6 @@ typedef struct TiffContext {
     int strips, rps, sstype;
     int sot;
     int stripsizesoff, stripsize, stripoff, strippos;
-    LZWState *lzw;
 
     /* Tile support */
     int is_tiled;
@@ -116,10 +139,18 @@ typedef struct TiffContext {
 
     int is_jpeg;
 
-    uint8_t *deinvert_buf;
-    int deinvert_buf_size;
-    uint8_t *yuv_line;
-    unsigned int yuv_line_size;
+    TiffThreadData *thread_data;
+    int nb_thread_data;
+
+    /* strips of the plane being decoded */
+    TiffStrip *strip_jobs;
+    unsigned int strip_jobs_size;
+    AVFrame *frame;
+    uint8_t *plane_dst;
+    int plane_stride;
+
+    LLVidDSPContext llviddsp;
+    HuffYUVDSPContext hdsp;
 
     int geotag_count;
     TiffGeoTag *geotags;
@@ -438,15 +469,15 @@ static void av_always_inline horizontal_fill(TiffContext *s,
     }
 }
 
-static int deinvert_buffer(TiffContext *s, const uint8_t *src, int size)
+static int deinvert_buffer(TiffThreadData *td, const uint8_t *src, int size)
 {
     int i;
 
-    av_fast_padded_malloc(&s->deinvert_buf, &s->deinvert_buf_size, size);
-    if (!s->deinvert_buf)
+    av_fast_padded_malloc(&td->deinvert_buf, &td->deinvert_buf_size, size);
+    if (!td->deinvert_buf)
         return AVERROR(ENOMEM);
     for (i = 0; i < size; i++)
-        s->deinvert_buf[i] = ff_reverse[src[i]];
+        td->deinvert_buf[i] = ff_reverse[src[i]];
 
     return 0;
 }
@@ -515,7 +546,8 @@ static int tiff_uncompress(uint8_t *dst, unsigned long *len, const uint8_t *src,
     return zret == Z_STREAM_END ? Z_OK : zret;
 }
 
-static int tiff_unpack_zlib(TiffContext *s, AVFrame *p, uint8_t *dst, int stride,
+static int tiff_unpack_zlib(TiffContext *s, TiffThreadData *td, AVFrame *p,
+                            uint8_t *dst, int stride,
                             const uint8_t *src, int size, int width, int lines,
                             int strip_start, int is_yuv)
 {
@@ -527,11 +559,11 @@ static int tiff_unpack_zlib(TiffContext *s, AVFrame *p, uint8_t *dst, int stride
     if (!zbuf)
         return AVERROR(ENOMEM);
     if (s->fill_order) {
-        if ((ret = deinvert_buffer(s, src, size)) < 0) {
+        if ((ret = deinvert_buffer(td, src, size)) < 0) {
             av_free(zbuf);
             return ret;
         }
-        src = s->deinvert_buf;
+        src = td->deinvert_buf;
     }
     ret = tiff_uncompress(zbuf, &outlen, src, size);
     if (ret != Z_OK) {
@@ -582,7 +614,8 @@ static int tiff_uncompress_lzma(uint8_t *dst, uint64_t *len, const uint8_t *src,
     return ret == LZMA_STREAM_END ? LZMA_OK : ret;
 }
 
-static int tiff_unpack_lzma(TiffContext *s, AVFrame *p, uint8_t *dst, int stride,
+static int tiff_unpack_lzma(TiffContext *s, TiffThreadData *td, AVFrame *p,
+                            uint8_t *dst, int stride,
                             const uint8_t *src, int size, int width, int lines,
                             int strip_start, int is_yuv)
 {
@@ -592,11 +625,11 @@ static int tiff_unpack_lzma(TiffContext *s, AVFrame *p, uint8_t *dst, int stride
     if (!buf)
         return AVERROR(ENOMEM);
     if (s->fill_order) {
-        if ((ret = deinvert_buffer(s, src, size)) < 0) {
+        if ((ret = deinvert_buffer(td, src, size)) < 0) {
             av_free(buf);
             return ret;
         }
-        src = s->deinvert_buf;
+        src = td->deinvert_buf;
     }
     ret = tiff_uncompress_lzma(buf, &outlen, src, size);
     if (ret != LZMA_OK) {
@@ -625,16 +658,17 @@ static int tiff_unpack_lzma(TiffContext *s, AVFrame *p, uint8_t *dst, int stride
 }
 #endif
 
-static int tiff_unpack_fax(TiffContext *s, uint8_t *dst, int stride,
-                           const uint8_t *src, int size, int width, int lines)
+static int tiff_unpack_fax(TiffContext *s, TiffThreadData *td, uint8_t *dst,
+                           int stride, const uint8_t *src, int size, int width,
+                           int lines)
 {
     int line;
     int ret;
 
     if (s->fill_order) {
-        if ((ret = deinvert_buffer(s, src, size)) < 0)
+        if ((ret = deinvert_buffer(td, src, size)) < 0)
             return ret;
-        src = s->deinvert_buf;
+        src = td->deinvert_buf;
     }
     ret = ff_ccitt_unpack(s->avctx, src, size, dst, lines, stride,
                           s->compr, s->fax_opts);
@@ -736,8 +770,9 @@ static int dng_decode_jpeg(AVCodecContext *avctx, AVFrame *frame,
     return 0;
 }
 
-static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int stride,
-                             const uint8_t *src, int size, int strip_start, int lines)
+static int tiff_unpack_strip(TiffContext *s, TiffThreadData *td, AVFrame *p,
+                             uint8_t *dst, int stride, const uint8_t *src,
+                             int size, int strip_start, int lines)
 {
     PutByteContext pb;
     int c, line, pixels, code, ret;
@@ -758,12 +793,12 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
     if (is_yuv) {
         int bytes_per_row = (((s->width - 1) / s->subsampling[0] + 1) * s->bpp *
                             s->subsampling[0] * s->subsampling[1] + 7) >> 3;
-        av_fast_padded_malloc(&s->yuv_line, &s->yuv_line_size, bytes_per_row);
-        if (s->yuv_line == NULL) {
+        av_fast_padded_malloc(&td->yuv_line, &td->yuv_line_size, bytes_per_row);
+        if (td->yuv_line == NULL) {
             av_log(s->avctx, AV_LOG_ERROR, "Not enough memory\n");
             return AVERROR(ENOMEM);
         }
-        dst = s->yuv_line;
+        dst = td->yuv_line;
         stride = 0;
 
         width = (s->width - 1) / s->subsampling[0] + 1;
@@ -776,18 +811,18 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
     }
     av_assert0(!(s->is_bayer && is_yuv));
     if (p->format == AV_PIX_FMT_GRAY12) {
-        av_fast_padded_malloc(&s->yuv_line, &s->yuv_line_size, width);
-        if (s->yuv_line == NULL) {
+        av_fast_padded_malloc(&td->yuv_line, &td->yuv_line_size, width);
+        if (td->yuv_line == NULL) {
             av_log(s->avctx, AV_LOG_ERROR, "Not enough memory\n");
             return AVERROR(ENOMEM);
         }
-        dst = s->yuv_line;
+        dst = td->yuv_line;
         stride = 0;
     }
 
     if (s->compr == TIFF_DEFLATE || s->compr == TIFF_ADOBE_DEFLATE) {
 #if CONFIG_ZLIB
-        return tiff_unpack_zlib(s, p, dst, stride, src, size, width, lines,
+        return tiff_unpack_zlib(s, td, p, dst, stride, src, size, width, lines,
                                 strip_start, is_yuv);
 #else
         av_log(s->avctx, AV_LOG_ERROR,
@@ -798,7 +833,7 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
     }
     if (s->compr == TIFF_LZMA) {
 #if CONFIG_LZMA
-        return tiff_unpack_lzma(s, p, dst, stride, src, size, width, lines,
+        return tiff_unpack_lzma(s, td, p, dst, stride, src, size, width, lines,
                                 strip_start, is_yuv);
 #else
         av_log(s->avctx, AV_LOG_ERROR,
@@ -808,19 +843,24 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
     }
     if (s->compr == TIFF_LZW) {
         if (s->fill_order) {
-            if ((ret = deinvert_buffer(s, src, size)) < 0)
+            if ((ret = deinvert_buffer(td, src, size)) < 0)
                 return ret;
-            ssrc = src = s->deinvert_buf;
+            ssrc = src = td->deinvert_buf;
         }
         if (size > 1 && !src[0] && (src[1]&1)) {
             av_log(s->avctx, AV_LOG_ERROR, "Old style LZW is unsupported\n");
         }
-        if ((ret = ff_lzw_decode_init(s->lzw, 8, src, size, FF_LZW_TIFF)) < 0) {
+        if (!td->lzw) {
+            ff_lzw_decode_open(&td->lzw);
+            if (!td->lzw)
+                return AVERROR(ENOMEM);
+        }
+        if ((ret = ff_lzw_decode_init(td->lzw, 8, src, size, FF_LZW_TIFF)) < 0) {
             av_log(s->avctx, AV_LOG_ERROR, "Error initializing LZW decoder\n");
             return ret;
         }
         for (line = 0; line < lines; line++) {
-            pixels = ff_lzw_decode(s->lzw, dst, width);
+            pixels = ff_lzw_decode(td->lzw, dst, width);
             if (pixels < width) {
                 av_log(s->avctx, AV_LOG_ERROR, "Decoded only %i bytes of %i\n",
                        pixels, width);
@@ -844,11 +884,11 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
         if (is_yuv || p->format == AV_PIX_FMT_GRAY12)
             return AVERROR_INVALIDDATA;
 
-        return tiff_unpack_fax(s, dst, stride, src, size, width, lines);
+        return tiff_unpack_fax(s, td, dst, stride, src, size, width, lines);
     }
 
-    bytestream2_init(&s->gb, src, size);
-    bytestream2_init_writer(&pb, dst, is_yuv ? s->yuv_line_size : (stride * lines));
+    bytestream2_init(&td->gb, src, size);
+    bytestream2_init_writer(&pb, dst, is_yuv ? td->yuv_line_size : (stride * lines));
 
     is_dng = (s->tiff_type == TIFF_TYPE_DNG || s->tiff_type == TIFF_TYPE_CINEMADNG);
 
@@ -860,6 +900,8 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
         }
         if (!s->is_bayer)
             return AVERROR_PATCHWELCOME;
+        /* these strips are never decoded concurrently */
+        bytestream2_init(&s->gb, src, size);
         if ((ret = dng_decode_jpeg(s->avctx, p, s->stripsize, 0, 0, s->width, s->height)) < 0)
             return ret;
         return 0;
@@ -874,7 +916,7 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
             return AVERROR_INVALIDDATA;
         }
 
-        if (bytestream2_get_bytes_left(&s->gb) == 0 || bytestream2_get_eof(&pb))
+        if (bytestream2_get_bytes_left(&td->gb) == 0 || bytestream2_get_eof(&pb))
             break;
         bytestream2_seek_p(&pb, stride * line, SEEK_SET);
         switch (s->compr) {
@@ -965,6 +1007,145 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
     return 0;
 }
 
+static void undo_horizontal_predictor(TiffContext *s, uint8_t *dst, int stride,
+                                      int lines)
+{
+    enum AVPixelFormat pix_fmt = s->avctx->pix_fmt;
+    int soff, ssize, i, j;
+
+    soff  = s->bpp >> 3;
+    if (s->planar)
+        soff  = FFMAX(soff / s->bppcount, 1);
+    ssize = s->width * soff;
+    if (pix_fmt == AV_PIX_FMT_RGB48LE   || pix_fmt == AV_PIX_FMT_RGBA64LE ||
+        pix_fmt == AV_PIX_FMT_GRAY16LE  || pix_fmt == AV_PIX_FMT_YA16LE   ||
+        pix_fmt == AV_PIX_FMT_GBRP16LE  || pix_fmt == AV_PIX_FMT_GBRAP16LE) {
+        for (i = 0; i < lines; i++) {
+            if (!HAVE_BIGENDIAN && soff == 2) {
+                s->llviddsp.add_left_pred_int16((uint16_t *)dst, (uint16_t *)dst,
+                                                0xFFFF, ssize >> 1, 0);
+            } else {
+                for (j = soff; j < ssize; j += 2)
+                    AV_WL16(dst + j, AV_RL16(dst + j) + AV_RL16(dst + j - soff));
+            }
+            dst += stride;
+        }
+    } else if (pix_fmt == AV_PIX_FMT_RGB48BE  || pix_fmt == AV_PIX_FMT_RGBA64BE ||
+               pix_fmt == AV_PIX_FMT_GRAY16BE || pix_fmt == AV_PIX_FMT_YA16BE   ||
+               pix_fmt == AV_PIX_FMT_GBRP16BE || pix_fmt == AV_PIX_FMT_GBRAP16BE) {
+        for (i = 0; i < lines; i++) {
+            if (HAVE_BIGENDIAN && soff == 2) {
+                s->llviddsp.add_left_pred_int16((uint16_t *)dst, (uint16_t *)dst,
+                                                0xFFFF, ssize >> 1, 0);
+            } else {
+                for (j = soff; j < ssize; j += 2)
+                    AV_WB16(dst + j, AV_RB16(dst + j) + AV_RB16(dst + j - soff));
+            }
+            dst += stride;
+        }
+    } else {
+        for (i = 0; i < lines; i++) {
+            if (soff == 1) {
+                s->llviddsp.add_left_pred(dst, dst, ssize, 0);
+            } else if (soff == 4) {
+                uint8_t left[4] = { 0 };
+                s->hdsp.add_hfyu_left_pred_bgr32(dst, dst, ssize >> 2, left);
+            } else {
+                for (j = soff; j < ssize; j++)
+                    dst[j] += dst[j - soff];
+            }
+            dst += stride;
+        }
+    }
+}
+
+/* Floating point predictor
+   TIFF Technical Note 3 http://chriscox.org/TIFFTN3d1.pdf */
+static void undo_fp_predictor(TiffContext *s, TiffThreadData *td, uint8_t *dst,
+                              int stride, int lines)
+{
+    enum AVPixelFormat pix_fmt = s->avctx->pix_fmt;
+    int channels = s->bppcount;
+    uint8_t *tmpbuf = td->fp_line;
+    int soff, ssize, bpc, group_size, i, j;
+    int is_le;
+
+    if (pix_fmt == AV_PIX_FMT_RGBF32LE || pix_fmt == AV_PIX_FMT_RGBAF32LE)
+        is_le = 1;
+    else if (pix_fmt == AV_PIX_FMT_RGBF32BE || pix_fmt == AV_PIX_FMT_RGBAF32BE)
+        is_le = 0;
+    else
+        return;
+
+    soff  = s->bpp >> 3;
+    if (s->planar) {
+        soff  = FFMAX(soff / s->bppcount, 1);
+        channels = 1;
+    }
+    ssize = s->width * soff;
+    bpc = FFMAX(soff / s->bppcount, 1); /* Bytes per component */
+    group_size = s->width * channels;
+
+    for (i = 0; i < lines; i++) {
+        /* Decode horizontal differences */
+        if (channels == 1) {
+            s->llviddsp.add_left_pred(tmpbuf, dst, ssize, 0);
+        } else if (channels == 4) {
+            uint8_t left[4] = { 0 };
+            s->hdsp.add_hfyu_left_pred_bgr32(tmpbuf, dst, ssize >> 2, left);
+        } else {
+            /* Copy first sample byte for each channel */
+            for (j = 0; j < channels; j++)
+                tmpbuf[j] = dst[j];
+
+            for (j = channels; j < ssize; j++)
+                tmpbuf[j] = dst[j] + tmpbuf[j-channels];
+        }
+
+        /* Combine shuffled bytes from their separate groups. Each
+           byte of every floating point value in a row of pixels is
+           split and combined into separate groups. A group of all
+           the sign/exponents bytes in the row and groups for each
+           of the upper, mid, and lower mantissa bytes in the row.
+           For big-endian output the shuffle is reversed. */
+        if (is_le) {
+            for (j = 0; j < group_size; j++) {
+                for (int k = 0; k < bpc; k++) {
+                    dst[bpc * j + k] = tmpbuf[(bpc - k - 1) * group_size + j];
+                }
+            }
+        } else {
+            for (j = 0; j < group_size; j++) {
+                for (int k = 0; k < bpc; k++) {
+                    dst[bpc * j + k] = tmpbuf[k * group_size + j];
+                }
+            }
+        }
+        dst += stride;
+    }
+}
+
+static int decode_strip(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    TiffContext *s = avctx->priv_data;
+    TiffThreadData *td = &s->thread_data[threadnr];
+    TiffStrip *strip = &s->strip_jobs[jobnr];
+    uint8_t *dst = s->plane_dst + strip->start * (ptrdiff_t)s->plane_stride;
+
+    strip->ret = tiff_unpack_strip(s, td, s->frame, dst, s->plane_stride,
+                                   strip->src, strip->size, strip->start,
+                                   strip->lines);
+    if (strip->ret < 0)
+        return strip->ret;
+
+    if (s->predictor == 2)
+        undo_horizontal_predictor(s, dst, s->plane_stride, strip->lines);
+    else if (s->predictor == 3)
+        undo_fp_predictor(s, td, dst, s->plane_stride, strip->lines);
+
+    return 0;
+}
+
 static int dng_decode_tiles(AVCodecContext *avctx, AVFrame *frame,
                             const AVPacket *avpkt)
 {
@@ -2180,11 +2361,40 @@ again:
 
     /* Handle TIFF images and DNG images with uncompressed strips (non-tiled) */
 
+    if (s->is_tiled) {
+        avpriv_report_missing_feature(avctx, "Tiled TIFF");
+        return AVERROR_PATCHWELCOME;
+    }
+
+    if (s->predictor == 2 && s->photometric == TIFF_PHOTOMETRIC_YCBCR) {
+        av_log(s->avctx, AV_LOG_ERROR, "predictor == 2 with YUV is unsupported");
+        return AVERROR_PATCHWELCOME;
+    }
+    if (s->predictor == 3) {
+        if (s->avctx->pix_fmt != AV_PIX_FMT_RGBF32LE  &&
+            s->avctx->pix_fmt != AV_PIX_FMT_RGBAF32LE &&
+            s->avctx->pix_fmt != AV_PIX_FMT_RGBF32BE  &&
+            s->avctx->pix_fmt != AV_PIX_FMT_RGBAF32BE)
+            av_log(s->avctx, AV_LOG_ERROR, "unsupported floating point pixel format\n");
+
+        for (i = 0; i < s->nb_thread_data; i++) {
+            TiffThreadData *td = &s->thread_data[i];
+            av_fast_padded_malloc(&td->fp_line, &td->fp_line_size, s->width * (s->bpp >> 3));
+            if (!td->fp_line)
+                return AVERROR(ENOMEM);
+        }
+    }
+
+    av_fast_malloc(&s->strip_jobs, &s->strip_jobs_size,
+                   ((s->height - 1) / s->rps + 1) * sizeof(*s->strip_jobs));
+    if (!s->strip_jobs)
+        return AVERROR(ENOMEM);
+
     planes = s->planar ? s->bppcount : 1;
     for (plane = 0; plane < planes; plane++) {
         uint8_t *five_planes = NULL;
         int remaining = avpkt->size;
-        int decoded_height;
+        int nb_strips = 0;
         stride = p->linesize[plane];
         dst = p->data[plane];
         if (s->photometric == TIFF_PHOTOMETRIC_SEPARATED &&
@@ -2196,8 +2406,8 @@ again:
                 return AVERROR(ENOMEM);
         }
         for (i = 0; i < s->height; i += s->rps) {
-            if (i)
-                dst += s->rps * stride;
+            TiffStrip *strip = &s->strip_jobs[nb_strips++];
+
             if (s->stripsizesoff)
                 ssize = ff_tget(&stripsizes, s->sstype, le);
             else
@@ -2214,126 +2424,31 @@ again:
                 return AVERROR_INVALIDDATA;
             }
             remaining -= ssize;
-            if ((ret = tiff_unpack_strip(s, p, dst, stride, avpkt->data + soff, ssize, i,
-                                         FFMIN(s->rps, s->height - i))) < 0) {
-                if (avctx->err_recognition & AV_EF_EXPLODE) {
-                    av_freep(&five_planes);
-                    return ret;
-                }
-                break;
-            }
-        }
-        decoded_height = FFMIN(i, s->height);
 
-        if (s->predictor == 2) {
-            if (s->photometric == TIFF_PHOTOMETRIC_YCBCR) {
-                av_log(s->avctx, AV_LOG_ERROR, "predictor == 2 with YUV is unsupported");
-                return AVERROR_PATCHWELCOME;
-            }
-            dst   = five_planes ? five_planes : p->data[plane];
-            soff  = s->bpp >> 3;
-            if (s->planar)
-                soff  = FFMAX(soff / s->bppcount, 1);
-            ssize = s->width * soff;
-            if (s->avctx->pix_fmt == AV_PIX_FMT_RGB48LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_RGBA64LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_GRAY16LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_YA16LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_GBRP16LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_GBRAP16LE) {
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = soff; j < ssize; j += 2)
-                        AV_WL16(dst + j, AV_RL16(dst + j) + AV_RL16(dst + j - soff));
-                    dst += stride;
-                }
-            } else if (s->avctx->pix_fmt == AV_PIX_FMT_RGB48BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_RGBA64BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_GRAY16BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_YA16BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_GBRP16BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_GBRAP16BE) {
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = soff; j < ssize; j += 2)
-                        AV_WB16(dst + j, AV_RB16(dst + j) + AV_RB16(dst + j - soff));
-                    dst += stride;
-                }
-            } else {
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = soff; j < ssize; j++)
-                        dst[j] += dst[j - soff];
-                    dst += stride;
-                }
-            }
+            strip->src   = avpkt->data + soff;
+            strip->size  = ssize;
+            strip->start = i;
+            strip->lines = FFMIN(s->rps, s->height - i);
+            strip->ret   = 0;
         }
 
-        /* Floating point predictor
-           TIFF Technical Note 3 http://chriscox.org/TIFFTN3d1.pdf */
-        if (s->predictor == 3) {
-            int channels = s->bppcount;
-            int group_size;
-            uint8_t *tmpbuf;
-            int bpc;
-
-            dst   = five_planes ? five_planes : p->data[plane];
-            soff  = s->bpp >> 3;
-            if (s->planar) {
-                soff  = FFMAX(soff / s->bppcount, 1);
-                channels = 1;
-            }
-            ssize = s->width * soff;
-            bpc = FFMAX(soff / s->bppcount, 1); /* Bytes per component */
-            group_size = s->width * channels;
-
-            tmpbuf = av_malloc(ssize);
-            if (!tmpbuf) {
-                av_free(five_planes);
-                return AVERROR(ENOMEM);
-            }
+        s->frame        = p;
+        s->plane_dst    = dst;
+        s->plane_stride = stride;
+        if (is_dng && s->compr == TIFF_NEWJPEG) {
+            for (i = 0; i < nb_strips; i++)
+                if (decode_strip(avctx, NULL, i, 0) < 0)
+                    break;
+        } else {
+            avctx->execute2(avctx, decode_strip, NULL, NULL, nb_strips);
+        }
 
-            if (s->avctx->pix_fmt == AV_PIX_FMT_RGBF32LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_RGBAF32LE) {
-                for (i = 0; i < decoded_height; i++) {
-                    /* Copy first sample byte for each channel */
-                    for (j = 0; j < channels; j++)
-                        tmpbuf[j] = dst[j];
-
-                    /* Decode horizontal differences */
-                    for (j = channels; j < ssize; j++)
-                        tmpbuf[j] = dst[j] + tmpbuf[j-channels];
-
-                    /* Combine shuffled bytes from their separate groups. Each
-                       byte of every floating point value in a row of pixels is
-                       split and combined into separate groups. A group of all
-                       the sign/exponents bytes in the row and groups for each
-                       of the upper, mid, and lower mantissa bytes in the row. */
-                    for (j = 0; j < group_size; j++) {
-                        for (int k = 0; k < bpc; k++) {
-                            dst[bpc * j + k] = tmpbuf[(bpc - k - 1) * group_size + j];
-                        }
-                    }
-                    dst += stride;
-                }
-            } else if (s->avctx->pix_fmt == AV_PIX_FMT_RGBF32BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_RGBAF32BE) {
-                /* Same as LE only the shuffle at the end is reversed */
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = 0; j < channels; j++)
-                        tmpbuf[j] = dst[j];
-
-                    for (j = channels; j < ssize; j++)
-                        tmpbuf[j] = dst[j] + tmpbuf[j-channels];
-
-                    for (j = 0; j < group_size; j++) {
-                        for (int k = 0; k < bpc; k++) {
-                            dst[bpc * j + k] = tmpbuf[k * group_size + j];
-                        }
-                    }
-                    dst += stride;
-                }
-            } else {
-                av_log(s->avctx, AV_LOG_ERROR, "unsupported floating point pixel format\n");
+        for (i = 0; i < nb_strips; i++) {
+            ret = s->strip_jobs[i].ret;
+            if (ret < 0 && (avctx->err_recognition & AV_EF_EXPLODE)) {
+                av_freep(&five_planes);
+                return ret;
             }
-            av_free(tmpbuf);
         }
 
         if (s->photometric == TIFF_PHOTOMETRIC_WHITE_IS_ZERO) {
@@ -2417,10 +2532,15 @@ static av_cold int tiff_init(AVCodecContext *avctx)
     s->subsampling[0] =
     s->subsampling[1] = 1;
     s->avctx  = avctx;
-    ff_lzw_decode_open(&s->lzw);
-    if (!s->lzw)
-        return AVERROR(ENOMEM);
     ff_ccitt_unpack_init();
+    ff_llviddsp_init(&s->llviddsp);
+    ff_huffyuvdsp_init(&s->hdsp, AV_PIX_FMT_NONE);
+
+    s->nb_thread_data = avctx->active_thread_type & FF_THREAD_SLICE ?
+                        avctx->thread_count : 1;
+    s->thread_data    = av_calloc(s->nb_thread_data, sizeof(*s->thread_data));
+    if (!s->thread_data)
+        return AVERROR(ENOMEM);
 
     /* Allocate JPEG frame */
     s->jpgframe = av_frame_alloc();
@@ -2453,11 +2573,18 @@ static av_cold int tiff_end(AVCodecContext *avctx)
 
     free_geotags(s);
 
-    ff_lzw_decode_close(&s->lzw);
-    av_freep(&s->deinvert_buf);
-    s->deinvert_buf_size = 0;
-    av_freep(&s->yuv_line);
-    s->yuv_line_size = 0;
+    for (int i = 0; i < s->nb_thread_data; i++) {
+        TiffThreadData *td = &s->thread_data[i];
+
+        ff_lzw_decode_close(&td->lzw);
+        av_freep(&td->deinvert_buf);
+        av_freep(&td->yuv_line);
+        av_freep(&td->fp_line);
+    }
+    av_freep(&s->thread_data);
+    s->nb_thread_data = 0;
+    av_freep(&s->strip_jobs);
+    s->strip_jobs_size = 0;
     av_frame_free(&s->jpgframe);
     av_packet_free(&s->jpkt);
     avcodec_free_context(&s->avctx_mjpeg);
@@ -2488,7 +2615,8 @@ const FFCodec ff_tiff_decoder = {
     .init           = tiff_init,
     .close          = tiff_end,
     FF_CODEC_DECODE_CB(decode_frame),
-    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES |
                       FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
     .p.priv_class   = &tiff_decoder_class,
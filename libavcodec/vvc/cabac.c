@@ -876,13 +876,10 @@ static void vvc_refill2(CABACContext* c) {
 #endif
 
     c->low += x << i;
-#if !UNCHECKED_BITSTREAM_READER
-    if (c->bytestream < c->bytestream_end)
-#endif
-        c->bytestream += CABAC_BITS / 8;
+    CABAC_ADVANCE(c->bytestream, c->bytestream_end);
 }
 
-static int inline vvc_get_cabac(CABACContext *c, VVCCabacState* base, const int ctx)
+static av_always_inline int vvc_get_cabac(CABACContext *c, VVCCabacState* base, const int ctx)
 {
     VVCCabacState *s = base + ctx;
     const int qRangeIdx = c->range >> 5;
@@ -918,9 +915,7 @@ static int truncated_binary_decode(VVCLocalContext *lc, const int c_max)
     const int n = c_max + 1;
     const int k = av_log2(n);
     const int u = (1 << (k+1)) - n;
-    int v = 0;
-    for (int i = 0; i < k; i++)
-        v = (v << 1) | get_cabac_bypass(&lc->ep->cc);
+    int v = get_cabac_bypass_bits(&lc->ep->cc, k);
     if (v >= u) {
         v = (v << 1) | get_cabac_bypass(&lc->ep->cc);
         v -= u;
@@ -933,16 +928,14 @@ static int limited_kth_order_egk_decode(CABACContext *c, const int k, const int
 {
     int pre_ext_len = 0;
     int escape_length;
-    int val = 0;
+    int val;
     while ((pre_ext_len < max_pre_ext_len) && get_cabac_bypass(c))
         pre_ext_len++;
     if (pre_ext_len == max_pre_ext_len)
         escape_length = trunc_suffix_len;
     else
         escape_length = pre_ext_len + k;
-    while (escape_length-- > 0) {
-        val = (val << 1) + get_cabac_bypass(c);
-    }
+    val  = get_cabac_bypass_bits(c, escape_length);
     val += ((1 << pre_ext_len) - 1) << k;
     return val;
 }
@@ -1884,9 +1877,7 @@ static int abs_decode(VVCLocalContext *lc, const int c_rice_param)
     while (prefix < MAX_BIN && get_cabac_bypass(&lc->ep->cc))
         prefix++;
     if (prefix < MAX_BIN) {
-        for (int i = 0; i < c_rice_param; i++) {
-            suffix = (suffix << 1) | get_cabac_bypass(&lc->ep->cc);
-        }
+        suffix = get_cabac_bypass_bits(&lc->ep->cc, c_rice_param);
     } else {
         suffix = limited_kth_order_egk_decode(&lc->ep->cc,
                                               c_rice_param + 1,
@@ -24,6 +24,7 @@
 #include "cbs.h"
 #include "cbs_h266.h"
 #include "parser.h"
+#include "startcode.h"
 
 #define START_CODE 0x000001 ///< start_code_prefix_one_3bytes
 #define IS_IDR(nut)   (nut == VVC_IDR_W_RADL || nut == VVC_IDR_N_LP)
@@ -92,6 +93,10 @@ static int find_frame_end(AVCodecParserContext *s, const uint8_t *buf,
     for (i = 0; i < buf_size; i++) {
         int nut, code_len;
 
+        i = ff_startcode_skip(buf, i, buf_size, &pc->state64);
+        if (i >= buf_size)
+            break;
+
         pc->state64 = (pc->state64 << 8) | buf[i];
 
         if (((pc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
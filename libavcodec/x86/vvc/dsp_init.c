@@ -155,6 +155,29 @@ ALF_PROTOTYPES(8,  8,  avx2)
 ALF_PROTOTYPES(16, 10, avx2)
 ALF_PROTOTYPES(16, 12, avx2)
 
+#define SAO_BAND_FILTER_PROTOTYPE(w, bd, opt)                                                                     \
+void ff_hevc_sao_band_filter_##w##_##bd##_##opt(uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride,           \
+    ptrdiff_t src_stride, const int16_t *sao_offset_val, int sao_left_class, int width, int height);
+
+#define SAO_BAND_FILTER_PROTOTYPES(bd, opt)                                                                       \
+    SAO_BAND_FILTER_PROTOTYPE( 8, bd, opt)                                                                        \
+    SAO_BAND_FILTER_PROTOTYPE(16, bd, opt)                                                                        \
+    SAO_BAND_FILTER_PROTOTYPE(32, bd, opt)                                                                        \
+    SAO_BAND_FILTER_PROTOTYPE(48, bd, opt)                                                                        \
+    SAO_BAND_FILTER_PROTOTYPE(64, bd, opt)                                                                        \
+void ff_vvc_sao_band_filter_80_##bd##_##opt(uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride,               \
+    ptrdiff_t src_stride, const int16_t *sao_offset_val, int sao_left_class, int width, int height);              \
+void ff_vvc_sao_band_filter_96_##bd##_##opt(uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride,               \
+    ptrdiff_t src_stride, const int16_t *sao_offset_val, int sao_left_class, int width, int height);              \
+void ff_vvc_sao_band_filter_112_##bd##_##opt(uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride,              \
+    ptrdiff_t src_stride, const int16_t *sao_offset_val, int sao_left_class, int width, int height);              \
+void ff_vvc_sao_band_filter_128_##bd##_##opt(uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride,              \
+    ptrdiff_t src_stride, const int16_t *sao_offset_val, int sao_left_class, int width, int height);
+
+SAO_BAND_FILTER_PROTOTYPES( 8, avx2)
+SAO_BAND_FILTER_PROTOTYPES(10, avx2)
+SAO_BAND_FILTER_PROTOTYPES(12, avx2)
+
 #if ARCH_X86_64
 #if HAVE_SSE4_EXTERNAL
 #define FW_PUT(name, depth, opt) \
@@ -275,6 +298,29 @@ ALF_FUNCS(8,  8,  avx2)
 ALF_FUNCS(16, 10, avx2)
 ALF_FUNCS(16, 12, avx2)
 
+// The band filter is shared with HEVC, which stops at 64 pixel wide blocks.
+// VVC CTBs can be up to 128 wide, so wider blocks are split in two columns.
+#define SAO_BAND_FILTER_WIDE(w, rw, bd, opt)                                                                      \
+void ff_vvc_sao_band_filter_##w##_##bd##_##opt(uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride,        \
+    ptrdiff_t src_stride, const int16_t *sao_offset_val, int sao_left_class, int width, int height)               \
+{                                                                                                                 \
+    const int offset = 64 * ((bd + 7) / 8);                                                                       \
+    ff_hevc_sao_band_filter_64_##bd##_##opt(dst, src, dst_stride, src_stride,                                     \
+        sao_offset_val, sao_left_class, 64, height);                                                              \
+    ff_hevc_sao_band_filter_##rw##_##bd##_##opt(dst + offset, src + offset, dst_stride, src_stride,               \
+        sao_offset_val, sao_left_class, width - 64, height);                                                      \
+}
+
+#define SAO_BAND_FILTER_FUNCS(bd, opt)                                                                            \
+    SAO_BAND_FILTER_WIDE( 80, 16, bd, opt)                                                                        \
+    SAO_BAND_FILTER_WIDE( 96, 32, bd, opt)                                                                        \
+    SAO_BAND_FILTER_WIDE(112, 48, bd, opt)                                                                        \
+    SAO_BAND_FILTER_WIDE(128, 64, bd, opt)
+
+SAO_BAND_FILTER_FUNCS( 8, avx2)
+SAO_BAND_FILTER_FUNCS(10, avx2)
+SAO_BAND_FILTER_FUNCS(12, avx2)
+
 #endif
 
 #define PEL_LINK(dst, C, W, idx1, idx2, name, D, opt)                              \
@@ -364,6 +410,18 @@ ALF_FUNCS(16, 12, avx2)
     c->alf.classify       = ff_vvc_alf_classify_##bd##_avx2;         \
 } while (0)
 
+#define SAO_INIT(bd, opt) do {                                                \
+    c->sao.band_filter[0] = ff_hevc_sao_band_filter_8_##bd##_##opt;          \
+    c->sao.band_filter[1] = ff_hevc_sao_band_filter_16_##bd##_##opt;         \
+    c->sao.band_filter[2] = ff_hevc_sao_band_filter_32_##bd##_##opt;         \
+    c->sao.band_filter[3] = ff_hevc_sao_band_filter_48_##bd##_##opt;         \
+    c->sao.band_filter[4] = ff_hevc_sao_band_filter_64_##bd##_##opt;         \
+    c->sao.band_filter[5] = ff_vvc_sao_band_filter_80_##bd##_##opt;          \
+    c->sao.band_filter[6] = ff_vvc_sao_band_filter_96_##bd##_##opt;          \
+    c->sao.band_filter[7] = ff_vvc_sao_band_filter_112_##bd##_##opt;         \
+    c->sao.band_filter[8] = ff_vvc_sao_band_filter_128_##bd##_##opt;         \
+} while (0)
+
 int ff_vvc_sad_avx2(const int16_t *src0, const int16_t *src1, int dx, int dy, int block_w, int block_h);
 #define SAD_INIT() c->inter.sad = ff_vvc_sad_avx2
 #endif
@@ -388,6 +446,7 @@ void ff_vvc_dsp_init_x86(VVCDSPContext *const c, const int bd)
             OF_INIT(8);
             DMVR_INIT(8);
             SAD_INIT();
+            SAO_INIT(8, avx2);
         }
         break;
     case 10:
@@ -402,6 +461,7 @@ void ff_vvc_dsp_init_x86(VVCDSPContext *const c, const int bd)
             OF_INIT(10);
             DMVR_INIT(10);
             SAD_INIT();
+            SAO_INIT(10, avx2);
         }
         break;
     case 12:
@@ -416,6 +476,7 @@ void ff_vvc_dsp_init_x86(VVCDSPContext *const c, const int bd)
             OF_INIT(12);
             DMVR_INIT(12);
             SAD_INIT();
+            SAO_INIT(12, avx2);
         }
         break;
     default:
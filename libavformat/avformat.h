@@ -1479,6 +1479,12 @@ typedef struct AVFormatContext {
 #define AVFMT_FLAG_SHORTEST   0x100000 ///< Stop muxing when the shortest stream stops.
 #endif
 #define AVFMT_FLAG_AUTO_BSF   0x200000 ///< Add bitstream filters as requested by the muxer
+/**
+ * Only parse what is needed to find frame boundaries, keyframes and
+ * picture types (see PARSER_FLAG_BOUNDARIES_ONLY).  Meant for remuxing
+ * without decoding, some timestamps can not be inferred in this mode.
+ */
+#define AVFMT_FLAG_FAST_PARSE 0x400000
 
     /**
      * Maximum number of bytes read from input in order to determine stream
@@ -1431,6 +1431,8 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
                 sti->parser->flags |= PARSER_FLAG_ONCE;
             else if (sti->need_parsing == AVSTREAM_PARSE_FULL_RAW)
                 sti->parser->flags |= PARSER_FLAG_USE_CODEC_TS;
+            if (sti->parser && s->flags & AVFMT_FLAG_FAST_PARSE)
+                sti->parser->flags |= PARSER_FLAG_BOUNDARIES_ONLY;
         }
 
         if (!sti->need_parsing || !sti->parser) {
@@ -2577,6 +2579,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                 } else if (sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) {
                     sti->parser->flags |= PARSER_FLAG_USE_CODEC_TS;
                 }
+                if (ic->flags & AVFMT_FLAG_FAST_PARSE)
+                    sti->parser->flags |= PARSER_FLAG_BOUNDARIES_ONLY;
             } else if (sti->need_parsing) {
                 av_log(ic, AV_LOG_VERBOSE, "parser not found for codec "
                        "%s, packets or times may be invalid.\n",
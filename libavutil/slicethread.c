@@ -22,6 +22,7 @@
 #include "slicethread.h"
 #include "mem.h"
 #include "thread.h"
+#include "threadpool_internal.h"
 #include "avassert.h"
 
 #define MAX_AUTO_THREADS 16
@@ -37,6 +38,7 @@ typedef struct WorkerContext {
 } WorkerContext;
 
 struct AVSliceThread {
+    AVThreadPool    *pool;
     WorkerContext   *workers;
     int             nb_threads;
     int             nb_active_threads;
@@ -68,6 +70,21 @@ static int run_jobs(AVSliceThread *ctx)
     return current_job == nb_jobs + nb_active_threads - 1;
 }
 
+/* With a shared pool not every participant may get to run, so no job is
+ * reserved for a participant: all jobs are taken from current_job in
+ * order and first_job only hands out the thread numbers. */
+static void run_jobs_shared(void *priv)
+{
+    AVSliceThread *ctx = priv;
+    unsigned nb_jobs    = ctx->nb_jobs;
+    unsigned nb_active_threads = ctx->nb_active_threads;
+    unsigned threadnr   = atomic_fetch_add_explicit(&ctx->first_job, 1, memory_order_acq_rel);
+    unsigned current_job;
+
+    while ((current_job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs)
+        ctx->worker_func(ctx->priv, current_job, threadnr, nb_jobs, nb_active_threads);
+}
+
 static void *attribute_align_arg thread_worker(void *v)
 {
     WorkerContext *w = v;
@@ -95,6 +112,31 @@ static void *attribute_align_arg thread_worker(void *v)
     }
 }
 
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool,
+                                   void *priv,
+                                   void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   int nb_threads)
+{
+    AVSliceThread *ctx;
+
+    av_assert0(nb_threads >= 0);
+    if (!nb_threads)
+        nb_threads = ff_thread_pool_nb_threads(pool) + 1;
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->pool        = pool;
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+
+    return nb_threads;
+}
+
 int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
                               void (*main_func)(void *priv),
@@ -194,6 +236,15 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
     av_assert0(nb_jobs > 0);
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+
+    if (ctx->pool) {
+        atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
+        atomic_store_explicit(&ctx->current_job, 0, memory_order_relaxed);
+        ff_thread_pool_run(ctx->pool, run_jobs_shared, ctx,
+                           ctx->nb_active_threads - 1);
+        return;
+    }
+
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
     atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
     nb_workers             = ctx->nb_active_threads;
@@ -231,6 +282,11 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
         return;
 
     ctx = *pctx;
+    if (ctx->pool) {
+        av_freep(pctx);
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -268,6 +324,15 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(ENOSYS);
 }
 
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool,
+                                   void *priv,
+                                   void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   int nb_threads)
+{
+    *pctx = NULL;
+    return AVERROR(ENOSYS);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
@@ -19,6 +19,8 @@
 #ifndef AVUTIL_SLICETHREAD_H
 #define AVUTIL_SLICETHREAD_H
 
+#include "threadpool.h"
+
 typedef struct AVSliceThread AVSliceThread;
 
 /**
@@ -35,6 +37,24 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Create slice threading context running its jobs on the threads of a
+ * shared pool instead of on threads of its own.
+ * The jobs are started in increasing index order, so a job may wait for
+ * the progress of a job with a lower index.
+ * @param pctx slice threading context returned here
+ * @param pool the thread pool, must outlive the context
+ * @param priv private pointer to be passed to callback function
+ * @param worker_func callback function to be executed
+ * @param nb_threads maximum number of threads running jobs of the context
+ *                   at the same time, 0 for automatic, must be >= 0
+ * @return return number of threads or negative AVERROR on failure
+ */
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool,
+                                   void *priv,
+                                   void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   int nb_threads);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
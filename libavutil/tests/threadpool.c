@@ -0,0 +1,136 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadpool.h"
+#include "libavutil/time.h"
+
+#define NB_CONTEXTS  2
+#define NB_ROUNDS  100
+#define NB_JOBS     32
+/* more threads per context than the pool has, as a codec context with
+ * thread_count above the size of the pool would use */
+#define NB_POOL_THREADS 2
+#define NB_THREADS      4
+
+/* the slice threads of one codec context */
+typedef struct Context {
+    AVSliceThread *slice;
+    pthread_t      caller;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int             progress;       ///< number of jobs finished in order
+
+    atomic_int      count[NB_JOBS];
+    atomic_int      errors;
+} Context;
+
+/* each job waits for the previous one to finish, like the rows of HEVC
+ * wavefront parallel processing */
+static void worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    Context *c = priv;
+
+    if (threadnr < 0 || threadnr >= NB_THREADS ||
+        nb_threads != NB_THREADS || nb_jobs != NB_JOBS)
+        atomic_fetch_add(&c->errors, 1);
+    atomic_fetch_add(&c->count[jobnr], 1);
+    /* give the pool threads a chance to join even on a single CPU */
+    av_usleep(100);
+
+    pthread_mutex_lock(&c->mutex);
+    while (c->progress < jobnr)
+        pthread_cond_wait(&c->cond, &c->mutex);
+    c->progress = jobnr + 1;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->mutex);
+}
+
+static void *run_context(void *arg)
+{
+    Context *c = arg;
+
+    for (int round = 0; round < NB_ROUNDS; round++) {
+        c->progress = 0;
+        for (int i = 0; i < NB_JOBS; i++)
+            atomic_store(&c->count[i], 0);
+
+        avpriv_slicethread_execute(c->slice, NB_JOBS, 0);
+
+        for (int i = 0; i < NB_JOBS; i++)
+            if (atomic_load(&c->count[i]) != 1)
+                atomic_fetch_add(&c->errors, 1);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    Context contexts[NB_CONTEXTS] = { 0 };
+    AVThreadPool *pool;
+    int ret = 0;
+
+    pool = av_thread_pool_alloc(NB_POOL_THREADS);
+    if (!pool) {
+        fprintf(stderr, "Failed to allocate the thread pool\n");
+        return 1;
+    }
+
+    for (int i = 0; i < NB_CONTEXTS; i++) {
+        Context *c = &contexts[i];
+
+        pthread_mutex_init(&c->mutex, NULL);
+        pthread_cond_init(&c->cond, NULL);
+        atomic_init(&c->errors, 0);
+        if (avpriv_slicethread_create_pool(&c->slice, pool, c, worker,
+                                           NB_THREADS) != NB_THREADS) {
+            fprintf(stderr, "Failed to create the slice threads\n");
+            return 1;
+        }
+    }
+
+    /* the contexts run their jobs on the pool at the same time */
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        if (pthread_create(&contexts[i].caller, NULL, run_context, &contexts[i])) {
+            fprintf(stderr, "Failed to start a thread\n");
+            return 1;
+        }
+
+    for (int i = 0; i < NB_CONTEXTS; i++) {
+        Context *c = &contexts[i];
+        int errors;
+
+        pthread_join(c->caller, NULL);
+        errors = atomic_load(&c->errors);
+        printf("context %d: %d rounds of %d jobs, %d errors\n",
+               i, NB_ROUNDS, NB_JOBS, errors);
+        ret |= !!errors;
+
+        avpriv_slicethread_free(&c->slice);
+        pthread_cond_destroy(&c->cond);
+        pthread_mutex_destroy(&c->mutex);
+    }
+
+    av_thread_pool_free(&pool);
+    return ret;
+}
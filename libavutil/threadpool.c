@@ -0,0 +1,222 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "cpu.h"
+#include "internal.h"
+#include "mem.h"
+#include "thread.h"
+#include "threadpool.h"
+#include "threadpool_internal.h"
+
+#if HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS
+
+typedef struct PoolWork {
+    struct PoolWork *next;
+    void           (*func)(void *opaque);
+    void            *opaque;
+    int              nb_pending;    ///< helpers which have not started yet
+    int              nb_running;    ///< helpers currently running func
+} PoolWork;
+
+struct AVThreadPool {
+    pthread_t       *threads;
+    int              nb_threads;
+
+    pthread_mutex_t  mutex;
+    pthread_cond_t   work_cond;     ///< signalled when work is queued
+    pthread_cond_t   done_cond;     ///< signalled when a helper finishes
+    PoolWork        *first;
+    PoolWork        *last;
+    int              exit;
+};
+
+static void remove_work(AVThreadPool *pool, PoolWork *work)
+{
+    PoolWork **p = &pool->first, *prev = NULL;
+
+    while (*p != work) {
+        prev = *p;
+        p    = &(*p)->next;
+    }
+    *p = work->next;
+    if (pool->last == work)
+        pool->last = prev;
+}
+
+static void *attribute_align_arg pool_worker(void *v)
+{
+    AVThreadPool *pool = v;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        PoolWork *work;
+
+        while (!pool->first && !pool->exit)
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        if (pool->exit)
+            break;
+
+        work = pool->first;
+        work->nb_running++;
+        if (!--work->nb_pending)
+            remove_work(pool, work);
+        pthread_mutex_unlock(&pool->mutex);
+
+        work->func(work->opaque);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (!--work->nb_running)
+            pthread_cond_broadcast(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+void ff_thread_pool_run(AVThreadPool *pool, void (*func)(void *opaque),
+                        void *opaque, int nb_helpers)
+{
+    PoolWork work = {
+        .func       = func,
+        .opaque     = opaque,
+        .nb_pending = FFMIN(nb_helpers, pool->nb_threads),
+    };
+    const int queued = work.nb_pending > 0;
+
+    if (queued) {
+        pthread_mutex_lock(&pool->mutex);
+        if (pool->last)
+            pool->last->next = &work;
+        else
+            pool->first = &work;
+        pool->last = &work;
+        if (work.nb_pending > 1)
+            pthread_cond_broadcast(&pool->work_cond);
+        else
+            pthread_cond_signal(&pool->work_cond);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    func(opaque);
+
+    if (queued) {
+        pthread_mutex_lock(&pool->mutex);
+        if (work.nb_pending)
+            remove_work(pool, &work);
+        while (work.nb_running)
+            pthread_cond_wait(&pool->done_cond, &pool->mutex);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+int ff_thread_pool_nb_threads(const AVThreadPool *pool)
+{
+    return pool->nb_threads;
+}
+
+AVThreadPool *av_thread_pool_alloc(int nb_threads)
+{
+    AVThreadPool *pool;
+
+    if (nb_threads < 0)
+        return NULL;
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (!pool->threads)
+        goto fail_alloc;
+
+    if (pthread_mutex_init(&pool->mutex, NULL))
+        goto fail_alloc;
+    if (pthread_cond_init(&pool->work_cond, NULL))
+        goto fail_mutex;
+    if (pthread_cond_init(&pool->done_cond, NULL))
+        goto fail_work_cond;
+
+    for (; pool->nb_threads < nb_threads; pool->nb_threads++) {
+        if (pthread_create(&pool->threads[pool->nb_threads], NULL,
+                           pool_worker, pool)) {
+            av_thread_pool_free(&pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+
+fail_work_cond:
+    pthread_cond_destroy(&pool->work_cond);
+fail_mutex:
+    pthread_mutex_destroy(&pool->mutex);
+fail_alloc:
+    av_freep(&pool->threads);
+    av_freep(&pool);
+    return NULL;
+}
+
+void av_thread_pool_free(AVThreadPool **ppool)
+{
+    AVThreadPool *pool = *ppool;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->exit = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->threads);
+    av_freep(ppool);
+}
+
+#else /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS */
+
+void ff_thread_pool_run(AVThreadPool *pool, void (*func)(void *opaque),
+                        void *opaque, int nb_helpers)
+{
+    func(opaque);
+}
+
+int ff_thread_pool_nb_threads(const AVThreadPool *pool)
+{
+    return 0;
+}
+
+AVThreadPool *av_thread_pool_alloc(int nb_threads)
+{
+    return NULL;
+}
+
+void av_thread_pool_free(AVThreadPool **pool)
+{
+}
+
+#endif /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS */
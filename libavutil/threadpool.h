@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+/**
+ * @file
+ * A pool of worker threads that can be shared between several contexts,
+ * e.g. the slice threads of all codec contexts of a process.
+ */
+
+typedef struct AVThreadPool AVThreadPool;
+
+/**
+ * Allocate a thread pool and start its worker threads.
+ *
+ * @param nb_threads number of worker threads, 0 for one per CPU
+ * @return the thread pool or NULL on failure
+ */
+AVThreadPool *av_thread_pool_alloc(int nb_threads);
+
+/**
+ * Stop the worker threads and free the thread pool.
+ * The pool must not be used by any context any more.
+ *
+ * @param pool pointer to the pool, set to NULL
+ */
+void av_thread_pool_free(AVThreadPool **pool);
+
+#endif /* AVUTIL_THREADPOOL_H */
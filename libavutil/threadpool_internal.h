@@ -0,0 +1,42 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_INTERNAL_H
+#define AVUTIL_THREADPOOL_INTERNAL_H
+
+#include "threadpool.h"
+
+/**
+ * Run func(opaque) on the calling thread and on up to nb_helpers threads
+ * of the pool in parallel.
+ *
+ * The helpers start as soon as pool threads become available; those which
+ * have not started by the time the call on the calling thread returns are
+ * cancelled. func must thus be written so that the calling thread alone
+ * completes all the work, with the helpers only speeding it up.
+ * Returns once no helper is running func any more.
+ */
+void ff_thread_pool_run(AVThreadPool *pool, void (*func)(void *opaque),
+                        void *opaque, int nb_helpers);
+
+/**
+ * @return the number of worker threads of the pool
+ */
+int ff_thread_pool_nb_threads(const AVThreadPool *pool);
+
+#endif /* AVUTIL_THREADPOOL_INTERNAL_H */
@@ -0,0 +1,291 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * draw_horiz_band test with slice threads.
+ *
+ * With slice threads the bands of a picture may arrive out of order and from
+ * several threads at once. Check that every row of every output picture is
+ * passed exactly once, and that its contents are final when it is passed.
+ * Pictures are told apart by their data pointers, so pictures which are
+ * decoded in parallel or output in a different order are handled as well.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/thread.h" // not public
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+
+#define MAX_PICTURES 32
+
+typedef struct Picture {
+    const uint8_t *data;           ///< data[0] of the decoded picture
+    uint8_t *rows[3];              ///< copies of the rows passed for each plane
+    int     *count;                ///< number of times each luma row was passed
+} Picture;
+
+static Picture pictures[MAX_PICTURES];
+static AVMutex mutex = AV_MUTEX_INITIALIZER;
+/* rows are checked up to height, bands may reach up to coded_height */
+static int width, height, coded_height, chroma_w, chroma_h, log2_chroma_h;
+static int error;
+
+static Picture *find_picture(const uint8_t *data, int add)
+{
+    for (int i = 0; i < MAX_PICTURES; i++)
+        if (pictures[i].data == data)
+            return &pictures[i];
+    if (!add)
+        return NULL;
+    for (int i = 0; i < MAX_PICTURES; i++) {
+        if (!pictures[i].data) {
+            pictures[i].data = data;
+            memset(pictures[i].count, 0, coded_height * sizeof(*pictures[i].count));
+            return &pictures[i];
+        }
+    }
+    return NULL;
+}
+
+static void draw_horiz_band(AVCodecContext *ctx, const AVFrame *fr, int offset[4],
+                            int y, int type, int h)
+{
+    const int cy = y >> log2_chroma_h;
+    const int ch = AV_CEIL_RSHIFT(FFMIN(y + h, height), log2_chroma_h) - cy;
+    Picture *pic;
+
+    ff_mutex_lock(&mutex);
+
+    pic = find_picture(fr->data[0], 1);
+    if (!pic || y < 0 || h <= 0 || y + h > coded_height) {
+        fprintf(stderr, "invalid band %d+%d\n", y, h);
+        error = 1;
+        goto end;
+    }
+
+    for (int i = 0; i < h; i++)
+        pic->count[y + i]++;
+    for (int i = 0; i < FFMIN(h, height - y); i++)
+        memcpy(pic->rows[0] + (y + i) * width,
+               fr->data[0] + offset[0] + i * fr->linesize[0], width);
+    for (int p = 1; p < 3; p++)
+        for (int i = 0; i < ch; i++)
+            memcpy(pic->rows[p] + (cy + i) * chroma_w,
+                   fr->data[p] + offset[p] + i * fr->linesize[p], chroma_w);
+
+end:
+    ff_mutex_unlock(&mutex);
+}
+
+static int check_frame(const AVFrame *fr, int64_t n)
+{
+    Picture *pic = find_picture(fr->data[0], 0);
+    int ret = 0;
+
+    if (!pic) {
+        fprintf(stderr, "frame %"PRId64": draw_horiz_band was not called\n", n);
+        return -1;
+    }
+
+    for (int y = 0; y < coded_height; y++) {
+        if (pic->count[y] != 1 && (y < height || pic->count[y] > 1)) {
+            fprintf(stderr, "frame %"PRId64": row %d passed %d times\n",
+                    n, y, pic->count[y]);
+            ret = -1;
+        }
+    }
+    for (int y = 0; y < height && !ret; y++)
+        if (memcmp(pic->rows[0] + y * width,
+                   fr->data[0] + y * fr->linesize[0], width))
+            ret = -1;
+    for (int p = 1; p < 3 && !ret; p++)
+        for (int y = 0; y < chroma_h && !ret; y++)
+            if (memcmp(pic->rows[p] + y * chroma_w,
+                       fr->data[p] + y * fr->linesize[p], chroma_w))
+                ret = -1;
+    if (ret < 0 && !error)
+        fprintf(stderr, "frame %"PRId64": band contents differ from the output\n", n);
+
+    pic->data = NULL;
+    return ret;
+}
+
+static int video_decode(const char *input_filename, int threads)
+{
+    const AVCodec *codec;
+    AVCodecContext *ctx = NULL;
+    AVFormatContext *fmt_ctx = NULL;
+    const AVPixFmtDescriptor *desc;
+    AVFrame *fr = NULL;
+    AVPacket *pkt = NULL;
+    int64_t nb_frames = 0;
+    int video_stream, result;
+
+    result = avformat_open_input(&fmt_ctx, input_filename, NULL, NULL);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't open file\n");
+        return result;
+    }
+
+    result = avformat_find_stream_info(fmt_ctx, NULL);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't get stream info\n");
+        goto end;
+    }
+
+    video_stream = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (video_stream < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't find video stream in input file\n");
+        result = video_stream;
+        goto end;
+    }
+
+    if (!(codec->capabilities & AV_CODEC_CAP_DRAW_HORIZ_BAND)) {
+        av_log(NULL, AV_LOG_ERROR, "Codec does not support draw_horiz_band\n");
+        result = AVERROR(ENOSYS);
+        goto end;
+    }
+
+    ctx = avcodec_alloc_context3(codec);
+    if (!ctx) {
+        result = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    result = avcodec_parameters_to_context(ctx, fmt_ctx->streams[video_stream]->codecpar);
+    if (result < 0)
+        goto end;
+
+    ctx->draw_horiz_band = draw_horiz_band;
+    ctx->thread_count    = threads;
+    ctx->thread_type     = FF_THREAD_SLICE;
+    // the bands are relative to the uncropped picture
+    ctx->apply_cropping  = 0;
+
+    result = avcodec_open2(ctx, codec, NULL);
+    if (result < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Can't open decoder\n");
+        goto end;
+    }
+
+    desc = av_pix_fmt_desc_get(ctx->pix_fmt);
+    if (!desc || desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM) ||
+        desc->nb_components < 3) {
+        av_log(ctx, AV_LOG_ERROR, "Unsupported pixel format\n");
+        result = AVERROR(ENOSYS);
+        goto end;
+    }
+    width         = ctx->width  * ((desc->comp[0].depth + 7) >> 3);
+    height        = ctx->height;
+    coded_height  = FFMAX(ctx->coded_height, ctx->height);
+    chroma_w      = AV_CEIL_RSHIFT(ctx->width, desc->log2_chroma_w) * ((desc->comp[1].depth + 7) >> 3);
+    chroma_h      = AV_CEIL_RSHIFT(ctx->height, desc->log2_chroma_h);
+    log2_chroma_h = desc->log2_chroma_h;
+
+    for (int i = 0; i < MAX_PICTURES; i++) {
+        Picture *pic = &pictures[i];
+
+        pic->count   = av_malloc_array(coded_height, sizeof(*pic->count));
+        pic->rows[0] = av_malloc(width * height);
+        pic->rows[1] = av_malloc(chroma_w * chroma_h);
+        pic->rows[2] = av_malloc(chroma_w * chroma_h);
+        if (!pic->count || !pic->rows[0] || !pic->rows[1] || !pic->rows[2]) {
+            result = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+
+    fr  = av_frame_alloc();
+    pkt = av_packet_alloc();
+    if (!fr || !pkt) {
+        result = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    result = 0;
+    while (result >= 0) {
+        result = av_read_frame(fmt_ctx, pkt);
+        if (result >= 0 && pkt->stream_index != video_stream) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        // pkt will be empty on read error/EOF
+        result = avcodec_send_packet(ctx, pkt);
+        av_packet_unref(pkt);
+        if (result < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Error submitting a packet for decoding\n");
+            goto end;
+        }
+
+        while (result >= 0) {
+            result = avcodec_receive_frame(ctx, fr);
+            if (result == AVERROR_EOF) {
+                result = 0;
+                goto end;
+            } else if (result == AVERROR(EAGAIN)) {
+                result = 0;
+                break;
+            } else if (result < 0) {
+                av_log(NULL, AV_LOG_ERROR, "Error decoding frame\n");
+                goto end;
+            }
+
+            if (fr->width != ctx->width || fr->height < height) {
+                av_log(NULL, AV_LOG_ERROR, "Frame size changed\n");
+                result = AVERROR(ENOSYS);
+                goto end;
+            }
+            if (check_frame(fr, nb_frames++) < 0 || error)
+                result = AVERROR_BUG;
+            av_frame_unref(fr);
+        }
+    }
+
+end:
+    if (result >= 0 && !nb_frames) {
+        av_log(NULL, AV_LOG_ERROR, "No frames decoded\n");
+        result = AVERROR_INVALIDDATA;
+    }
+    for (int i = 0; i < MAX_PICTURES; i++) {
+        av_freep(&pictures[i].count);
+        for (int p = 0; p < 3; p++)
+            av_freep(&pictures[i].rows[p]);
+    }
+    av_packet_free(&pkt);
+    av_frame_free(&fr);
+    avformat_close_input(&fmt_ctx);
+    avcodec_free_context(&ctx);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <threads> <input file>\n", argv[0]);
+        return 1;
+    }
+
+    return video_decode(argv[2], atoi(argv[1])) < 0;
+}
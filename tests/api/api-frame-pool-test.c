@@ -0,0 +1,223 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Frame pool options test.
+ *
+ * Encodes PNG images alternating between two sizes and decodes them with the
+ * default buffer allocator, configured through the frame_pool_reuse and
+ * frame_pool_max_bytes options. The frame_pool_hits and frame_pool_misses
+ * statistics must show that the buffers are reused across the size changes
+ * only with frame_pool_reuse, and decoding must fail once a frame would
+ * exceed frame_pool_max_bytes.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/macros.h"
+#include "libavutil/opt.h"
+
+#define NB_FRAMES 8
+
+static const int sizes[2][2] = { { 64, 48 }, { 128, 96 } };
+
+static uint8_t pixel(int i, int x, int y, int c)
+{
+    return (x * 3 + y * 5 + c * 7 + i * 11) & 0xff;
+}
+
+static int encode_frame(AVPacket *pkt, int i)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_PNG);
+    const int w = sizes[i & 1][0], h = sizes[i & 1][1];
+    AVCodecContext *ctx = NULL;
+    AVFrame *frame = NULL;
+    int ret;
+
+    if (!codec)
+        return AVERROR_ENCODER_NOT_FOUND;
+
+    ctx   = avcodec_alloc_context3(codec);
+    frame = av_frame_alloc();
+    if (!ctx || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ctx->width     = w;
+    ctx->height    = h;
+    ctx->pix_fmt   = AV_PIX_FMT_RGB24;
+    ctx->time_base = (AVRational){ 1, 25 };
+    ret = avcodec_open2(ctx, codec, NULL);
+    if (ret < 0)
+        goto end;
+
+    frame->width  = w;
+    frame->height = h;
+    frame->format = AV_PIX_FMT_RGB24;
+    ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0)
+        goto end;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            for (int c = 0; c < 3; c++)
+                frame->data[0][y * frame->linesize[0] + x * 3 + c] = pixel(i, x, y, c);
+
+    ret = avcodec_send_frame(ctx, frame);
+    if (ret >= 0)
+        ret = avcodec_receive_packet(ctx, pkt);
+
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    return ret;
+}
+
+static int check_frame(const AVFrame *frame, int i)
+{
+    const int w = sizes[i & 1][0], h = sizes[i & 1][1];
+
+    if (frame->width != w || frame->height != h ||
+        frame->format != AV_PIX_FMT_RGB24)
+        return AVERROR_BUG;
+
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            for (int c = 0; c < 3; c++)
+                if (frame->data[0][y * frame->linesize[0] + x * 3 + c] != pixel(i, x, y, c))
+                    return AVERROR_BUG;
+    return 0;
+}
+
+/**
+ * Decode the packets and return the number of frames decoded before the
+ * first error, with the error in *err.
+ */
+static int decode_packets(AVPacket **pkts, int reuse, int64_t max_bytes,
+                          int64_t *hits, int64_t *misses, int *err)
+{
+    const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_PNG);
+    AVCodecContext *ctx = NULL;
+    AVFrame *frame = NULL;
+    int nb_frames = 0, ret;
+
+    if (!codec) {
+        ret = AVERROR_DECODER_NOT_FOUND;
+        goto end;
+    }
+
+    ctx   = avcodec_alloc_context3(codec);
+    frame = av_frame_alloc();
+    if (!ctx || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ctx->thread_count = 1;
+    if ((ret = av_opt_set_int(ctx, "frame_pool_reuse",     reuse,     0)) < 0 ||
+        (ret = av_opt_set_int(ctx, "frame_pool_max_bytes", max_bytes, 0)) < 0)
+        goto end;
+
+    ret = avcodec_open2(ctx, codec, NULL);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i < NB_FRAMES; i++) {
+        ret = avcodec_send_packet(ctx, pkts[i]);
+        if (ret >= 0)
+            ret = avcodec_receive_frame(ctx, frame);
+        if (ret < 0)
+            break;
+
+        ret = check_frame(frame, i);
+        av_frame_unref(frame);
+        if (ret < 0) {
+            fprintf(stderr, "frame %d differs from the encoded image\n", i);
+            break;
+        }
+        nb_frames++;
+    }
+
+    if ((ret >= 0 || ret == AVERROR(ENOMEM)) &&
+        (av_opt_get_int(ctx, "frame_pool_hits",   0, hits)   < 0 ||
+         av_opt_get_int(ctx, "frame_pool_misses", 0, misses) < 0))
+        ret = AVERROR_BUG;
+
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    *err = ret;
+    return nb_frames;
+}
+
+int main(void)
+{
+    AVPacket *pkts[NB_FRAMES] = { NULL };
+    int64_t hits[2], misses[2], budget_hits, budget_misses;
+    int nb_frames, err, ret = 1;
+
+    for (int i = 0; i < NB_FRAMES; i++) {
+        pkts[i] = av_packet_alloc();
+        if (!pkts[i] || encode_frame(pkts[i], i) < 0) {
+            fprintf(stderr, "Failed to encode frame %d\n", i);
+            goto end;
+        }
+    }
+
+    for (int reuse = 0; reuse < 2; reuse++) {
+        nb_frames = decode_packets(pkts, reuse, 0, &hits[reuse], &misses[reuse], &err);
+        if (err < 0 || nb_frames != NB_FRAMES) {
+            fprintf(stderr, "frame_pool_reuse %d: decoding failed after %d frames: %s\n",
+                    reuse, nb_frames, av_err2str(err));
+            goto end;
+        }
+        /* one plane per frame, each taken from a pool */
+        if (hits[reuse] + misses[reuse] != NB_FRAMES) {
+            fprintf(stderr, "frame_pool_reuse %d: %"PRId64" hits + %"PRId64" misses "
+                    "for %d frames\n", reuse, hits[reuse], misses[reuse], NB_FRAMES);
+            goto end;
+        }
+    }
+
+    /* without reuse every size change starts a new pool, with it only the
+     * first frame of each size allocates */
+    if (misses[0] != NB_FRAMES || misses[1] != FF_ARRAY_ELEMS(sizes)) {
+        fprintf(stderr, "unexpected misses: %"PRId64" without reuse, "
+                "%"PRId64" with reuse\n", misses[0], misses[1]);
+        goto end;
+    }
+
+    /* room for a buffer of the small size but not of the large one */
+    nb_frames = decode_packets(pkts, 1, 2 * sizes[0][0] * sizes[0][1] * 3,
+                               &budget_hits, &budget_misses, &err);
+    if (nb_frames != 1 || err != AVERROR(ENOMEM)) {
+        fprintf(stderr, "frame_pool_max_bytes: %d frames decoded, error %s\n",
+                nb_frames, av_err2str(err));
+        goto end;
+    }
+
+    ret = 0;
+end:
+    for (int i = 0; i < NB_FRAMES; i++)
+        av_packet_free(&pkts[i]);
+    return ret;
+}
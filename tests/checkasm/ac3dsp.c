@@ -25,7 +25,9 @@
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
 
+#include "libavcodec/ac3defs.h"
 #include "libavcodec/ac3dsp.h"
+#include "libavcodec/ac3tab.h"
 
 #include "checkasm.h"
 
@@ -190,6 +192,103 @@ static void check_ac3_sum_square_butterfly_float(AC3DSPContext *c) {
     report("ac3_sum_square_butterfly_float");
 }
 
+static void check_ac3_bit_alloc_calc_bap(AC3DSPContext *c) {
+    LOCAL_ALIGNED_16(int16_t, mask, [AC3_CRITICAL_BANDS]);
+    LOCAL_ALIGNED_16(int16_t, psd, [AC3_MAX_COEFS]);
+    LOCAL_ALIGNED_16(uint8_t, bap0, [AC3_MAX_COEFS]);
+    LOCAL_ALIGNED_16(uint8_t, bap1, [AC3_MAX_COEFS]);
+    /* -960 is special cased to zero all of the bap */
+    static const int snr_offsets[] = { -960, -512, 0, 240, 1000 };
+    int i;
+
+    declare_func(void, int16_t *, int16_t *, int, int, int, int,
+                 const uint8_t *, uint8_t *);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(snr_offsets); i++) {
+        if (check_func(c->bit_alloc_calc_bap, "ac3_bit_alloc_calc_bap_snr%d",
+                       snr_offsets[i])) {
+            int floor = ff_ac3_floor_tab[rnd() % 7];
+            int start = rnd() % 64;
+            int end   = start + 1 + rnd() % (AC3_MAX_COEFS - 3 - start);
+            int j;
+
+            /* same range as the psd computed from exponents */
+            for (j = 0; j < AC3_MAX_COEFS; j++)
+                psd[j] = 3072 - ((rnd() % 25) << 7);
+            for (j = 0; j < AC3_CRITICAL_BANDS; j++)
+                mask[j] = rnd() % 3072;
+            memset(bap0, 0xff, AC3_MAX_COEFS);
+            memset(bap1, 0xff, AC3_MAX_COEFS);
+
+            call_ref(mask, psd, start, end, snr_offsets[i], floor,
+                     ff_ac3_bap_tab, bap0);
+            call_new(mask, psd, start, end, snr_offsets[i], floor,
+                     ff_ac3_bap_tab, bap1);
+
+            if (memcmp(bap0, bap1, AC3_MAX_COEFS) != 0)
+                fail();
+
+            bench_new(mask, psd, 0, AC3_MAX_COEFS - 3, snr_offsets[i], floor,
+                      ff_ac3_bap_tab, bap1);
+        }
+    }
+
+    report("ac3_bit_alloc_calc_bap");
+}
+
+static void check_ac3_update_bap_counts(AC3DSPContext *c) {
+    LOCAL_ALIGNED_16(uint8_t, bap, [AC3_MAX_COEFS]);
+    LOCAL_ALIGNED_16(uint16_t, cnt0, [16]);
+    LOCAL_ALIGNED_16(uint16_t, cnt1, [16]);
+    int i;
+
+    declare_func(void, uint16_t *, uint8_t *, int);
+
+    if (check_func(c->update_bap_counts, "ac3_update_bap_counts")) {
+        for (i = 0; i < AC3_MAX_COEFS; i++)
+            bap[i] = rnd() % 16;
+
+        for (i = 0; i < 16; i++)
+            cnt0[i] = cnt1[i] = rnd() % 1024;
+
+        call_ref(cnt0, bap, AC3_MAX_COEFS);
+        call_new(cnt1, bap, AC3_MAX_COEFS);
+
+        if (memcmp(cnt0, cnt1, 16 * sizeof(*cnt0)) != 0)
+            fail();
+
+        bench_new(cnt1, bap, AC3_MAX_COEFS);
+    }
+
+    report("ac3_update_bap_counts");
+}
+
+static void check_ac3_compute_mantissa_size(AC3DSPContext *c) {
+    LOCAL_ALIGNED_16(uint16_t, mant_cnt, [AC3_MAX_BLOCKS], [16]);
+    int blk, bap;
+
+    declare_func(int, uint16_t [6][16]);
+
+    if (check_func(c->compute_mantissa_size, "ac3_compute_mantissa_size")) {
+        int bits0, bits1;
+
+        /* counts of up to 6 channels of 256 mantissas for each block */
+        for (blk = 0; blk < AC3_MAX_BLOCKS; blk++)
+            for (bap = 0; bap < 16; bap++)
+                mant_cnt[blk][bap] = rnd() % 1024;
+
+        bits0 = call_ref(mant_cnt);
+        bits1 = call_new(mant_cnt);
+
+        if (bits0 != bits1)
+            fail();
+
+        bench_new(mant_cnt);
+    }
+
+    report("ac3_compute_mantissa_size");
+}
+
 void checkasm_check_ac3dsp(void)
 {
     AC3DSPContext c;
@@ -200,4 +299,7 @@ void checkasm_check_ac3dsp(void)
     check_float_to_fixed24(&c);
     check_ac3_sum_square_butterfly_int32(&c);
     check_ac3_sum_square_butterfly_float(&c);
+    check_ac3_bit_alloc_calc_bap(&c);
+    check_ac3_update_bap_counts(&c);
+    check_ac3_compute_mantissa_size(&c);
 }
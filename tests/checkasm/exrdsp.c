@@ -24,11 +24,15 @@
 #include "libavcodec/defs.h"
 #include "libavcodec/exrdsp.h"
 #include "libavutil/intreadwrite.h"
+#include "libavutil/macros.h"
 #include "libavutil/mem_internal.h"
 
 #define BUF_SIZE 5120
 #define PADDED_BUF_SIZE BUF_SIZE+AV_INPUT_BUFFER_PADDING_SIZE*2
 
+/* besides whole vectors, the DWA DC planes come in any even size */
+static const int sizes[] = { BUF_SIZE, 2, 6, 30, 66, 3 * 2 * 7 * 5 };
+
 #define randomize_buffers()                 \
     do {                                    \
         int i;                              \
@@ -46,13 +50,15 @@ static void check_reorder_pixels(void) {
     declare_func(void, uint8_t *dst, const uint8_t *src, ptrdiff_t size);
 
     memset(src,     0, PADDED_BUF_SIZE);
-    memset(dst_ref, 0, PADDED_BUF_SIZE);
-    memset(dst_new, 0, PADDED_BUF_SIZE);
     randomize_buffers();
-    call_ref(dst_ref, src, BUF_SIZE);
-    call_new(dst_new, src, BUF_SIZE);
-    if (memcmp(dst_ref, dst_new, BUF_SIZE))
-        fail();
+    for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        memset(dst_ref, 0, PADDED_BUF_SIZE);
+        memset(dst_new, 0, PADDED_BUF_SIZE);
+        call_ref(dst_ref, src, sizes[i]);
+        call_new(dst_new, src, sizes[i]);
+        if (memcmp(dst_ref, dst_new, sizes[i]))
+            fail();
+    }
     bench_new(dst_new, src, BUF_SIZE);
 }
 
@@ -65,12 +71,14 @@ static void check_predictor(void) {
 
     memset(src,     0, PADDED_BUF_SIZE);
     randomize_buffers();
-    memcpy(dst_ref, src, PADDED_BUF_SIZE);
-    memcpy(dst_new, src, PADDED_BUF_SIZE);
-    call_ref(dst_ref, BUF_SIZE);
-    call_new(dst_new, BUF_SIZE);
-    if (memcmp(dst_ref, dst_new, BUF_SIZE))
-        fail();
+    for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        memcpy(dst_ref, src, PADDED_BUF_SIZE);
+        memcpy(dst_new, src, PADDED_BUF_SIZE);
+        call_ref(dst_ref, sizes[i]);
+        call_new(dst_new, sizes[i]);
+        if (memcmp(dst_ref, dst_new, sizes[i]))
+            fail();
+    }
     bench_new(dst_new, BUF_SIZE);
 }
 
@@ -0,0 +1,94 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/opus/pvq.h"
+
+#include "checkasm.h"
+
+#define MAX_N 256
+
+#define randomize_float(buf, len)                               \
+    do {                                                        \
+        for (int i = 0; i < len; i++) {                         \
+            float f = (float)rnd() / (UINT_MAX >> 1) - 1.0f;    \
+            buf[i] = f;                                         \
+        }                                                       \
+    } while (0)
+
+/* The SIMD versions may use an approximate search and place the pulses
+ * differently from the C version, so only the properties any valid
+ * result has are checked: exactly K pulses, signs following the input
+ * and a return value equal to the energy of the quantized vector. */
+static int check_result(const float *X, const int *y, float ret, int K, int N)
+{
+    int pulses = 0, energy = 0;
+
+    for (int i = 0; i < N; i++) {
+        pulses += abs(y[i]);
+        energy += y[i] * y[i];
+        if ((y[i] > 0 && X[i] < 0.0f) || (y[i] < 0 && X[i] > 0.0f))
+            return 0;
+    }
+
+    return pulses == K && ret == (float)energy;
+}
+
+static void test_pvq_search(CeltPVQ *pvq)
+{
+    static const int sizes[] = { 2, 3, 4, 8, 11, 16, 22, 36, 64, 88, 176 };
+    LOCAL_ALIGNED_32(float, X, [MAX_N + 8]);
+    LOCAL_ALIGNED_32(int, y0, [MAX_N]);
+    LOCAL_ALIGNED_32(int, y1, [MAX_N]);
+
+    declare_func_float(float, float *X, int *y, int K, int N);
+
+    if (check_func(pvq->pvq_search, "pvq_search")) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+            const int N = sizes[i];
+            const int K = 1 + rnd() % 128;
+            float ret0, ret1;
+
+            randomize_float(X, MAX_N + 8);
+
+            ret0 = call_ref(X, y0, K, N);
+            ret1 = call_new(X, y1, K, N);
+
+            if (!check_result(X, y0, ret0, K, N) ||
+                !check_result(X, y1, ret1, K, N))
+                fail();
+        }
+        bench_new(X, y1, 32, 176);
+    }
+}
+
+void checkasm_check_opus_pvq(void)
+{
+    CeltPVQ *pvq;
+
+    if (ff_celt_pvq_init(&pvq, 1) < 0)
+        return;
+
+    test_pvq_search(pvq);
+    report("pvq_search");
+
+    ff_celt_pvq_uninit(&pvq);
+}
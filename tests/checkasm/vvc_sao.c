@@ -0,0 +1,106 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/vvc/ctu.h"
+#include "libavcodec/vvc/dsp.h"
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+static const uint32_t pixel_mask[3] = { 0xffffffff, 0x03ff03ff, 0x0fff0fff };
+
+/* the widest block of each band_filter[] entry, see sao_tab in vvc/filter.c */
+static const int sao_size[9] = { 8, 16, 32, 48, 64, 80, 96, 112, 128 };
+
+#define SIZEOF_PIXEL ((bit_depth + 7) / 8)
+/* the band filter runs in place on the frame, so any stride will do; keep
+ * the rows of the widest CTB apart by something that is not a power of two */
+#define PIXEL_STRIDE (MAX_CTU_SIZE + 24)
+#define BUF_SIZE (PIXEL_STRIDE * MAX_CTU_SIZE * 2) //*2 for high bit depth
+
+#define randomize_buffers(buf0, buf1, size)                 \
+    do {                                                    \
+        uint32_t mask = pixel_mask[(bit_depth - 8) >> 1];   \
+        int k;                                              \
+        for (k = 0; k < size; k += 4) {                     \
+            uint32_t r = rnd() & mask;                      \
+            AV_WN32A(buf0 + k, r);                          \
+            AV_WN32A(buf1 + k, r);                          \
+        }                                                   \
+    } while (0)
+
+/* SaoOffsetVal[0] is always 0, the four band offsets are signed and scaled
+ * to the bit depth, as in hls_sao() */
+static void randomize_offsets(int16_t *offset_val, int bit_depth)
+{
+    const int log2_offset_scale = FFMAX(bit_depth - 10, 0);
+    const int max               = (1 << (FFMIN(bit_depth, 10) - 5)) - 1;
+
+    offset_val[0] = 0;
+    for (int i = 1; i < 5; i++)
+        offset_val[i] = ((int)(rnd() % (2 * max + 1)) - max) * (1 << log2_offset_scale);
+}
+
+static void check_sao_band(VVCDSPContext *c, int bit_depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, buf1, [BUF_SIZE]);
+    int16_t offset_val[5];
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(sao_size); i++) {
+        const int block_size   = sao_size[i];
+        const int prev_size    = i > 0 ? sao_size[i - 1] : 0;
+        const ptrdiff_t stride = PIXEL_STRIDE * SIZEOF_PIXEL;
+        declare_func(void, uint8_t *dst, const uint8_t *src, ptrdiff_t dst_stride, ptrdiff_t src_stride,
+                     const int16_t *sao_offset_val, int sao_left_class, int width, int height);
+
+        if (check_func(c->sao.band_filter[i], "vvc_sao_band_%d_%d", block_size, bit_depth)) {
+            for (int w = prev_size + 4; w <= block_size; w += 4) {
+                /* partial CTBs at the bottom of the picture */
+                const int h          = (rnd() & 1) ? block_size : 4 + 4 * (rnd() % (block_size / 4));
+                const int left_class = rnd() % 32;
+
+                randomize_buffers(buf0, buf1, BUF_SIZE);
+                randomize_offsets(offset_val, bit_depth);
+
+                /* in place, the way ff_vvc_sao_filter() calls it */
+                call_ref(buf0, buf0, stride, stride, offset_val, left_class, w, h);
+                call_new(buf1, buf1, stride, stride, offset_val, left_class, w, h);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+            }
+            bench_new(buf1, buf1, stride, stride, offset_val, 0, block_size, block_size);
+        }
+    }
+}
+
+void checkasm_check_vvc_sao(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        VVCDSPContext h;
+
+        ff_vvc_dsp_init(&h, bit_depth);
+        check_sao_band(&h, bit_depth);
+    }
+    report("sao_band");
+}
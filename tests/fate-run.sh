@@ -173,6 +173,24 @@ md5pipe(){
     ffmpeg "$@" md5:
 }
 
+# Encode with one and with two (or $threads, if more) slice threads, the
+# outputs must match.
+slice_threads_md5(){
+    nb_threads=2
+    test "$threads" -gt 2 2>/dev/null && nb_threads=$threads
+    md5_1=$(md5pipe "$@" -thread_type slice -threads 1) || return
+    md5_2=$(md5pipe "$@" -thread_type slice -threads $nb_threads) || return
+    test "$md5_1" = "$md5_2" && echo identical || echo "$md5_1 != $md5_2"
+}
+
+# Remux with and without -fflags +fastparse, the packets, i.e. their
+# boundaries, timestamps, flags and contents, must match.
+fastparse_framemd5(){
+    md5_1=$(ffmpeg "$@" -c copy -bitexact -f framemd5 md5:) || return
+    md5_2=$(ffmpeg -fflags +fastparse "$@" -c copy -bitexact -f framemd5 md5:) || return
+    test "$md5_1" = "$md5_2" && echo identical || echo "$md5_1 != $md5_2"
+}
+
 md5(){
     encfile="${outdir}/${test}.out"
     cleanfiles="$cleanfiles $encfile"
@@ -263,9 +263,19 @@ $(FATE_AAC_ALL): FUZZ = 2
 
 FATE_AAC_ENCODE-$(call ENCMUX, AAC, ADTS, ARESAMPLE_FILTER) += $(FATE_AAC_ENCODE)
 
+# 5.1 has three channel elements (SCE, CPE, CPE) plus the LFE, searched in
+# parallel with slice threads; the output must not depend on the thread count
+FATE_AAC_ENC_THREADS-$(call ENCMUX, AAC, ADTS, ARESAMPLE_FILTER WAV_DEMUXER PCM_S16LE_DECODER) += fate-aac-enc-slice-threads
+fate-aac-enc-slice-threads: tests/data/asynth-44100-6.wav
+fate-aac-enc-slice-threads: CMD = slice_threads_md5 -i $(TARGET_PATH)/tests/data/asynth-44100-6.wav -af aresample=osf=fltp -c:a aac -aac_pns 1 -aac_tns 1 -b:a 384k -fflags +bitexact -flags +bitexact -f adts
+fate-aac-enc-slice-threads: CMP = oneline
+fate-aac-enc-slice-threads: REF = identical
+
+FATE_FFMPEG += $(FATE_AAC_ENC_THREADS-yes)
+
 FATE_AAC_BSF-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER) += fate-aac-autobsf-adtstoasc
 
 FATE_SAMPLES_FFMPEG += $(FATE_AAC_ALL) $(FATE_AAC_ENCODE-yes) $(FATE_AAC_BSF-yes)
 
-fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes)
+fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes) $(FATE_AAC_ENC_THREADS-yes)
 fate-aac-latm: $(FATE_AAC_LATM-yes)
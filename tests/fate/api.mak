@@ -3,11 +3,29 @@ fate-api-flac: $(APITESTSDIR)/api-flac-test$(EXESUF)
 fate-api-flac: CMD = run $(APITESTSDIR)/api-flac-test$(EXESUF)
 fate-api-flac: CMP = null
 
+FATE_API_LIBAVCODEC-$(call ALLYES, PNG_ENCODER PNG_DECODER) += fate-api-frame-pool
+fate-api-frame-pool: $(APITESTSDIR)/api-frame-pool-test$(EXESUF)
+fate-api-frame-pool: CMD = run $(APITESTSDIR)/api-frame-pool-test$(EXESUF)
+fate-api-frame-pool: CMP = null
+
 FATE_API_SAMPLES_LIBAVFORMAT-$(call DEMDEC, FLV, FLV) += fate-api-band
 fate-api-band: $(APITESTSDIR)/api-band-test$(EXESUF)
 fate-api-band: CMD = run $(APITESTSDIR)/api-band-test$(EXESUF) $(TARGET_SAMPLES)/mpeg4/resize_down-up.h263
 fate-api-band: CMP = null
 
+# every row exactly once and final, with postponed deblocking and with WPP
+FATE_API_BAND_THREADS-$(call DEMDEC, H264, H264) += fate-api-band-threads-h264
+fate-api-band-threads-h264: $(APITESTSDIR)/api-band-threads-test$(EXESUF)
+fate-api-band-threads-h264: CMD = run $(APITESTSDIR)/api-band-threads-test$(EXESUF) 4 $(TARGET_SAMPLES)/h264-conformance/BA1_FT_C.264
+fate-api-band-threads-h264: CMP = null
+
+FATE_API_BAND_THREADS-$(call DEMDEC, HEVC, HEVC) += fate-api-band-threads-hevc
+fate-api-band-threads-hevc: $(APITESTSDIR)/api-band-threads-test$(EXESUF)
+fate-api-band-threads-hevc: CMD = run $(APITESTSDIR)/api-band-threads-test$(EXESUF) 4 $(TARGET_SAMPLES)/hevc-conformance/WPP_B_ericsson_MAIN_2.bit
+fate-api-band-threads-hevc: CMP = null
+
+FATE_API_SAMPLES_LIBAVFORMAT-$(HAVE_THREADS) += $(FATE_API_BAND_THREADS-yes)
+
 FATE_API_SAMPLES_LIBAVFORMAT-$(call DEMDEC, H264, H264) += fate-api-h264
 fate-api-h264: $(APITESTSDIR)/api-h264-test$(EXESUF)
 fate-api-h264: CMD = run $(APITESTSDIR)/api-h264-test$(EXESUF) $(TARGET_SAMPLES)/h264-conformance/SVA_NL2_E.264
@@ -242,6 +242,16 @@ FATE_H264-$(call FRAMECRC, MPEGTS, H264, H264_PARSER MP3_DECODER SCALE_FILTER AR
 FATE_H264_FFPROBE-$(call DEMDEC, MATROSKA, H264) += fate-h264-dts_5frames
 FATE_H264_FFPROBE-$(call PARSERDEMDEC, H264, H264, H264) += fate-h264-afd
 
+# -fflags fastparse must not change the packets: MMCO and field pairs,
+# PAFF and MBAFF, and timestamps from a container
+FATE_H264_FASTPARSE-$(call ALLYES, H264_DEMUXER H264_PARSER FRAMEMD5_MUXER MD5_PROTOCOL FILE_PROTOCOL) += \
+    fate-h264-fastparse-mr9_bt_b fate-h264-fastparse-capama3_sand_f
+FATE_H264_FASTPARSE-$(call ALLYES, MPEGTS_DEMUXER H264_PARSER FRAMEMD5_MUXER MD5_PROTOCOL FILE_PROTOCOL) += \
+    fate-h264-fastparse-ts
+FATE_H264-yes += $(FATE_H264_FASTPARSE-yes)
+$(FATE_H264_FASTPARSE-yes): CMP = oneline
+$(FATE_H264_FASTPARSE-yes): REF = identical
+
 FATE_SAMPLES_AVCONV += $(FATE_H264-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_H264_FFPROBE-yes)
 fate-h264: $(FATE_H264-yes) $(FATE_H264_FFPROBE-yes)
@@ -456,6 +466,10 @@ fate-h264-interlace-crop:                         CMD = framecrc -i $(TARGET_SAM
 fate-h264-brokensps-2580:                         CMD = framecrc -i $(TARGET_SAMPLES)/h264/brokensps.flv -vf format=yuv420p,scale=w=192:h=144 -sws_flags bitexact+bilinear
 fate-h264-xavc-4389:                              CMD = framecrc -i $(TARGET_SAMPLES)/h264/SonyXAVC_LongGOP_green_pixelation_early_Frames.MXF -pix_fmt yuv422p10le -vf scale -af aresample
 fate-h264-attachment-631:                         CMD = framecrc -i $(TARGET_SAMPLES)/h264/attachment631-small.mp4 -an -max_error_rate 0.96
+fate-h264-fastparse-mr9_bt_b:                     CMD = fastparse_framemd5 -i $(TARGET_SAMPLES)/h264-conformance/MR9_BT_B.h264
+fate-h264-fastparse-capama3_sand_f:               CMD = fastparse_framemd5 -i $(TARGET_SAMPLES)/h264-conformance/CAPAMA3_Sand_F.264
+fate-h264-fastparse-ts:                           CMD = fastparse_framemd5 -i $(TARGET_SAMPLES)/h264/h264_intra_first-small.ts -map 0:v
+
 fate-h264-skip-nokey:                             CMD = framecrc -skip_frame nokey -i $(TARGET_SAMPLES)/h264/h264_intra_first-small.ts -vf scale -af aresample
 fate-h264-skip-nointra:                           CMD = framecrc -skip_frame nointra -i $(TARGET_SAMPLES)/h264/h264_intra_first-small.ts -vf scale -af aresample
 fate-h264-intra-refresh-recovery:                 CMD = framecrc -i $(TARGET_SAMPLES)/h264/intra_refresh.h264 -frames:v 10
@@ -291,6 +291,27 @@ FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, SCALE_FILTER CONCAT_PROTOCOL) += fate-hev
 fate-hevc-mv-position: CMD = framecrc -i $(TARGET_SAMPLES)/hevc/multiview.mov -map 0:v:vpos:left -map 0:v:vpos:right
 FATE_HEVC-$(call FRAMECRC, MOV, HEVC) += fate-hevc-mv-position
 
+# -fflags fastparse must not change the packets: random access points with
+# leading pictures, all NAL unit types, and timestamps from a container
+FATE_HEVC_FASTPARSE-$(call ALLYES, HEVC_DEMUXER HEVC_PARSER FRAMEMD5_MUXER MD5_PROTOCOL FILE_PROTOCOL) += \
+    fate-hevc-fastparse-rap_b fate-hevc-fastparse-nut_a
+FATE_HEVC_FASTPARSE-$(call ALLYES, MPEGTS_DEMUXER HEVC_PARSER FRAMEMD5_MUXER MD5_PROTOCOL FILE_PROTOCOL) += \
+    fate-hevc-fastparse-ts
+fate-hevc-fastparse-rap_b: CMD = fastparse_framemd5 -i $(TARGET_SAMPLES)/hevc-conformance/RAP_B_Bossen_1.bit
+fate-hevc-fastparse-nut_a: CMD = fastparse_framemd5 -i $(TARGET_SAMPLES)/hevc-conformance/NUT_A_ericsson_5.bit
+fate-hevc-fastparse-ts:    CMD = fastparse_framemd5 -i $(TARGET_SAMPLES)/mpegts/loewe.ts -map 0:v
+$(FATE_HEVC_FASTPARSE-yes): CMP = oneline
+$(FATE_HEVC_FASTPARSE-yes): REF = identical
+FATE_HEVC-yes += $(FATE_HEVC_FASTPARSE-yes)
+
+# WPP rows wait for each other, decoded with more slice threads than the
+# shared pool has
+fate-hevc-wpp-thread-pool: CMD = framecrc -codec_thread_pool 2 -i $(TARGET_SAMPLES)/hevc-conformance/WPP_B_ericsson_MAIN_2.bit -pix_fmt yuv420p
+fate-hevc-wpp-thread-pool: THREADS = 4
+fate-hevc-wpp-thread-pool: THREAD_TYPE = slice
+fate-hevc-wpp-thread-pool: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-WPP_B_ericsson_MAIN_2
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER) += fate-hevc-wpp-thread-pool
+
 FATE_SAMPLES_AVCONV += $(FATE_HEVC-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_HEVC_FFPROBE-yes)
 
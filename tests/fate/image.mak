@@ -326,6 +326,11 @@ fate-exr-rgb-tile-half-zip-dw-outside: CMD = framecrc -i $(TARGET_SAMPLES)/exr/r
 FATE_EXR += fate-exr-rgb-scanline-zip-half-0x0-0xFFFF
 fate-exr-rgb-scanline-zip-half-0x0-0xFFFF: CMD = framecrc -i $(TARGET_SAMPLES)/exr/rgb_scanline_zip_half_float_0x0_to_0xFFFF.exr -vf scale -pix_fmt gbrpf32le
 
+# 8x8 blocks with and without AC coefficients, including positions where
+# all three blocks are flat
+FATE_EXR += fate-exr-rgb-scanline-half-dwaa-flat-ac
+fate-exr-rgb-scanline-half-dwaa-flat-ac: CMD = framecrc -i $(TARGET_SAMPLES)/exr/rgb_scanline_half_dwaa_flat_ac.exr -vf scale -pix_fmt gbrpf32le
+
 FATE_EXR-$(call DEMDEC, IMAGE2, EXR, SCALE_FILTER) += $(FATE_EXR)
 
 FATE_IMAGE_FRAMECRC += $(FATE_EXR-yes)
@@ -539,6 +544,15 @@ fate-tiff-lzw-rgbf32le: CMD = framecrc -i $(TARGET_SAMPLES)/tiff/lzw_rgbf32le.ti
 FATE_TIFF += fate-tiff-lzw-rgbaf32le
 fate-tiff-lzw-rgbaf32le: CMD = framecrc -i $(TARGET_SAMPLES)/tiff/lzw_rgbaf32le.tif
 
+# strips decoded by slice threads, with per thread LZW and fax state
+FATE_TIFF += fate-tiff-lzw-rgbf32le-slice-threads
+fate-tiff-lzw-rgbf32le-slice-threads: CMD = framecrc -thread_type slice -threads 2 -i $(TARGET_SAMPLES)/tiff/lzw_rgbf32le.tif
+fate-tiff-lzw-rgbf32le-slice-threads: REF = $(SRC_PATH)/tests/ref/fate/tiff-lzw-rgbf32le
+
+FATE_TIFF += fate-tiff-fax-g3-slice-threads
+fate-tiff-fax-g3-slice-threads: CMD = framecrc -thread_type slice -threads 2 -i $(TARGET_SAMPLES)/CCITT_fax/G31D.TIF
+fate-tiff-fax-g3-slice-threads: REF = $(SRC_PATH)/tests/ref/fate/tiff-fax-g3
+
 FATE_TIFF_ZIP += fate-tiff-zip-rgbf32le
 fate-tiff-zip-rgbf32le: CMD = framecrc -i $(TARGET_SAMPLES)/tiff/zip_rgbf32le.tif
 
@@ -37,6 +37,7 @@ FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PGM) += pgm
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += png
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += gray16be.png
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += rgb48be.png
+FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += slice.png
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PPM) += ppm
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         SGI) += sgi
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,     SUNRAST) += sun
@@ -72,6 +73,9 @@ fate-lavf-none.gbrapf32le.exr:  CMD = lavf_image "-compression none  -pix_fmt gb
 fate-lavf-rle.gbrapf32le.exr:   CMD = lavf_image "-compression rle   -pix_fmt gbrapf32le" "" "no_file_checksums"
 fate-lavf-zip1.gbrapf32le.exr:  CMD = lavf_image "-compression zip1  -pix_fmt gbrapf32le" "" "no_file_checksums"
 fate-lavf-zip16.gbrapf32le.exr: CMD = lavf_image "-compression zip16 -pix_fmt gbrapf32le" "" "no_file_checksums"
+# The deflate chunks of the slice threaded encoder change the file, but the
+# images must decode to the same CRC as in the lavf-png test.
+fate-lavf-slice.png: CMD = lavf_image "-thread_type slice -threads 2" "" "no_file_checksums"
 fate-lavf-jpg: CMD = lavf_image "-pix_fmt yuvj420p"
 fate-lavf-tiff: CMD = lavf_image "-pix_fmt rgb24"
 fate-lavf-gbrp10le.dpx: CMD = lavf_image "-pix_fmt gbrp10le" "-pix_fmt gbrp10le"
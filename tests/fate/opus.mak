@@ -42,3 +42,12 @@ fate-opus-celt: $(FATE_OPUS_CELT-yes)
 fate-opus-hybrid: $(FATE_OPUS_HYBRID-yes)
 fate-opus-silk: $(FATE_OPUS_SILK-yes)
 fate-opus: $(FATE_OPUS)
+
+FATE_OPUS_ENC-$(call ENCMUX, OPUS, OGG, ARESAMPLE_FILTER) += fate-opus-enc-slice-threads
+fate-opus-enc-slice-threads: tests/data/asynth-44100-2.wav
+fate-opus-enc-slice-threads: CMD = slice_threads_md5 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af aresample=48000:osf=fltp -strict experimental -c:a opus -fflags +bitexact -f ogg
+fate-opus-enc-slice-threads: CMP = oneline
+fate-opus-enc-slice-threads: REF = identical
+
+FATE_FFMPEG += $(FATE_OPUS_ENC-yes)
+fate-opus-enc: $(FATE_OPUS_ENC-yes)
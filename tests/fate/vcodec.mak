@@ -182,6 +182,16 @@ fate-vsynth%-ffv1-2pass10:       TWOPASS = 1
 fate-vsynth%-ffv1-2pass10:       ENCOPTS = -coder range_tab -context 1 -pix_fmt yuv422p10 \
                                            -sws_flags neighbor+bitexact
 
+# without auto_slices, the slice layout must not depend on the thread count;
+# 720p with 8 threads would get more than the default 4 slices otherwise
+FATE_FFV1_ENC-$(call ENCMUX, FFV1, NUT, LAVFI_INDEV TESTSRC2_FILTER) += fate-ffv1-enc-slice-threads
+fate-ffv1-enc-slice-threads: CMD = slice_threads_md5 -f lavfi -i testsrc2=s=1280x720:d=0.2 -c:v ffv1 -fflags +bitexact -f nut
+fate-ffv1-enc-slice-threads: CMP = oneline
+fate-ffv1-enc-slice-threads: REF = identical
+fate-ffv1-enc-slice-threads: THREADS = 8
+
+FATE_FFMPEG += $(FATE_FFV1_ENC-yes)
+
 FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff
 FATE_VCODEC_SCALE-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff444 ffvhuff420p12 ffvhuff422p10left ffvhuff444p16
 fate-vsynth%-ffvhuff444:         ENCOPTS = -c:v ffvhuff -pix_fmt yuv444p
@@ -230,6 +240,24 @@ fate-vsynth%-jpeg2000-97:             ENCOPTS = -qscale 7 -pix_fmt rgb24
 fate-vsynth%-jpeg2000-gbrp12:         ENCOPTS = -qscale 5 -pred 1 -pix_fmt gbrp12
 fate-vsynth%-jpeg2000-yuva444p16:     ENCOPTS = -qscale 8 -pred 1 -pix_fmt yuva444p16
 
+FATE_VCODEC_SCALE-$(call ENCDEC, JPEG2000, AVI) += jpeg2000-ht jpeg2000-ht-97
+fate-vsynth%-jpeg2000-ht:             ENCOPTS = -qscale 7 -pred 1 -ht 1 -pix_fmt rgb24
+fate-vsynth%-jpeg2000-ht-97:          ENCOPTS = -qscale 7 -ht 1 -pix_fmt rgb24
+
+# several tiles, decoded with slice threads; the reference is the single
+# threaded decode, as in jpeg2000-97
+FATE_VCODEC_SCALE-$(call ENCDEC, JPEG2000, AVI) += jpeg2000-97-slice
+fate-vsynth%-jpeg2000-97-slice:       ENCOPTS = -qscale 7 -pix_fmt rgb24
+fate-vsynth%-jpeg2000-97-slice:       THREADS = 2
+fate-vsynth%-jpeg2000-97-slice:       THREAD_TYPE = slice
+
+# the same, with the slice threads on a shared pool smaller than THREADS
+FATE_VCODEC_SCALE-$(call ENCDEC, JPEG2000, AVI) += jpeg2000-97-pool
+fate-vsynth%-jpeg2000-97-pool:        ENCOPTS = -qscale 7 -pix_fmt rgb24
+fate-vsynth%-jpeg2000-97-pool:        DECOPTS = -codec_thread_pool 2
+fate-vsynth%-jpeg2000-97-pool:        THREADS = 4
+fate-vsynth%-jpeg2000-97-pool:        THREAD_TYPE = slice
+
 FATE_VCODEC-$(call ENCDEC, LJPEG MJPEG, AVI) += ljpeg
 fate-vsynth%-ljpeg:              ENCOPTS = -strict -1
 
@@ -288,14 +316,17 @@ fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
 
 FATE_MPEG4_MP4 = mpeg4
 FATE_MPEG4_AVI = mpeg4-rc                                               \
+                 mpeg4-rc-lookahead                                     \
                  mpeg4-adv                                              \
                  mpeg4-qprd                                             \
                  mpeg4-adap                                             \
                  mpeg4-qpel                                             \
                  mpeg4-thread                                           \
                  mpeg4-error                                            \
+                 mpeg4-mepre-coarse                                     \
                  mpeg4-nr                                               \
-                 mpeg4-nsse
+                 mpeg4-nsse                                             \
+                 mpeg4-resync
 
 FATE_VCODEC-$(call ENCDEC, MPEG4, MP4 MOV) += $(FATE_MPEG4_MP4)
 FATE_VCODEC-$(call ENCDEC, MPEG4, AVI)     += $(FATE_MPEG4_AVI)
@@ -316,6 +347,10 @@ fate-vsynth%-mpeg4-error:        ENCOPTS = -qscale 7 -flags +mv4+aic    \
                                            -data_partitioning 1 -mbd rd \
                                            -ps 250 -error_rate 10
 
+# P-frame motion estimation seeded from the half resolution prepass
+fate-vsynth%-mpeg4-mepre-coarse: ENCOPTS = -qscale 10 -flags +mv4 -mbd bits \
+                                           -bf 2 -mepre_coarse 1
+
 fate-vsynth%-mpeg4-nr:           ENCOPTS = -qscale 8 -flags +mv4 -mbd rd \
                                            -noise_reduction 200
 
@@ -332,6 +367,17 @@ fate-vsynth%-mpeg4-qprd:         ENCOPTS = -b 450k -bf 2 -trellis 1          \
 
 fate-vsynth%-mpeg4-rc:           ENCOPTS = -b 400k -bf 2
 
+# 1-pass VBV rate control planning over the next frames
+fate-vsynth%-mpeg4-rc-lookahead: ENCOPTS = -b 400k -maxrate 800k -bufsize 1000k \
+                                           -bf 2 -rc_lookahead 8
+
+# video packets without data partitioning, decoded with slice threads; the
+# reference is the single threaded decode
+fate-vsynth%-mpeg4-resync:       ENCOPTS = -qscale 7 -flags +mv4+aic -mbd bits \
+                                           -ps 200 -bf 2
+fate-vsynth%-mpeg4-resync:       THREADS = 2
+fate-vsynth%-mpeg4-resync:       THREAD_TYPE = slice
+
 fate-vsynth%-mpeg4-thread:       ENCOPTS = -b 500k -flags +mv4+aic         \
                                            -data_partitioning 1 -trellis 1 \
                                            -mbd bits -ps 200 -bf 2         \
@@ -351,7 +397,7 @@ fate-vsynth%-mpng:               CODEC   = png
 
 FATE_VCODEC_SCALE-$(call ENCDEC, MSVIDEO1, AVI) += msvideo1
 
-FATE_VCODEC_SCALE-$(call ENCDEC, PRORES, MOV) += prores prores_int prores_444 prores_444_int prores_ks
+FATE_VCODEC_SCALE-$(call ENCDEC, PRORES, MOV) += prores prores_int prores_444 prores_444_int prores_ks prores_ks_fast
 fate-vsynth%-prores:             FMT     = mov
 
 fate-vsynth%-prores_int:         CODEC   = prores
@@ -369,6 +415,10 @@ fate-vsynth%-prores_444_int:     FMT     = mov
 fate-vsynth%-prores_ks:          ENCOPTS = -profile hq
 fate-vsynth%-prores_ks:          FMT     = mov
 
+fate-vsynth%-prores_ks_fast:     CODEC   = prores_ks
+fate-vsynth%-prores_ks_fast:     ENCOPTS = -profile hq -quality fast
+fate-vsynth%-prores_ks_fast:     FMT     = mov
+
 FATE_VCODEC_SCALE-$(call ENCDEC, QTRLE, MOV) += qtrle qtrlegray
 fate-vsynth%-qtrle:              FMT     = mov
 
@@ -492,7 +542,14 @@ FATE_VCODEC += $(FATE_VCODEC-yes)
 FATE_VCODEC := $(if $(call ENCDEC, RAWVIDEO, RAWVIDEO),$(FATE_VCODEC))
 FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)
-FATE_VSYNTH_LENA = $(FATE_VCODEC:%=fate-vsynth_lena-%)
+# The vsynth_lena references for these still have to be generated from
+# $(SAMPLES)/lena.pnm with "make GEN=1 fate-vsynth_lena-<test>"; drop each
+# from LENA_OFF together with adding tests/ref/vsynth/vsynth_lena-<test>.
+LENA_OFF     = jpeg2000-ht jpeg2000-ht-97 jpeg2000-97-slice jpeg2000-97-pool \
+               mpeg4-mepre-coarse mpeg4-rc-lookahead mpeg4-resync      \
+               prores_ks_fast
+FATE_VCODEC_LENA = $(filter-out $(LENA_OFF),$(FATE_VCODEC))
+FATE_VSYNTH_LENA = $(FATE_VCODEC_LENA:%=fate-vsynth_lena-%)
 # Redundant tests because they just resize the input
 RESIZE_OFF   = dnxhd-720p dnxhd-720p-rd dnxhd-720p-10bit dnxhd-1080i \
                dv dv-411 dv-50 avui snow snow-hpel snow-ll vc2-420p \
@@ -0,0 +1,154 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Decode a stream once per thread count and report the decoding speed.
+ * The decoded pictures are checksummed so that any difference to the
+ * single threaded output is reported as well.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decode_simple.h"
+
+#include "libavutil/adler32.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+
+#include "libavformat/avformat.h"
+
+#include "libavcodec/avcodec.h"
+
+typedef struct PrivData {
+    AVAdler  checksum;
+    uint64_t nb_frames;
+} PrivData;
+
+static int process_frame(DecodeContext *dc, AVFrame *frame)
+{
+    PrivData *pd = dc->opaque;
+    const AVPixFmtDescriptor *desc;
+    int linesizes[4];
+
+    if (!frame)
+        return 0;
+
+    desc = av_pix_fmt_desc_get(frame->format);
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+        return AVERROR(ENOSYS);
+
+    av_image_fill_linesizes(linesizes, frame->format, frame->width);
+    for (int i = 0; i < 4 && frame->data[i]; i++) {
+        int h = frame->height;
+
+        if (i == 1 || i == 2)
+            h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
+        for (int y = 0; y < h; y++)
+            pd->checksum = av_adler32_update(pd->checksum,
+                                             frame->data[i] + y * frame->linesize[i],
+                                             linesizes[i]);
+    }
+    pd->nb_frames++;
+
+    return 0;
+}
+
+static int run(const char *filename, int stream_idx, int thread_type,
+               int threads, int max_frames, PrivData *pd)
+{
+    DecodeContext dc;
+    int ret;
+
+    ret = ds_open(&dc, filename, stream_idx);
+    if (ret < 0) {
+        fprintf(stderr, "Error opening the file\n");
+        return ret;
+    }
+
+    dc.process_frame = process_frame;
+    dc.opaque        = pd;
+    dc.max_frames    = max_frames;
+
+    dc.decoder->thread_count = threads;
+    dc.decoder->thread_type  = thread_type;
+
+    ret = ds_run(&dc);
+    ds_free(&dc);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename;
+    int stream_idx, thread_type, max_threads, max_frames = 0;
+    uint32_t ref_checksum = 0;
+    int ret = 0;
+
+    if (argc < 5) {
+        fprintf(stderr,
+                "Usage: %s <input file> <stream index> <frame|slice> <max threads> [<max frames>]\n",
+                argv[0]);
+        return 0;
+    }
+
+    filename    = argv[1];
+    stream_idx  = strtol(argv[2], NULL, 0);
+    max_threads = strtol(argv[4], NULL, 0);
+    if (argc >= 6)
+        max_frames = strtol(argv[5], NULL, 0);
+
+    if (!strcmp(argv[3], "frame"))
+        thread_type = FF_THREAD_FRAME;
+    else if (!strcmp(argv[3], "slice"))
+        thread_type = FF_THREAD_SLICE;
+    else {
+        fprintf(stderr, "Invalid thread type: %s\n", argv[3]);
+        return 1;
+    }
+
+    for (int threads = 1; threads <= max_threads; threads++) {
+        PrivData pd = { .checksum = 1 };
+        int64_t start, elapsed;
+
+        start   = av_gettime_relative();
+        ret     = run(filename, stream_idx, thread_type, threads, max_frames, &pd);
+        elapsed = av_gettime_relative() - start;
+        if (ret < 0) {
+            fprintf(stderr, "Error decoding with %d threads: %s\n",
+                    threads, av_err2str(ret));
+            return 1;
+        }
+
+        if (threads == 1)
+            ref_checksum = pd.checksum;
+
+        printf("threads %2d: %"PRIu64" frames in %.3f s, %.2f fps%s\n",
+               threads, pd.nb_frames, elapsed / 1000000.0,
+               elapsed ? pd.nb_frames * 1000000.0 / elapsed : 0.0,
+               pd.checksum != ref_checksum ? ", output MISMATCH" : "");
+    }
+
+    return 0;
+}
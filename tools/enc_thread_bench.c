@@ -0,0 +1,367 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Decode a stream once into memory, then encode it once per thread count
+ * and report the encoding speed, also as raw input MB/s in total and per
+ * thread. The encoded packets are checksummed so that any difference to
+ * the single threaded output is reported as well; note that some encoders
+ * (e.g. ffv1 with auto_slices) adapt their bitstream to the thread count.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decode_simple.h"
+
+#include "libavutil/adler32.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/time.h"
+
+#include "libavformat/avformat.h"
+
+#include "libavcodec/avcodec.h"
+
+#include "libswresample/swresample.h"
+#include "libswscale/swscale.h"
+
+typedef struct PrivData {
+    const AVCodec *codec;
+    AVCodecContext *ref;
+
+    SwrContext *swr;
+    SwsContext *sws;
+    AVFrame   **frames;
+    int         nb_frames;
+    int64_t     raw_bytes;
+    int64_t     pts;
+} PrivData;
+
+static int add_frame(PrivData *pd, AVFrame *frame)
+{
+    AVFrame **frames = av_realloc_array(pd->frames, pd->nb_frames + 1,
+                                        sizeof(*pd->frames));
+    int size;
+
+    if (!frames) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+    pd->frames = frames;
+    pd->frames[pd->nb_frames++] = frame;
+
+    if (pd->codec->type == AVMEDIA_TYPE_AUDIO)
+        size = av_samples_get_buffer_size(NULL, frame->ch_layout.nb_channels,
+                                          frame->nb_samples, frame->format, 1);
+    else
+        size = av_image_get_buffer_size(frame->format, frame->width, frame->height, 1);
+    if (size > 0)
+        pd->raw_bytes += size;
+    return 0;
+}
+
+static int setup_encoder(PrivData *pd, const AVFrame *frame)
+{
+    AVCodecContext *enc;
+    const void *fmts;
+    int nb_fmts, ret;
+
+    enc = pd->ref = avcodec_alloc_context3(pd->codec);
+    if (!enc)
+        return AVERROR(ENOMEM);
+
+    if (pd->codec->type == AVMEDIA_TYPE_AUDIO) {
+        ret = avcodec_get_supported_config(NULL, pd->codec, AV_CODEC_CONFIG_SAMPLE_FORMAT,
+                                           0, &fmts, &nb_fmts);
+        if (ret < 0)
+            return ret;
+        enc->sample_fmt  = fmts ? ((const enum AVSampleFormat *)fmts)[0] : frame->format;
+        enc->sample_rate = frame->sample_rate;
+        enc->time_base   = (AVRational){ 1, frame->sample_rate };
+        ret = av_channel_layout_copy(&enc->ch_layout, &frame->ch_layout);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = avcodec_get_supported_config(NULL, pd->codec, AV_CODEC_CONFIG_PIX_FORMAT,
+                                           0, &fmts, &nb_fmts);
+        if (ret < 0)
+            return ret;
+        enc->pix_fmt   = fmts ? ((const enum AVPixelFormat *)fmts)[0] : frame->format;
+        enc->width     = frame->width;
+        enc->height    = frame->height;
+        enc->time_base = (AVRational){ 1, 25 };
+    }
+    enc->flags |= AV_CODEC_FLAG_BITEXACT;
+
+    /* open once to learn the frame size the encoder wants */
+    enc->thread_count = 1;
+    ret = avcodec_open2(enc, pd->codec, NULL);
+    if (ret < 0)
+        return ret;
+
+    if (pd->codec->type == AVMEDIA_TYPE_AUDIO) {
+        ret = swr_alloc_set_opts2(&pd->swr, &enc->ch_layout, enc->sample_fmt, enc->sample_rate,
+                                  &frame->ch_layout, frame->format, frame->sample_rate, 0, NULL);
+        if (ret >= 0)
+            ret = swr_init(pd->swr);
+    }
+
+    return ret;
+}
+
+/* Pull as many encoder sized frames out of the resampler as it can provide;
+ * when flushing, also the remaining partial one if the encoder takes it. */
+static int drain_audio(PrivData *pd, int flush)
+{
+    AVCodecContext *enc = pd->ref;
+    int frame_size = enc->frame_size;
+    int ret;
+
+    if (!frame_size || (pd->codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+        frame_size = 1024;
+
+    while (1) {
+        int avail = swr_get_out_samples(pd->swr, 0);
+        AVFrame *out;
+
+        if (avail < frame_size &&
+            (!flush || avail <= 0 ||
+             !(pd->codec->capabilities & (AV_CODEC_CAP_SMALL_LAST_FRAME |
+                                          AV_CODEC_CAP_VARIABLE_FRAME_SIZE))))
+            return 0;
+
+        out = av_frame_alloc();
+        if (!out)
+            return AVERROR(ENOMEM);
+        out->format      = enc->sample_fmt;
+        out->sample_rate = enc->sample_rate;
+        out->nb_samples  = FFMIN(avail, frame_size);
+        ret = av_channel_layout_copy(&out->ch_layout, &enc->ch_layout);
+        if (ret >= 0)
+            ret = av_frame_get_buffer(out, 0);
+        if (ret >= 0)
+            ret = swr_convert(pd->swr, out->extended_data, out->nb_samples, NULL, 0);
+        if (ret <= 0) {
+            av_frame_free(&out);
+            return ret;
+        }
+        out->nb_samples = ret;
+        out->pts        = pd->pts;
+        pd->pts        += ret;
+
+        ret = add_frame(pd, out);
+        if (ret < 0)
+            return ret;
+    }
+}
+
+static int process_frame(DecodeContext *dc, AVFrame *frame)
+{
+    PrivData *pd = dc->opaque;
+    AVCodecContext *enc;
+    AVFrame *out;
+    int ret;
+
+    /* the encoder is set up from the first decoded frame */
+    if (!pd->ref) {
+        if (!frame)
+            return 0;
+        ret = setup_encoder(pd, frame);
+        if (ret < 0)
+            return ret;
+    }
+    enc = pd->ref;
+
+    if (enc->codec_type == AVMEDIA_TYPE_AUDIO) {
+        if (frame) {
+            ret = swr_convert(pd->swr, NULL, 0, (const uint8_t **)frame->extended_data,
+                              frame->nb_samples);
+            if (ret < 0)
+                return ret;
+        }
+        return drain_audio(pd, !frame);
+    }
+
+    if (!frame)
+        return 0;
+
+    if (!pd->sws) {
+        pd->sws = sws_alloc_context();
+        if (!pd->sws)
+            return AVERROR(ENOMEM);
+    }
+
+    out = av_frame_alloc();
+    if (!out)
+        return AVERROR(ENOMEM);
+    out->format = enc->pix_fmt;
+    out->width  = enc->width;
+    out->height = enc->height;
+    ret = sws_scale_frame(pd->sws, out, frame);
+    if (ret < 0) {
+        av_frame_free(&out);
+        return ret;
+    }
+    out->pts = pd->pts++;
+
+    return add_frame(pd, out);
+}
+
+static int run(PrivData *pd, int threads, uint32_t *checksum, int64_t *bytes)
+{
+    AVCodecContext *enc;
+    AVPacket *pkt;
+    int ret;
+
+    enc = avcodec_alloc_context3(pd->codec);
+    pkt = av_packet_alloc();
+    if (!enc || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    enc->sample_fmt   = pd->ref->sample_fmt;
+    enc->sample_rate  = pd->ref->sample_rate;
+    enc->pix_fmt      = pd->ref->pix_fmt;
+    enc->width        = pd->ref->width;
+    enc->height       = pd->ref->height;
+    enc->time_base    = pd->ref->time_base;
+    enc->flags        = pd->ref->flags;
+    enc->thread_count = threads;
+    ret = av_channel_layout_copy(&enc->ch_layout, &pd->ref->ch_layout);
+    if (ret < 0)
+        goto end;
+
+    ret = avcodec_open2(enc, pd->codec, NULL);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i <= pd->nb_frames; i++) {
+        ret = avcodec_send_frame(enc, i < pd->nb_frames ? pd->frames[i] : NULL);
+        if (ret < 0)
+            goto end;
+
+        while ((ret = avcodec_receive_packet(enc, pkt)) >= 0) {
+            *checksum = av_adler32_update(*checksum, pkt->data, pkt->size);
+            *bytes   += pkt->size;
+            av_packet_unref(pkt);
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = 0;
+
+end:
+    av_packet_free(&pkt);
+    avcodec_free_context(&enc);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    PrivData pd = { 0 };
+    DecodeContext dc;
+    int stream_idx, max_threads, max_frames = 0;
+    uint32_t ref_checksum = 0;
+    int ret;
+
+    if (argc < 5) {
+        fprintf(stderr,
+                "Usage: %s <input file> <stream index> <encoder> <max threads> [<max frames>]\n",
+                argv[0]);
+        return 0;
+    }
+
+    stream_idx  = strtol(argv[2], NULL, 0);
+    max_threads = strtol(argv[4], NULL, 0);
+    if (argc >= 6)
+        max_frames = strtol(argv[5], NULL, 0);
+
+    pd.codec = avcodec_find_encoder_by_name(argv[3]);
+    if (!pd.codec) {
+        fprintf(stderr, "Unknown encoder: %s\n", argv[3]);
+        return 1;
+    }
+
+    ret = ds_open(&dc, argv[1], stream_idx);
+    if (ret < 0) {
+        fprintf(stderr, "Error opening the file\n");
+        return 1;
+    }
+    if (dc.decoder->codec_type != pd.codec->type) {
+        fprintf(stderr, "Stream and encoder media types differ\n");
+        ds_free(&dc);
+        return 1;
+    }
+
+    dc.process_frame = process_frame;
+    dc.opaque        = &pd;
+    dc.max_frames    = max_frames;
+
+    ret = ds_run(&dc);
+    ds_free(&dc);
+    if (ret >= 0 && !pd.ref)
+        ret = AVERROR_INVALIDDATA;
+    if (ret < 0) {
+        fprintf(stderr, "Error preparing the input: %s\n", av_err2str(ret));
+        goto end;
+    }
+
+    for (int threads = 1; threads <= max_threads; threads++) {
+        uint32_t checksum = 1;
+        int64_t start, elapsed, bytes = 0;
+
+        start   = av_gettime_relative();
+        ret     = run(&pd, threads, &checksum, &bytes);
+        elapsed = av_gettime_relative() - start;
+        if (ret < 0) {
+            fprintf(stderr, "Error encoding with %d threads: %s\n",
+                    threads, av_err2str(ret));
+            goto end;
+        }
+
+        if (threads == 1)
+            ref_checksum = checksum;
+
+        printf("threads %2d: %d frames, %"PRId64" bytes in %.3f s, %.2f fps, "
+               "%.2f MB/s, %.2f MB/s per thread%s\n",
+               threads, pd.nb_frames, bytes, elapsed / 1000000.0,
+               elapsed ? pd.nb_frames * 1000000.0 / elapsed : 0.0,
+               elapsed ? (double)pd.raw_bytes / elapsed : 0.0,
+               elapsed ? (double)pd.raw_bytes / elapsed / threads : 0.0,
+               checksum != ref_checksum ? ", output MISMATCH" : "");
+    }
+
+end:
+    for (int i = 0; i < pd.nb_frames; i++)
+        av_frame_free(&pd.frames[i]);
+    av_freep(&pd.frames);
+    swr_free(&pd.swr);
+    sws_free_context(&pd.sws);
+    avcodec_free_context(&pd.ref);
+
+    return ret < 0;
+}